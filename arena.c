@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define ARENA_ALIGNMENT 16 // Enough for any scalar or pointer we store
+
+// Chunk payload starts right after the (padded) header
+#define CHUNK_HEADER_SIZE ((sizeof(ArenaChunk) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+#define CHUNK_DATA(chunk) ((char *)(chunk) + CHUNK_HEADER_SIZE)
+
+// --- Chunk Management ---
+
+static ArenaChunk *arena_new_chunk(Arena *arena, size_t size)
+{
+  ArenaChunk *chunk = malloc(CHUNK_HEADER_SIZE + size);
+  if (chunk == NULL)
+  {
+    fprintf(stderr, "Error: Arena allocation of %lu bytes failed\n", (unsigned long)size);
+    exit(EXIT_FAILURE);
+  }
+  chunk->size = size;
+  chunk->used = 0;
+  arena->bytes_reserved += CHUNK_HEADER_SIZE + size;
+  arena->chunks++;
+  return chunk;
+}
+
+// --- Public API ---
+
+void arena_init(Arena *arena, size_t chunk_size)
+{
+  memset(arena, 0, sizeof(*arena));
+  arena->chunk_size = chunk_size ? chunk_size : ARENA_DEFAULT_CHUNK_SIZE;
+}
+
+// Bump-allocates size bytes. Memory is only released by arena_destroy.
+void *arena_alloc(Arena *arena, size_t size)
+{
+  size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+  ArenaChunk *chunk = arena->head;
+
+  if (chunk == NULL || chunk->size - chunk->used < size)
+  {
+    if (size > arena->chunk_size / 4)
+    {
+      // Oversized request: give it a dedicated chunk behind the current one,
+      // so the partially used head chunk keeps serving small allocations
+      ArenaChunk *own = arena_new_chunk(arena, size);
+      own->used = size;
+      if (chunk != NULL)
+      {
+        own->next = chunk->next;
+        chunk->next = own;
+      }
+      else
+      {
+        own->next = NULL;
+        arena->head = own;
+      }
+      arena->allocations++;
+      arena->bytes_allocated += size;
+      return CHUNK_DATA(own);
+    }
+    chunk = arena_new_chunk(arena, arena->chunk_size);
+    chunk->next = arena->head;
+    arena->head = chunk;
+  }
+
+  void *result = CHUNK_DATA(chunk) + chunk->used;
+  chunk->used += size;
+  arena->allocations++;
+  arena->bytes_allocated += size;
+  return result;
+}
+
+void *arena_calloc(Arena *arena, size_t count, size_t size)
+{
+  void *result = arena_alloc(arena, count * size);
+  memset(result, 0, count * size);
+  return result;
+}
+
+// Returns a block of new_size bytes holding the first old_size bytes of old.
+// Grows in place when old is the most recent allocation of the head chunk.
+void *arena_grow(Arena *arena, void *old, size_t old_size, size_t new_size)
+{
+  ArenaChunk *chunk = arena->head;
+  size_t old_rounded = (old_size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+  size_t new_rounded = (new_size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+  if (old != NULL && chunk != NULL && (char *)old + old_rounded == CHUNK_DATA(chunk) + chunk->used &&
+      chunk->used - old_rounded + new_rounded <= chunk->size)
+  {
+    chunk->used = chunk->used - old_rounded + new_rounded;
+    arena->bytes_allocated += new_rounded - old_rounded;
+    return old;
+  }
+
+  void *result = arena_alloc(arena, new_size);
+  if (old != NULL)
+  {
+    memcpy(result, old, old_size);
+  }
+  return result;
+}
+
+// Copies text[0, length) into the arena as a NUL-terminated string
+char *arena_strndup(Arena *arena, const char *text, size_t length)
+{
+  char *copy = arena_alloc(arena, length + 1);
+  memcpy(copy, text, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+void arena_print_stats(const Arena *arena, const char *name)
+{
+  printf("%s arena: %lu allocations, %lu bytes allocated, %lu bytes reserved in %lu chunks\n", name,
+         (unsigned long)arena->allocations, (unsigned long)arena->bytes_allocated,
+         (unsigned long)arena->bytes_reserved, (unsigned long)arena->chunks);
+}
+
+// Releases every chunk at once: O(chunks), independent of how many objects were allocated
+void arena_destroy(Arena *arena)
+{
+  ArenaChunk *chunk = arena->head;
+  while (chunk != NULL)
+  {
+    ArenaChunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  arena->head = NULL;
+}
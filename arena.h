@@ -0,0 +1,33 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stddef.h>
+
+#define ARENA_DEFAULT_CHUNK_SIZE (64 * 1024)
+
+typedef struct ArenaChunk
+{
+  struct ArenaChunk *next; // Previously filled chunk
+  size_t size;             // Usable bytes in data
+  size_t used;
+} ArenaChunk;
+
+typedef struct
+{
+  ArenaChunk *head;       // Chunk currently being bumped
+  size_t chunk_size;      // Size of regular chunks; larger requests get a chunk of their own
+  size_t allocations;     // Number of arena_alloc calls served
+  size_t bytes_allocated; // Bytes handed out (including alignment padding)
+  size_t bytes_reserved;  // Bytes obtained from malloc for chunks
+  size_t chunks;
+} Arena;
+
+void arena_init(Arena *arena, size_t chunk_size);
+void *arena_alloc(Arena *arena, size_t size);
+void *arena_calloc(Arena *arena, size_t count, size_t size);
+void *arena_grow(Arena *arena, void *old, size_t old_size, size_t new_size);
+char *arena_strndup(Arena *arena, const char *text, size_t length);
+void arena_print_stats(const Arena *arena, const char *name);
+void arena_destroy(Arena *arena);
+
+#endif
@@ -0,0 +1,89 @@
+#include <string.h>
+
+#include "bitset.h"
+
+#define WORDS_FOR(bits) (((bits) + 63) / 64)
+
+// Allocates an empty set able to hold bits [0, bits)
+Bitset bitset_new(Arena *arena, uint32_t bits) {
+    Bitset set;
+    set.word_count = WORDS_FOR(bits);
+    set.words = arena_calloc(arena, set.word_count ? set.word_count : 1, sizeof(uint64_t));
+    return set;
+}
+
+// Allocates count empty sets of the same size backed by one allocation
+Bitset *bitset_array(Arena *arena, uint32_t count, uint32_t bits) {
+    Bitset *sets = arena_alloc(arena, (count ? count : 1) * sizeof(Bitset));
+    uint32_t word_count = WORDS_FOR(bits);
+    uint64_t *words = arena_calloc(arena, (size_t)count * word_count + 1, sizeof(uint64_t));
+    for (uint32_t i = 0; i < count; i++) {
+        sets[i].words = words + (size_t)i * word_count;
+        sets[i].word_count = word_count;
+    }
+    return sets;
+}
+
+void bitset_clear(Bitset *set) {
+    memset(set->words, 0, set->word_count * sizeof(uint64_t));
+}
+
+void bitset_copy(Bitset *dst, const Bitset *src) {
+    memcpy(dst->words, src->words, src->word_count * sizeof(uint64_t));
+}
+
+// dst |= src. Returns 1 if dst changed.
+int bitset_union(Bitset *dst, const Bitset *src) {
+    uint64_t changed = 0;
+    for (uint32_t i = 0; i < dst->word_count; i++) {
+        uint64_t merged = dst->words[i] | src->words[i];
+        changed |= merged ^ dst->words[i];
+        dst->words[i] = merged;
+    }
+    return changed != 0;
+}
+
+// result = gen | (input & ~kill), the gen/kill transfer function. Returns 1 if result changed.
+int bitset_transfer(Bitset *result, const Bitset *gen, const Bitset *input, const Bitset *kill) {
+    uint64_t changed = 0;
+    for (uint32_t i = 0; i < result->word_count; i++) {
+        uint64_t value = gen->words[i] | (input->words[i] & ~kill->words[i]);
+        changed |= value ^ result->words[i];
+        result->words[i] = value;
+    }
+    return changed != 0;
+}
+
+// Index of the lowest set bit of a non-zero word, by halving (no compiler builtins needed)
+static uint32_t lowest_bit(uint64_t bits) {
+    uint32_t index = 0;
+    if ((bits & 0xffffffffu) == 0) { index += 32; bits >>= 32; }
+    if ((bits & 0xffffu) == 0) { index += 16; bits >>= 16; }
+    if ((bits & 0xffu) == 0) { index += 8; bits >>= 8; }
+    if ((bits & 0xfu) == 0) { index += 4; bits >>= 4; }
+    if ((bits & 0x3u) == 0) { index += 2; bits >>= 2; }
+    if ((bits & 0x1u) == 0) { index += 1; }
+    return index;
+}
+
+// First set bit at or after from, or BITSET_END
+uint32_t bitset_next(const Bitset *set, uint32_t from) {
+    uint32_t word = from >> 6;
+    if (word >= set->word_count) return BITSET_END;
+    uint64_t bits = set->words[word] & (~(uint64_t)0 << (from & 63));
+    while (bits == 0) {
+        if (++word >= set->word_count) return BITSET_END;
+        bits = set->words[word];
+    }
+    return word * 64 + lowest_bit(bits);
+}
+
+uint32_t bitset_count(const Bitset *set) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < set->word_count; i++) {
+        for (uint64_t bits = set->words[i]; bits != 0; bits &= bits - 1) {
+            count++;
+        }
+    }
+    return count;
+}
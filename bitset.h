@@ -0,0 +1,36 @@
+#ifndef BITSET_H_
+#define BITSET_H_
+
+#include <stdint.h>
+#include "arena.h"
+
+// Fixed-size dense bitset over [0, bits), stored in 64-bit words
+typedef struct {
+    uint64_t *words;
+    uint32_t word_count;
+} Bitset;
+
+#define BITSET_END ((uint32_t)UINT32_MAX)
+
+static inline void bitset_set(Bitset *set, uint32_t bit) {
+    set->words[bit >> 6] |= (uint64_t)1 << (bit & 63);
+}
+
+static inline void bitset_reset(Bitset *set, uint32_t bit) {
+    set->words[bit >> 6] &= ~((uint64_t)1 << (bit & 63));
+}
+
+static inline int bitset_test(const Bitset *set, uint32_t bit) {
+    return (int)((set->words[bit >> 6] >> (bit & 63)) & 1);
+}
+
+Bitset bitset_new(Arena *arena, uint32_t bits);
+Bitset *bitset_array(Arena *arena, uint32_t count, uint32_t bits);
+void bitset_clear(Bitset *set);
+void bitset_copy(Bitset *dst, const Bitset *src);
+int bitset_union(Bitset *dst, const Bitset *src);
+int bitset_transfer(Bitset *result, const Bitset *gen, const Bitset *input, const Bitset *kill);
+uint32_t bitset_next(const Bitset *set, uint32_t from);
+uint32_t bitset_count(const Bitset *set);
+
+#endif
@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg.h"
+
+// --- Predecessors ---
+
+// Rebuilds IrBlock.preds from the terminators. Predecessors are listed in block order.
+// Passes that change edges call this (before SSA) or patch preds and phi arguments together.
+void cfg_compute_predecessors(IrFunction *fn) {
+    uint32_t *counts = arena_calloc(fn->arena, fn->block_count + 1, sizeof(uint32_t));
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        uint32_t succs[2];
+        uint32_t count = ir_successors(&fn->blocks[b], succs);
+        for (uint32_t i = 0; i < count; i++) counts[succs[i]]++;
+    }
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        fn->blocks[b].preds = counts[b] ? arena_alloc(fn->arena, counts[b] * sizeof(uint32_t)) : NULL;
+        fn->blocks[b].pred_count = 0;
+    }
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        uint32_t succs[2];
+        uint32_t count = ir_successors(&fn->blocks[b], succs);
+        for (uint32_t i = 0; i < count; i++) {
+            IrBlock *succ = &fn->blocks[succs[i]];
+            succ->preds[succ->pred_count++] = b;
+        }
+    }
+}
+
+// --- Orders ---
+
+// Depth-first search from the entry, recording blocks in reverse postorder
+static void compute_rpo(Cfg *cfg, Arena *arena) {
+    const IrFunction *fn = cfg->fn;
+    uint32_t n = cfg->block_count;
+    uint32_t *stack = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    uint8_t *next_succ = arena_calloc(arena, n + 1, sizeof(uint8_t)); // Successors already visited
+    uint8_t *seen = arena_calloc(arena, n + 1, sizeof(uint8_t));
+    uint32_t *postorder = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    uint32_t post_count = 0;
+
+    uint32_t depth = 0;
+    if (n > 0) {
+        stack[depth++] = 0;
+        seen[0] = 1;
+    }
+    while (depth > 0) {
+        uint32_t b = stack[depth - 1];
+        uint32_t succs[2];
+        uint32_t count = ir_successors(&fn->blocks[b], succs);
+        if (next_succ[b] < count) {
+            uint32_t succ = succs[next_succ[b]++];
+            if (!seen[succ]) {
+                seen[succ] = 1;
+                stack[depth++] = succ;
+            }
+            continue;
+        }
+        postorder[post_count++] = b;
+        depth--;
+    }
+
+    cfg->rpo = arena_alloc(arena, (post_count + 1) * sizeof(uint32_t));
+    cfg->rpo_count = post_count;
+    cfg->rpo_index = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    for (uint32_t b = 0; b < n; b++) cfg->rpo_index[b] = NO_BLOCK;
+    for (uint32_t i = 0; i < post_count; i++) {
+        uint32_t b = postorder[post_count - 1 - i];
+        cfg->rpo[i] = b;
+        cfg->rpo_index[b] = i;
+    }
+}
+
+// --- Dominators ---
+
+// Walks both fingers up the partially built tree until they meet (Cooper, Harvey, Kennedy)
+static uint32_t intersect(const Cfg *cfg, uint32_t a, uint32_t b) {
+    while (a != b) {
+        while (cfg->rpo_index[a] > cfg->rpo_index[b]) a = cfg->idom[a];
+        while (cfg->rpo_index[b] > cfg->rpo_index[a]) b = cfg->idom[b];
+    }
+    return a;
+}
+
+// Iterates idom[b] = intersection of the processed predecessors in reverse postorder.
+// Converges in two or three sweeps on the reducible graphs structured code produces.
+static void compute_dominators(Cfg *cfg, Arena *arena) {
+    const IrFunction *fn = cfg->fn;
+    uint32_t n = cfg->block_count;
+    cfg->idom = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    for (uint32_t b = 0; b < n; b++) cfg->idom[b] = NO_BLOCK;
+    if (cfg->rpo_count == 0) return;
+    cfg->idom[cfg->rpo[0]] = cfg->rpo[0];
+
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (uint32_t i = 1; i < cfg->rpo_count; i++) {
+            uint32_t b = cfg->rpo[i];
+            const IrBlock *block = &fn->blocks[b];
+            uint32_t new_idom = NO_BLOCK;
+            for (uint32_t p = 0; p < block->pred_count; p++) {
+                uint32_t pred = block->preds[p];
+                if (cfg->idom[pred] == NO_BLOCK) continue; // Unreachable or not processed yet
+                new_idom = new_idom == NO_BLOCK ? pred : intersect(cfg, pred, new_idom);
+            }
+            if (new_idom != cfg->idom[b]) {
+                cfg->idom[b] = new_idom;
+                changed = 1;
+            }
+        }
+    }
+}
+
+// Builds the dominator tree's child lists and numbers it for constant-time dominance queries
+static void compute_dominator_tree(Cfg *cfg, Arena *arena) {
+    uint32_t n = cfg->block_count;
+    cfg->dom_child_start = arena_calloc(arena, n + 2, sizeof(uint32_t));
+    cfg->dom_children = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    cfg->dom_pre = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    cfg->dom_post = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    cfg->dom_depth = arena_calloc(arena, n + 1, sizeof(uint32_t));
+    if (cfg->rpo_count == 0) return;
+    uint32_t entry = cfg->rpo[0];
+
+    // Counting sort of the reachable blocks by immediate dominator; children stay in RPO
+    for (uint32_t i = 1; i < cfg->rpo_count; i++) cfg->dom_child_start[cfg->idom[cfg->rpo[i]] + 1]++;
+    for (uint32_t b = 0; b < n; b++) cfg->dom_child_start[b + 1] += cfg->dom_child_start[b];
+    uint32_t *fill = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    memcpy(fill, cfg->dom_child_start, n * sizeof(uint32_t));
+    for (uint32_t i = 1; i < cfg->rpo_count; i++) {
+        uint32_t b = cfg->rpo[i];
+        cfg->dom_children[fill[cfg->idom[b]]++] = b;
+    }
+
+    // Iterative DFS over the tree
+    uint32_t *stack = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    uint32_t *next_child = fill; // Reused: next child index to visit
+    memcpy(next_child, cfg->dom_child_start, n * sizeof(uint32_t));
+    uint32_t pre = 0, post = 0, depth = 0;
+    stack[depth++] = entry;
+    cfg->dom_pre[entry] = pre++;
+    while (depth > 0) {
+        uint32_t b = stack[depth - 1];
+        if (next_child[b] < cfg->dom_child_start[b + 1]) {
+            uint32_t child = cfg->dom_children[next_child[b]++];
+            cfg->dom_pre[child] = pre++;
+            cfg->dom_depth[child] = cfg->dom_depth[b] + 1;
+            stack[depth++] = child;
+            continue;
+        }
+        cfg->dom_post[b] = post++;
+        depth--;
+    }
+}
+
+// --- Dominance Frontiers ---
+
+// Computes the dominance frontier of every reachable block into cfg->df_start/df. For each join,
+// runners walk up from its predecessors to its immediate dominator and add the join to the
+// frontier of every block they pass (Cooper, Harvey, Kennedy).
+void cfg_compute_frontiers(Cfg *cfg, Arena *arena) {
+    const IrFunction *fn = cfg->fn;
+    uint32_t n = cfg->block_count;
+    uint32_t *newest = arena_calloc(arena, n + 1, sizeof(uint32_t)); // Join + 1 last added to each frontier
+    uint32_t *counts = arena_calloc(arena, n + 1, sizeof(uint32_t));
+    uint32_t *pairs = NULL; // (block, join) pairs in discovery order
+    uint32_t pair_count = 0, pair_capacity = 0;
+
+    for (uint32_t i = 0; i < cfg->rpo_count; i++) {
+        uint32_t b = cfg->rpo[i];
+        const IrBlock *block = &fn->blocks[b];
+        if (block->pred_count < 2) continue;
+        for (uint32_t p = 0; p < block->pred_count; p++) {
+            uint32_t runner = block->preds[p];
+            if (!cfg_reachable(cfg, runner)) continue;
+            for (; runner != cfg->idom[b] && newest[runner] != b + 1; runner = cfg->idom[runner]) {
+                if (pair_count == pair_capacity) {
+                    uint32_t capacity = pair_capacity ? pair_capacity * 2 : 64;
+                    pairs = arena_grow(arena, pairs, pair_capacity * 2 * sizeof(uint32_t), capacity * 2 * sizeof(uint32_t));
+                    pair_capacity = capacity;
+                }
+                newest[runner] = b + 1;
+                counts[runner]++;
+                pairs[2 * pair_count] = runner;
+                pairs[2 * pair_count + 1] = b;
+                pair_count++;
+            }
+        }
+    }
+
+    cfg->df_start = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    cfg->df_start[0] = 0;
+    for (uint32_t b = 0; b < n; b++) cfg->df_start[b + 1] = cfg->df_start[b] + counts[b];
+    cfg->df = arena_alloc(arena, (pair_count + 1) * sizeof(uint32_t));
+    uint32_t *fill = counts; // Reused as the write cursor of each frontier
+    memcpy(fill, cfg->df_start, n * sizeof(uint32_t));
+    for (uint32_t i = 0; i < pair_count; i++) cfg->df[fill[pairs[2 * i]]++] = pairs[2 * i + 1];
+}
+
+// --- Loops ---
+
+// Finds the natural loops and how they nest. An edge t -> h is a back edge when h dominates t;
+// the loop of h is everything that reaches t without going through h, found by walking
+// predecessors back from t. Back edges to the same header share one loop. Headers are visited
+// in reverse postorder, so an enclosing loop is always found before the loops inside it and
+// the innermost loop already recorded for a new header is its parent.
+void cfg_compute_loops(Cfg *cfg, Arena *arena) {
+    const IrFunction *fn = cfg->fn;
+    uint32_t n = cfg->block_count;
+    cfg->loop_depth = arena_calloc(arena, n + 1, sizeof(uint32_t));
+    cfg->innermost_loop = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    for (uint32_t b = 0; b < n; b++) cfg->innermost_loop[b] = NO_LOOP;
+    cfg->loops = NULL;
+    cfg->loop_count = 0;
+    uint32_t loop_capacity = 0;
+    uint32_t *in_loop_of = arena_calloc(arena, n + 1, sizeof(uint32_t)); // Header + 1 of the loop being collected
+    uint32_t *stack = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < cfg->rpo_count; i++) {
+        uint32_t header = cfg->rpo[i];
+        const IrBlock *block = &fn->blocks[header];
+        uint32_t loop = NO_LOOP;
+        uint32_t depth = 0;
+        for (uint32_t p = 0; p < block->pred_count; p++) {
+            uint32_t tail = block->preds[p];
+            if (!cfg_dominates(cfg, header, tail)) continue;
+            if (loop == NO_LOOP) {
+                if (cfg->loop_count == loop_capacity) {
+                    uint32_t capacity = loop_capacity ? loop_capacity * 2 : 8;
+                    cfg->loops = arena_grow(arena, cfg->loops, loop_capacity * sizeof(Loop), capacity * sizeof(Loop));
+                    loop_capacity = capacity;
+                }
+                loop = cfg->loop_count++;
+                Loop *info = &cfg->loops[loop];
+                info->header = header;
+                info->parent = cfg->innermost_loop[header];
+                info->depth = info->parent == NO_LOOP ? 1 : cfg->loops[info->parent].depth + 1;
+                info->block_count = 0;
+                in_loop_of[header] = header + 1;
+                cfg->innermost_loop[header] = loop;
+            }
+            if (in_loop_of[tail] != header + 1) {
+                in_loop_of[tail] = header + 1;
+                cfg->innermost_loop[tail] = loop;
+                stack[depth++] = tail;
+            }
+            while (depth > 0) {
+                const IrBlock *member = &fn->blocks[stack[--depth]];
+                for (uint32_t q = 0; q < member->pred_count; q++) {
+                    uint32_t pred = member->preds[q];
+                    if (in_loop_of[pred] == header + 1 || !cfg_reachable(cfg, pred)) continue;
+                    in_loop_of[pred] = header + 1;
+                    cfg->innermost_loop[pred] = loop;
+                    stack[depth++] = pred;
+                }
+            }
+        }
+    }
+
+    // Member lists in reverse postorder: each block is added to every loop around it
+    for (uint32_t b = 0; b < n; b++) {
+        uint32_t loop = cfg->innermost_loop[b];
+        if (loop == NO_LOOP) continue;
+        cfg->loop_depth[b] = cfg->loops[loop].depth;
+        for (; loop != NO_LOOP; loop = cfg->loops[loop].parent) cfg->loops[loop].block_count++;
+    }
+    uint32_t total = 0;
+    for (uint32_t l = 0; l < cfg->loop_count; l++) {
+        cfg->loops[l].block_start = total;
+        total += cfg->loops[l].block_count;
+        cfg->loops[l].block_count = 0;
+    }
+    cfg->loop_blocks = arena_alloc(arena, (total + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < cfg->rpo_count; i++) {
+        uint32_t b = cfg->rpo[i];
+        for (uint32_t loop = cfg->innermost_loop[b]; loop != NO_LOOP; loop = cfg->loops[loop].parent) {
+            Loop *info = &cfg->loops[loop];
+            cfg->loop_blocks[info->block_start + info->block_count++] = b;
+        }
+    }
+}
+
+// True if block b is inside loop (or one of the loops nested in it)
+int cfg_in_loop(const Cfg *cfg, uint32_t loop, uint32_t b) {
+    uint32_t inner = cfg->innermost_loop[b];
+    while (inner != NO_LOOP && cfg->loops[inner].depth > cfg->loops[loop].depth) inner = cfg->loops[inner].parent;
+    return inner == loop;
+}
+
+// --- Public API ---
+
+// Analyzes fn's current control flow. fn->blocks[*].preds must be up to date.
+Cfg *cfg_build(const IrFunction *fn, Arena *arena) {
+    Cfg *cfg = arena_calloc(arena, 1, sizeof(Cfg));
+    cfg->fn = fn;
+    cfg->block_count = fn->block_count;
+    compute_rpo(cfg, arena);
+    compute_dominators(cfg, arena);
+    compute_dominator_tree(cfg, arena);
+    return cfg;
+}
+
+int cfg_reachable(const Cfg *cfg, uint32_t block) {
+    return cfg->rpo_index[block] != NO_BLOCK;
+}
+
+// True if every path from the entry to b goes through a (a block dominates itself)
+int cfg_dominates(const Cfg *cfg, uint32_t a, uint32_t b) {
+    if (!cfg_reachable(cfg, a) || !cfg_reachable(cfg, b)) return 0;
+    return cfg->dom_pre[a] <= cfg->dom_pre[b] && cfg->dom_post[b] <= cfg->dom_post[a];
+}
+
+void cfg_dump(const Cfg *cfg, FILE *file) {
+    const IrFunction *fn = cfg->fn;
+    fprintf(file, "=== CFG: %u blocks, %u reachable ===\n", (unsigned)cfg->block_count, (unsigned)cfg->rpo_count);
+    for (uint32_t i = 0; i < cfg->rpo_count; i++) {
+        uint32_t b = cfg->rpo[i];
+        const IrBlock *block = &fn->blocks[b];
+        fprintf(file, "b%u: preds [", (unsigned)b);
+        for (uint32_t p = 0; p < block->pred_count; p++) fprintf(file, p ? " b%u" : "b%u", (unsigned)block->preds[p]);
+        fprintf(file, "] succs [");
+        uint32_t succs[2];
+        uint32_t count = ir_successors(block, succs);
+        for (uint32_t s = 0; s < count; s++) fprintf(file, s ? " b%u" : "b%u", (unsigned)succs[s]);
+        fprintf(file, "] idom b%u depth %u\n", (unsigned)cfg->idom[b], (unsigned)cfg->dom_depth[b]);
+    }
+    for (uint32_t l = 0; l < cfg->loop_count; l++) {
+        const Loop *loop = &cfg->loops[l];
+        fprintf(file, "loop %u: header b%u depth %u", (unsigned)l, (unsigned)loop->header, (unsigned)loop->depth);
+        if (loop->parent != NO_LOOP) fprintf(file, " in loop %u", (unsigned)loop->parent);
+        fprintf(file, ", blocks [");
+        for (uint32_t i = 0; i < loop->block_count; i++) {
+            fprintf(file, i ? " b%u" : "b%u", (unsigned)cfg->loop_blocks[loop->block_start + i]);
+        }
+        fprintf(file, "]\n");
+    }
+    fprintf(file, "\n");
+}
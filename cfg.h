@@ -0,0 +1,53 @@
+#ifndef CFG_H_
+#define CFG_H_
+
+#include <stdio.h>
+#include "ir.h"
+#include "arena.h"
+
+#define NO_LOOP ((uint32_t)UINT32_MAX)
+
+// A natural loop. Loops are numbered outermost first; a loop's blocks (its header, its body
+// and every loop nested in it) are listed in reverse postorder.
+typedef struct {
+    uint32_t header;
+    uint32_t parent;      // Innermost enclosing loop, NO_LOOP for an outermost loop
+    uint32_t depth;       // 1 for an outermost loop
+    uint32_t block_start; // Blocks: loop_blocks[block_start .. block_start + block_count)
+    uint32_t block_count;
+} Loop;
+
+// Control-flow analysis of an IrFunction: traversal orders, the dominator tree and the loop nest.
+// Successors come from the block terminators and predecessors from IrBlock.preds.
+// Blocks unreachable from the entry have no order position and no dominator.
+typedef struct {
+    const IrFunction *fn;
+    uint32_t block_count;
+    uint32_t *rpo;            // Reachable blocks in reverse postorder (rpo[0] is the entry)
+    uint32_t rpo_count;
+    uint32_t *rpo_index;      // Block -> position in rpo, NO_BLOCK if unreachable
+    uint32_t *idom;           // Block -> immediate dominator (the entry is its own), NO_BLOCK if unreachable
+    uint32_t *dom_child_start; // Dominator tree children of b: dom_children[dom_child_start[b] .. dom_child_start[b + 1])
+    uint32_t *dom_children;
+    uint32_t *dom_pre;        // Preorder/postorder numbers in the dominator tree, for O(1) dominance tests
+    uint32_t *dom_post;
+    uint32_t *dom_depth;      // Depth in the dominator tree (entry = 0)
+    uint32_t *df_start;       // Dominance frontier of b: df[df_start[b] .. df_start[b + 1]), NULL until computed
+    uint32_t *df;
+    Loop *loops;              // Loop nest, NULL until computed
+    uint32_t loop_count;
+    uint32_t *loop_blocks;
+    uint32_t *innermost_loop; // Block -> innermost loop containing it, NO_LOOP if none
+    uint32_t *loop_depth;     // Number of natural loops containing b (0 outside loops)
+} Cfg;
+
+void cfg_compute_predecessors(IrFunction *fn);
+Cfg *cfg_build(const IrFunction *fn, Arena *arena);
+void cfg_compute_frontiers(Cfg *cfg, Arena *arena);
+void cfg_compute_loops(Cfg *cfg, Arena *arena);
+int cfg_dominates(const Cfg *cfg, uint32_t a, uint32_t b);
+int cfg_reachable(const Cfg *cfg, uint32_t block);
+int cfg_in_loop(const Cfg *cfg, uint32_t loop, uint32_t b);
+void cfg_dump(const Cfg *cfg, FILE *file);
+
+#endif
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "closedform.h"
+#include "cfg.h"
+#include "scev.h"
+
+static IrFunction *fn = NULL;
+static const Cfg *cfg = NULL;
+static uint32_t *def_block = NULL; // vreg -> block defining it, NO_BLOCK if none
+static VReg *exit_values = NULL;   // Loop values used after the loop
+static uint32_t exit_count = 0;
+
+// True if running the loop is only computing values: nothing is printed, no variable slot is
+// touched and the program cannot end inside it
+static int is_pure(const Loop *info) {
+    for (uint32_t j = 0; j < info->block_count; j++) {
+        const IrBlock *block = &fn->blocks[cfg->loop_blocks[info->block_start + j]];
+        if (block->term.kind != TERM_JUMP && block->term.kind != TERM_BRANCH) return 0;
+        for (uint32_t i = 0; i < block->count; i++) {
+            uint8_t op = block->insts[i].op;
+            if (op == IR_WRITE || op == IR_LOAD || op == IR_STORE) return 0;
+        }
+    }
+    return 1;
+}
+
+static void note_use(uint32_t loop, Operand operand, uint8_t *noted) {
+    if (operand.kind != OPND_REG || noted[operand.value]) return;
+    uint32_t b = def_block[operand.value];
+    if (b == NO_BLOCK || !cfg_in_loop(cfg, loop, b)) return;
+    noted[operand.value] = 1;
+    exit_values[exit_count++] = (VReg)operand.value;
+}
+
+// Collects the vregs defined in the loop and used outside it
+static void collect_exit_values(uint32_t loop) {
+    uint8_t *noted = arena_calloc(fn->arena, fn->vreg_count, 1);
+    exit_count = 0;
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        if (!cfg_reachable(cfg, b) || cfg_in_loop(cfg, loop, b)) continue;
+        const IrBlock *block = &fn->blocks[b];
+        for (uint32_t i = 0; i < block->count; i++) {
+            const IrInst *inst = &block->insts[i];
+            if (inst->op == IR_PHI) {
+                for (uint32_t k = 0; k < inst->arg_count; k++) note_use(loop, inst->args[k], noted);
+            } else {
+                note_use(loop, inst->a, noted);
+                note_use(loop, inst->b, noted);
+            }
+        }
+        note_use(loop, block->term.a, noted);
+        note_use(loop, block->term.b, noted);
+    }
+}
+
+// Replaces the loop by the values it leaves with, each one its recurrence in the last iteration
+// (computed mod 2^32 like the loop would). The vregs keep their names, now defined in the
+// preheader, which jumps to the exit block in place of the latch. Returns 0 if the loop stays.
+static int eliminate_loop(const Scev *scev) {
+    const Loop *info = &cfg->loops[scev->loop];
+    uint32_t succs[2];
+    if (scev->trip_count == 0 || scev->preheader == NO_BLOCK || !is_pure(info)) return 0;
+    if (ir_successors(&fn->blocks[scev->preheader], succs) != 1) return 0;
+    collect_exit_values(scev->loop);
+    for (uint32_t i = 0; i < exit_count; i++) {
+        if (scev->values[exit_values[i]].order == SCEV_UNKNOWN) return 0;
+    }
+
+    for (uint32_t i = 0; i < exit_count; i++) {
+        const Recurrence *value = &scev->values[exit_values[i]];
+        int32_t last = scev_evaluate(value, scev->trip_count - 1);
+        int offset = value->base != NO_VREG && last != 0;
+        IrInst *def = ir_append(fn, scev->preheader, offset ? IR_ADD : IR_COPY);
+        def->dst = exit_values[i];
+        def->a = value->base != NO_VREG ? ir_reg(value->base) : ir_imm(last);
+        if (offset) def->b = ir_imm(last);
+    }
+
+    uint32_t exit = fn->blocks[scev->latch].term.target[scev->exit_slot];
+    IrBlock *target = &fn->blocks[exit];
+    for (uint32_t k = 0; k < target->pred_count; k++) {
+        if (target->preds[k] == scev->latch) target->preds[k] = scev->preheader;
+    }
+    ir_set_jump(fn, scev->preheader, exit);
+    return 1;
+}
+
+// The loop's initial values and the constants licm hoisted for it may now be unused. Deletes
+// unused copies, arithmetic and phis until none is left (each round can free the operands of
+// the last).
+static void remove_dead_values(void) {
+    uint32_t *uses = arena_alloc(fn->arena, fn->vreg_count * sizeof(uint32_t));
+    for (int changed = 1; changed;) {
+        changed = 0;
+        memset(uses, 0, fn->vreg_count * sizeof(uint32_t));
+        for (uint32_t b = 0; b < fn->block_count; b++) {
+            const IrBlock *block = &fn->blocks[b];
+            for (uint32_t i = 0; i < block->count; i++) {
+                const IrInst *inst = &block->insts[i];
+                if (inst->op == IR_PHI) {
+                    for (uint32_t k = 0; k < inst->arg_count; k++) {
+                        if (inst->args[k].kind == OPND_REG && (VReg)inst->args[k].value != inst->dst) uses[inst->args[k].value]++;
+                    }
+                    continue;
+                }
+                if (inst->a.kind == OPND_REG) uses[inst->a.value]++;
+                if (inst->b.kind == OPND_REG) uses[inst->b.value]++;
+            }
+            if (block->term.a.kind == OPND_REG) uses[block->term.a.value]++;
+            if (block->term.b.kind == OPND_REG) uses[block->term.b.value]++;
+        }
+        for (uint32_t b = 0; b < fn->block_count; b++) {
+            IrBlock *block = &fn->blocks[b];
+            uint32_t kept = 0;
+            for (uint32_t i = 0; i < block->count; i++) {
+                const IrInst *inst = &block->insts[i];
+                int pure = inst->op == IR_COPY || inst->op == IR_PHI || ir_is_binary((IrOp)inst->op);
+                if (pure && uses[inst->dst] == 0) {
+                    changed = 1;
+                    continue;
+                }
+                block->insts[kept++] = *inst;
+            }
+            block->count = kept;
+        }
+    }
+}
+
+// --- Pass ---
+
+// Runs on SSA form after licm, which gives every loop its preheader. Loops are tried innermost
+// first; removing an inner loop can leave the loop around it pure and countable as well, so the
+// analyses are redone after every loop removed.
+void closed_form_eliminate_loops(IrFunction *function, const CompilerOptions *options) {
+    fn = function;
+    Arena *arena = fn->arena;
+    int eliminated = 0;
+    for (int changed = 1; changed;) {
+        changed = 0;
+        Cfg *loops = cfg_build(fn, arena);
+        cfg_compute_loops(loops, arena);
+        cfg = loops;
+        def_block = arena_alloc(arena, fn->vreg_count * sizeof(uint32_t));
+        for (VReg v = 0; v < fn->vreg_count; v++) def_block[v] = NO_BLOCK;
+        for (uint32_t b = 0; b < fn->block_count; b++) {
+            const IrBlock *block = &fn->blocks[b];
+            for (uint32_t i = 0; i < block->count; i++) {
+                if (block->insts[i].dst != NO_VREG) def_block[block->insts[i].dst] = b;
+            }
+        }
+        exit_values = arena_alloc(arena, fn->vreg_count * sizeof(VReg));
+
+        for (uint32_t l = loops->loop_count; l-- > 0 && !changed;) {
+            changed = eliminate_loop(scev_analyze(fn, loops, l, arena));
+        }
+        if (changed) remove_unreachable_blocks(fn, options);
+        eliminated |= changed;
+    }
+    if (eliminated) remove_dead_values();
+    fn = NULL;
+    cfg = NULL;
+    def_block = NULL;
+    exit_values = NULL;
+}
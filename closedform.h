@@ -0,0 +1,13 @@
+#ifndef CLOSEDFORM_H_
+#define CLOSEDFORM_H_
+
+#include "ir.h"
+#include "pipeline.h"
+
+// Closed-form loop elimination over SSA form. A loop with no effects besides computing values
+// (no writes, no exit) and a known trip count is deleted when scalar evolution can say what
+// every value it leaves with is; the preheader computes those values directly.
+
+void closed_form_eliminate_loops(IrFunction *fn, const CompilerOptions *options);
+
+#endif
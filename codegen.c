@@ -5,424 +5,549 @@
 
 #include "lexer.h"
 #include "parser.h"
-#include "./hashmap/hashmap.h" 
+#include "intern.h"
+#include "arena.h"
+#include "emit.h"
+#include "target.h"
 
-#define INITIAL_HASHMAP_SIZE 100
-#define FRAME_POINTER "s0" // Use s0 as frame pointer (fp alias often used)
-#define WORD_SIZE 4        // RV32
+#define FRAME_POINTER REG_S0 // Use s0 as frame pointer (fp alias often used)
+#define WORD_SIZE 4          // RV32
 
 // --- Global State ---
 int label_count = 0;
-struct hashmap_s variable_map;
+int *variable_offsets = NULL; // SymbolId -> frame offset of the variable, 0 if undeclared
+int *pinned_offsets = NULL;   // NodeId -> frame offset a WHILE condition's variable had at the loop entry, 0 if none
 int current_stack_offset = 0;
+const Ast *tree = NULL;       // Tree being compiled; nodes are looked up by index
+const Target *target = NULL;  // Core the code is for: decides how * / % by constants are done
 
 // --- Helper Functions ---
 
-void generate_label(char *buffer, size_t len) {
-    snprintf(buffer, len, "L%d", label_count++);
+int generate_label(void) {
+    return label_count++;
 }
 
 // Push a register onto the runtime stack (RV32)
-void emit_push(const char *reg, FILE *file) {
-    fprintf(file, "  addi sp, sp, -%d\n", WORD_SIZE);
-    fprintf(file, "  sw %s, 0(sp)\n", reg);
+void emit_push(Reg reg, Emitter *out) {
+    emit_rri(out, MN_ADDI, REG_SP, REG_SP, -WORD_SIZE);
+    emit_mem(out, MN_SW, reg, 0, REG_SP);
 }
 
 // Pop from the runtime stack into a register (RV32)
-void emit_pop(const char *reg, FILE *file) {
-    fprintf(file, "  lw %s, 0(sp)\n", reg);
-    fprintf(file, "  addi sp, sp, %d\n", WORD_SIZE);
+void emit_pop(Reg reg, Emitter *out) {
+    emit_mem(out, MN_LW, reg, 0, REG_SP);
+    emit_rri(out, MN_ADDI, REG_SP, REG_SP, WORD_SIZE);
+}
+
+// "  # <what>: <name><suffix>" for the per-variable comments
+static void emit_variable_comment(Emitter *out, const char *what, SymbolId variable, const char *suffix) {
+    emit_text(out, "  # ", 4);
+    emit_cstr(out, what);
+    emit_text(out, symbol_name(variable), symbol_length(variable));
+    emit_cstr(out, suffix);
 }
 
 // --- Forward Declaration ---
-// *** Changed generate_expression to return the register holding the result ***
-// *** (or indicate value is immediate, though not fully implemented here) ***
-// *** For now, it still primarily uses a0, but avoids stack for simple cases ***
-void generate_expression(Node *node, FILE *file); 
-void generate_statement(Node *node, FILE *file);
+void generate_expression(NodeId id, Emitter *out);
+void generate_statement(NodeId id, Emitter *out);
+
+// --- Expressions ---
+// Expressions are evaluated into a stack of registers, Sethi-Ullman style: every subtree is
+// labeled with the number of registers it needs, the operand needing more is evaluated first
+// (into the lower register) so the other can use what is left, and when both operands need
+// every remaining register the first result is pushed on the stack and reloaded into a1.
+// a1 also holds the immediate operand of MUL/DIV/REM and the comparisons.
+
+static const Reg expression_registers[] = { REG_A0, REG_T0, REG_T1, REG_T2, REG_T3, REG_T4, REG_T5, REG_T6 };
+#define EXPRESSION_REGISTER_COUNT ((int)(sizeof(expression_registers) / sizeof(expression_registers[0])))
+
+uint8_t *register_need = NULL; // NodeId -> registers the subtree needs, 0 until computed
 
-// Generate code for an expression (leaves result primarily in a0)
-// Tries to use immediate instructions where possible.
-void generate_expression(Node *node, FILE *file) {
-    if (!node) return;
+static int fits_imm12(long value) {
+    return value >= -2048 && value <= 2047;
+}
+
+// True if the node is an operator whose right operand is folded into an immediate: always for
+// the forms that load it into a1, and only within 12 bits for the I-type instructions
+static int has_immediate_operand(const Node *node) {
+    const Node *right = ast_node(tree, node->child2);
+    if (right->type != INT) return 0;
+    long imm = right->as.value;
+    switch (node->kind) {
+        case OP_ADD:
+        case CMP_LESS:
+        case CMP_GREATER_EQ: return fits_imm12(imm);
+        case OP_SUB: return fits_imm12(-imm);
+        case CMP_LESS_EQ: return fits_imm12(imm + 1);
+        default: return 1;
+    }
+}
+
+// Sethi-Ullman label of an expression: 1 for a leaf; for an operator the larger of its
+// operands' needs, or one more if they are equal (both results must be held at once)
+int expression_need(NodeId id) {
+    if (register_need[id] != 0) return register_need[id];
+    const Node *node = ast_node(tree, id);
+    int need = 1;
+    if (node->type == OPERATOR || node->type == COMP) {
+        int left = expression_need(node->child1);
+        if (has_immediate_operand(node)) {
+            need = left;
+        } else {
+            int right = expression_need(node->child2);
+            need = left == right ? left + 1 : (left > right ? left : right);
+        }
+    }
+    register_need[id] = (uint8_t)(need > UINT8_MAX ? UINT8_MAX : need);
+    return need;
+}
+
+void generate_value(NodeId id, int base, Emitter *out);
+
+// Evaluates both operands of a binary node, leaving the result in expression_registers[base]
+// free to overwrite. Returns the registers holding the left and right values.
+void generate_operands(const Node *node, int base, Reg *lhs, Reg *rhs, Emitter *out) {
+    int available = EXPRESSION_REGISTER_COUNT - base;
+    int left_need = expression_need(node->child1);
+    int right_need = expression_need(node->child2);
+    Reg target = expression_registers[base];
+
+    if (left_need >= available && right_need >= available) {
+        // Neither side fits next to the other's result: spill the left one
+        generate_value(node->child1, base, out);
+        emit_push(target, out);
+        generate_value(node->child2, base, out);
+        emit_pop(REG_A1, out);
+        *lhs = REG_A1;
+        *rhs = target;
+    } else if (left_need >= right_need) {
+        generate_value(node->child1, base, out);
+        generate_value(node->child2, base + 1, out);
+        *lhs = target;
+        *rhs = expression_registers[base + 1];
+    } else {
+        generate_value(node->child2, base, out);
+        generate_value(node->child1, base + 1, out);
+        *lhs = expression_registers[base + 1];
+        *rhs = target;
+    }
+}
+
+// Generate code for an expression, leaving its value in expression_registers[base] and using
+// only the registers above it. Tries to use immediate instructions where possible.
+void generate_value(NodeId id, int base, Emitter *out) {
+    if (id == NIL_NODE) return;
+    const Node *node = ast_node(tree, id);
+    Reg rd = expression_registers[base];
 
     switch (node->type) {
         case INT:
-            // Load immediate value into a0
-            fprintf(file, "  li a0, %s\n", node->value);
+            // Load immediate value
+            emit_ri(out, MN_LI, rd, node->as.value);
             break;
 
         case IDENTIFIER: {
-            // Load variable from stack into a0
-            int *offset_ptr = (int *)hashmap_get(&variable_map, node->value, strlen(node->value));
-            if (!offset_ptr) {
-                fprintf(stderr, "CodeGen Error: Undefined variable '%s'\n", node->value);
+            // Load variable from stack
+            int offset = pinned_offsets[id] ? pinned_offsets[id] : variable_offsets[node->as.symbol];
+            if (offset == 0) {
+                fprintf(stderr, "CodeGen Error: Undefined variable '%s'\n", symbol_name(node->as.symbol));
                 exit(EXIT_FAILURE);
             }
-            fprintf(file, "  lw a0, %d(%s)\n", *offset_ptr, FRAME_POINTER);
+            emit_mem(out, MN_LW, rd, offset, FRAME_POINTER);
             break;
         }
 
         case OPERATOR:
         case COMP: { // Handle arithmetic and comparison operators
-            if (node->child2->type == INT) {
-                // Evaluate left operand into a0
-                generate_expression(node->child1, file);
+            if (has_immediate_operand(node)) {
+                // Evaluate left operand into rd
+                generate_value(node->child1, base, out);
                 // Perform operation with immediate value
-                const char* imm_val = node->child2->value;
-                if (strcmp(node->value, "+") == 0) fprintf(file, "  addi a0, a0, %s\n", imm_val);
-                else if (strcmp(node->value, "-") == 0) {
-                    // RISC-V doesn't have subi, so add negative immediate
-                    // Need to handle potential negation overflow, but basic version:
-                    long val = -atol(imm_val); // Calculate negative value
-                    fprintf(file, "  addi a0, a0, %ld\n", val);
-                }
-                else if (strcmp(node->value, "*") == 0) { // No muli, need to load immediate
-                    fprintf(file, "  li a1, %s\n", imm_val);
-                    fprintf(file, "  mul a0, a0, a1\n");
-                }
-                 else if (strcmp(node->value, "/") == 0) { // No divi
-                    fprintf(file, "  li a1, %s\n", imm_val);
-                    fprintf(file, "  div a0, a0, a1\n");
-                 }
-                 else if (strcmp(node->value, "%") == 0) { // No remi
-                    fprintf(file, "  li a1, %s\n", imm_val);
-                    fprintf(file, "  rem a0, a0, a1\n");
-                 }
-                 // Comparisons with immediate
-                 else if (strcmp(node->value, "==") == 0) { fprintf(file, "  li a1, %s\n", imm_val); fprintf(file, "  sub a0, a0, a1\n"); fprintf(file, "  seqz a0, a0\n"); } // Set if == 0
-                 else if (strcmp(node->value, "!=") == 0) { fprintf(file, "  li a1, %s\n", imm_val); fprintf(file, "  sub a0, a0, a1\n"); fprintf(file, "  snez a0, a0\n"); } // set if != 0
-                 else if (strcmp(node->value, "<") == 0)  { fprintf(file, "  slti a0, a0, %s\n", imm_val); } // Set if less than immediate
-                 else if (strcmp(node->value, "<=") == 0) { // a <= imm -> !(a > imm) -> !(sgti a, imm)
-                     // sgti doesn't exist directly, simulate with slti + swap or sltiu?
-                     // Simpler: a <= imm  <=> a < imm+1
-                     long val_plus_1 = atol(imm_val) + 1;
-                     fprintf(file, "  slti a0, a0, %ld\n", val_plus_1);
-                 }
-                 else if (strcmp(node->value, ">") == 0)  { // a > imm -> slti imm, a
-                      fprintf(file, "  li a1, %s\n", imm_val);
-                      fprintf(file, "  slt a0, a1, a0\n"); // Set if a1 < a0
-                 }
-                 else if (strcmp(node->value, ">=") == 0) { // a >= imm -> ! (a < imm)
-                      fprintf(file, "  slti a0, a0, %s\n", imm_val); // a0 = (a < imm)
-                      fprintf(file, "  xori a0, a0, 1\n");          // a0 = !(a < imm)
-                 }
-                 else {
-                    fprintf(stderr, "CodeGen Error: Unsupported operator '%s' with immediate\n", node->value);
-                    exit(EXIT_FAILURE);
+                long imm_val = ast_node(tree, node->child2)->as.value;
+                switch (node->kind) {
+                    case OP_ADD: emit_rri(out, MN_ADDI, rd, rd, imm_val); break;
+                    case OP_SUB: {
+                        // RISC-V doesn't have subi, so add negative immediate
+                        // Need to handle potential negation overflow, but basic version:
+                        long val = -imm_val; // Calculate negative value
+                        emit_rri(out, MN_ADDI, rd, rd, val);
+                        break;
+                    }
+                    case OP_MUL: // No muli: shifts and adds, or load the immediate
+                        if (target_emit_multiply_imm(out, target, rd, rd, (int32_t)imm_val, REG_A1, REG_A2)) break;
+                        target_require_mul(target, "Multiplication");
+                        emit_ri(out, MN_LI, REG_A1, imm_val);
+                        emit_rrr(out, MN_MUL, rd, rd, REG_A1);
+                        break;
+                    case OP_DIV: // No divi: shifts or a multiply-high by a magic number
+                        if (target_emit_divide_imm(out, target, rd, rd, (int32_t)imm_val, REG_A1, REG_A2)) break;
+                        target_require_mul(target, "Division");
+                        emit_ri(out, MN_LI, REG_A1, imm_val);
+                        emit_rrr(out, MN_DIV, rd, rd, REG_A1);
+                        break;
+                    case OP_MOD: // No remi: same as division
+                        if (target_emit_remainder_imm(out, target, rd, rd, (int32_t)imm_val, REG_A1, REG_A2)) break;
+                        target_require_mul(target, "Remainder");
+                        emit_ri(out, MN_LI, REG_A1, imm_val);
+                        emit_rrr(out, MN_REM, rd, rd, REG_A1);
+                        break;
+                    // Comparisons with immediate
+                    case CMP_EQ: // Set if == 0
+                        emit_ri(out, MN_LI, REG_A1, imm_val);
+                        emit_rrr(out, MN_SUB, rd, rd, REG_A1);
+                        emit_rr(out, MN_SEQZ, rd, rd);
+                        break;
+                    case CMP_NEQ: // set if != 0
+                        emit_ri(out, MN_LI, REG_A1, imm_val);
+                        emit_rrr(out, MN_SUB, rd, rd, REG_A1);
+                        emit_rr(out, MN_SNEZ, rd, rd);
+                        break;
+                    case CMP_LESS: emit_rri(out, MN_SLTI, rd, rd, imm_val); break; // Set if less than immediate
+                    case CMP_LESS_EQ: { // a <= imm -> !(a > imm) -> !(sgti a, imm)
+                        // sgti doesn't exist directly, simulate with slti + swap or sltiu?
+                        // Simpler: a <= imm  <=> a < imm+1
+                        long val_plus_1 = imm_val + 1;
+                        emit_rri(out, MN_SLTI, rd, rd, val_plus_1);
+                        break;
+                    }
+                    case CMP_GREATER: // a > imm -> slti imm, a
+                        emit_ri(out, MN_LI, REG_A1, imm_val);
+                        emit_rrr(out, MN_SLT, rd, REG_A1, rd); // Set if a1 < rd
+                        break;
+                    case CMP_GREATER_EQ: // a >= imm -> ! (a < imm)
+                        emit_rri(out, MN_SLTI, rd, rd, imm_val); // rd = (a < imm)
+                        emit_rri(out, MN_XORI, rd, rd, 1);       // rd = !(a < imm)
+                        break;
+                    default:
+                        fprintf(stderr, "CodeGen Error: Unsupported operator '%s' with immediate\n", token_kind_name(node->kind));
+                        exit(EXIT_FAILURE);
                 }
             } else {
-                // Right operand is not immediate - use registers (t0, t1)
-                // Evaluate left operand into t0
-                generate_expression(node->child1, file);
-                fprintf(file, "  mv t0, a0\n"); // Move result to t0
-
-                // Evaluate right operand into t1
-                generate_expression(node->child2, file);
-                fprintf(file, "  mv t1, a0\n"); // Move result to t1
-
-                // Perform operation (t0 op t1) -> result in a0
-                if (strcmp(node->value, "+") == 0) fprintf(file, "  add a0, t0, t1\n");
-                else if (strcmp(node->value, "-") == 0) fprintf(file, "  sub a0, t0, t1\n");
-                else if (strcmp(node->value, "*") == 0) fprintf(file, "  mul a0, t0, t1\n");
-                else if (strcmp(node->value, "/") == 0) fprintf(file, "  div a0, t0, t1\n");
-                else if (strcmp(node->value, "%") == 0) fprintf(file, "  rem a0, t0, t1\n");
-                // Comparisons (register vs register)
-                else if (strcmp(node->value, "==") == 0) { fprintf(file, "  sub a0, t0, t1\n"); fprintf(file, "  seqz a0, a0\n"); }
-                else if (strcmp(node->value, "!=") == 0) { fprintf(file, "  sub a0, t0, t1\n"); fprintf(file, "  snez a0, a0\n"); }
-                else if (strcmp(node->value, "<") == 0)  { fprintf(file, "  slt a0, t0, t1\n"); }
-                else if (strcmp(node->value, "<=") == 0) { fprintf(file, "  sgt a0, t0, t1\n"); fprintf(file, "  xori a0, a0, 1\n");} // !(t0 > t1)
-                else if (strcmp(node->value, ">") == 0)  { fprintf(file, "  sgt a0, t0, t1\n"); }
-                else if (strcmp(node->value, ">=") == 0) { fprintf(file, "  slt a0, t0, t1\n"); fprintf(file, "  xori a0, a0, 1\n");} // !(t0 < t1)
-                else {
-                    fprintf(stderr, "CodeGen Error: Unsupported operator '%s'\n", node->value);
-                    exit(EXIT_FAILURE);
+                // Right operand is not immediate - evaluate both into registers
+                Reg lhs, rhs;
+                generate_operands(node, base, &lhs, &rhs, out);
+
+                // Perform operation (lhs op rhs) -> result in rd
+                switch (node->kind) {
+                    case OP_ADD: emit_rrr(out, MN_ADD, rd, lhs, rhs); break;
+                    case OP_SUB: emit_rrr(out, MN_SUB, rd, lhs, rhs); break;
+                    case OP_MUL:
+                        target_require_mul(target, "Multiplication");
+                        emit_rrr(out, MN_MUL, rd, lhs, rhs);
+                        break;
+                    case OP_DIV:
+                        target_require_mul(target, "Division");
+                        emit_rrr(out, MN_DIV, rd, lhs, rhs);
+                        break;
+                    case OP_MOD:
+                        target_require_mul(target, "Remainder");
+                        emit_rrr(out, MN_REM, rd, lhs, rhs);
+                        break;
+                    // Comparisons (register vs register)
+                    case CMP_EQ:
+                        emit_rrr(out, MN_SUB, rd, lhs, rhs);
+                        emit_rr(out, MN_SEQZ, rd, rd);
+                        break;
+                    case CMP_NEQ:
+                        emit_rrr(out, MN_SUB, rd, lhs, rhs);
+                        emit_rr(out, MN_SNEZ, rd, rd);
+                        break;
+                    case CMP_LESS: emit_rrr(out, MN_SLT, rd, lhs, rhs); break;
+                    case CMP_LESS_EQ: // !(lhs > rhs)
+                        emit_rrr(out, MN_SGT, rd, lhs, rhs);
+                        emit_rri(out, MN_XORI, rd, rd, 1);
+                        break;
+                    case CMP_GREATER: emit_rrr(out, MN_SGT, rd, lhs, rhs); break;
+                    case CMP_GREATER_EQ: // !(lhs < rhs)
+                        emit_rrr(out, MN_SLT, rd, lhs, rhs);
+                        emit_rri(out, MN_XORI, rd, rd, 1);
+                        break;
+                    default:
+                        fprintf(stderr, "CodeGen Error: Unsupported operator '%s'\n", token_kind_name(node->kind));
+                        exit(EXIT_FAILURE);
                 }
             }
             break; // End OPERATOR/COMP case
         } // End OPERATOR/COMP block
 
         default:
-             fprintf(stderr, "CodeGen Error: Unexpected node type in expression: %d (%s)\n", node->type, node->value ? node->value : "N/A");
+             fprintf(stderr, "CodeGen Error: Unexpected node type in expression: %d (%s)\n", node->type, token_kind_name(node->kind));
     }
 }
 
-// Generate code for a statement or block
-void generate_statement(Node *node, FILE *file) {
-    if (!node) return;
+// Generate code for an expression, leaving the result in a0
+void generate_expression(NodeId id, Emitter *out) {
+    generate_value(id, 0, out);
+}
 
-    char label1[20], label2[20]; // Buffers for label names
+// Emit a branch to label taken when the condition's truth value is expected (0 or 1); shared
+// by IF (branching away when false) and WHILE (also looping back while true)
+void generate_branch_if(NodeId id, int expected, int label, Emitter *out) {
+    const Node *condition = ast_node(tree, id);
+    if (condition->type == COMP) {
+        Mnemonic branch;
+        switch (condition->kind) {
+            case CMP_EQ: branch = expected ? MN_BEQ : MN_BNE; break;
+            case CMP_NEQ: branch = expected ? MN_BNE : MN_BEQ; break;
+            case CMP_LESS: branch = expected ? MN_BLT : MN_BGE; break;
+            case CMP_LESS_EQ: branch = expected ? MN_BLE : MN_BGT; break;
+            case CMP_GREATER: branch = expected ? MN_BGT : MN_BLE; break;
+            case CMP_GREATER_EQ: branch = expected ? MN_BGE : MN_BLT; break;
+            default: fprintf(stderr, "Unsupported comparison: %s\n", token_kind_name(condition->kind)); exit(1);
+        }
 
-    if (node->type == BEGINNING && strcmp(node->value, "PROGRAM") == 0) {
-         generate_statement(node->child1, file);
-         return;
+        if (has_immediate_operand(condition)) {
+            // Evaluate left operand of comparison -> a0 and compare it with the constant: branches
+            // have no immediate form, so it goes in a1 unless it is zero
+            generate_expression(condition->child1, out);
+            int32_t value = ast_node(tree, condition->child2)->as.value;
+            Reg rhs = REG_ZERO;
+            if (value != 0) {
+                emit_ri(out, MN_LI, REG_A1, value);
+                rhs = REG_A1;
+            }
+            emit_branch(out, branch, REG_A0, rhs, label);
+        } else {
+            // Evaluate both operands into registers and compare them
+            Reg lhs, rhs;
+            generate_operands(condition, 0, &lhs, &rhs, out);
+            emit_branch(out, branch, lhs, rhs, label);
+        }
+    } else {
+        // Fallback: Condition is not a simple comparison
+        generate_expression(id, out); // Result (0/1) in a0
+        emit_branch_zero(out, expected ? MN_BNEZ : MN_BEQZ, REG_A0, label);
     }
+}
 
-    switch (node->type) {
-        case KEYWORD:
-            if (strcmp(node->value, "EXIT") == 0) {
-                generate_expression(node->child1, file); // Result in a0
-                fprintf(file, "  li a7, 93\n");
-                fprintf(file, "  ecall\n");
-            }
-            else if (strcmp(node->value, "DECLARE_INT") == 0) {
-                Node* identifier_node = node->child1;
-                Node* value_expression = node->child2;
-
-                // Allocate space on stack
-                current_stack_offset -= WORD_SIZE;
-                int* offset_copy = malloc(sizeof(int));
-                if (!offset_copy) {perror("malloc failed"); exit(EXIT_FAILURE); }
-                *offset_copy = current_stack_offset;
-
-                // Store variable info
-                if (hashmap_put(&variable_map, identifier_node->value, strlen(identifier_node->value), offset_copy) != 0) {
-                     fprintf(stderr, "CodeGen Error: Failed to insert variable '%s'\n", identifier_node->value);
-                     free(offset_copy);
-                     exit(EXIT_FAILURE);
-                 }
-                 fprintf(file, "  # Variable Declaration: %s at %d(%s)\n", identifier_node->value, current_stack_offset, FRAME_POINTER);
-
-                // Evaluate initial value
-                generate_expression(value_expression, file); // Result in a0
-
-                // Store initial value
-                fprintf(file, "  sw a0, %d(%s)\n", current_stack_offset, FRAME_POINTER);
+// Binds the variables of a WHILE condition to the declarations visible at the loop entry. The
+// condition is tested again after the body, which may declare new variables of the same names.
+static void pin_condition_variables(NodeId id) {
+    const Node *node = ast_node(tree, id);
+    if (node->type == IDENTIFIER) {
+        pinned_offsets[id] = variable_offsets[node->as.symbol];
+    } else if (node->type == OPERATOR || node->type == COMP) {
+        pin_condition_variables(node->child1);
+        pin_condition_variables(node->child2);
+    }
+}
+
+// Generate code for a statement or block
+void generate_statement(NodeId id, Emitter *out) {
+    if (id == NIL_NODE) return;
+    const Node *node = ast_node(tree, id);
+
+    int label1, label2; // Label numbers
+
+    switch (node->kind) {
+        case NODE_PROGRAM:
+            generate_statement(node->child1, out);
+            break;
+
+        case KW_EXIT:
+            generate_expression(node->child1, out); // Result in a0
+            emit_ri(out, MN_LI, REG_A7, 93);
+            emit_bare(out, MN_ECALL);
+            break;
+
+        case NODE_DECLARE_INT: {
+            SymbolId variable = ast_node(tree, node->child1)->as.symbol;
+            NodeId value_expression = node->child2;
+
+            // Allocate space on stack and record it under the variable's symbol
+            current_stack_offset -= WORD_SIZE;
+            variable_offsets[variable] = current_stack_offset;
+            emit_variable_comment(out, "Variable Declaration: ", variable, " at ");
+            emit_int(out, current_stack_offset);
+            emit_text(out, "(", 1);
+            emit_cstr(out, reg_name(FRAME_POINTER));
+            emit_text(out, ")\n", 2);
+
+            // Evaluate initial value
+            generate_expression(value_expression, out); // Result in a0
+
+            // Store initial value
+            emit_mem(out, MN_SW, REG_A0, current_stack_offset, FRAME_POINTER);
+            break;
+        }
+
+        case KW_IF:
+            label1 = generate_label(); // else/end label
+            label2 = generate_label(); // end label (if else exists)
+
+            emit_comment(out, "IF Statement");
+            generate_branch_if(node->child1, 0, label1, out);
+
+            // Generate 'then' block code
+            emit_comment(out, "THEN Block");
+            generate_statement(node->child2, out);
+
+            // Jump past 'else' block if it exists
+            if (node->as.else_branch != NIL_NODE) {
+                emit_jump(out, label2);
             }
-            else if (strcmp(node->value, "IF") == 0) {
-                 generate_label(label1, sizeof(label1)); // else/end label
-                 generate_label(label2, sizeof(label2)); // end label (if else exists)
-
-                 fprintf(file, "  # IF Statement\n");
-
-                 Node* condition = node->child1;
-                 if (condition->type == COMP) {
-                      // Evaluate left operand of comparison -> a0
-                      generate_expression(condition->child1, file);
-                      // Evaluate right operand of comparison -> a1 (or use immediate)
-                      if(condition->child2->type == INT) {
-                          // Compare a0 with immediate
-                          const char* imm_val = condition->child2->value;
-                          if (strcmp(condition->value, "==") == 0) fprintf(file, "  bne a0, %s, %s\n", imm_val, label1); // Branch if NOT equal
-                          else if (strcmp(condition->value, "!=") == 0) fprintf(file, "  beq a0, %s, %s\n", imm_val, label1); // Branch if equal
-                          else if (strcmp(condition->value, "<") == 0)  fprintf(file, "  bge a0, %s, %s\n", imm_val, label1); // Branch if NOT less (>=)
-                          else if (strcmp(condition->value, "<=") == 0) fprintf(file, "  bgt a0, %s, %s\n", imm_val, label1); // Branch if greater
-                          else if (strcmp(condition->value, ">") == 0)  fprintf(file, "  ble a0, %s, %s\n", imm_val, label1); // Branch if NOT greater (<=)
-                          else if (strcmp(condition->value, ">=") == 0) fprintf(file, "  blt a0, %s, %s\n", imm_val, label1); // Branch if less
-                          else { fprintf(stderr, "Unsupported comparison: %s\n", condition->value); exit(1); }
-                      } else {
-                          // Compare a0 with register a1
-                          fprintf(file, "  mv t0, a0\n"); // Save left result
-                          generate_expression(condition->child2, file); // Right result -> a0
-                          fprintf(file, "  mv t1, a0\n"); // Move right result to t1
-                          // Now compare t0 and t1
-                          if (strcmp(condition->value, "==") == 0) fprintf(file, "  bne t0, t1, %s\n", label1);
-                          else if (strcmp(condition->value, "!=") == 0) fprintf(file, "  beq t0, t1, %s\n", label1);
-                          else if (strcmp(condition->value, "<") == 0)  fprintf(file, "  bge t0, t1, %s\n", label1);
-                          else if (strcmp(condition->value, "<=") == 0) fprintf(file, "  bgt t0, t1, %s\n", label1);
-                          else if (strcmp(condition->value, ">") == 0)  fprintf(file, "  ble t0, t1, %s\n", label1);
-                          else if (strcmp(condition->value, ">=") == 0) fprintf(file, "  blt t0, t1, %s\n", label1);
-                          else { fprintf(stderr, "Unsupported comparison: %s\n", condition->value); exit(1); }
-                      }
-                 } else {
-                      // Fallback: Condition is not a simple comparison
-                      generate_expression(condition, file); // Result (0/1) in a0
-                      fprintf(file, "  beqz a0, %s\n", label1); // Branch if false (0)
-                 }
-
-                 // Generate 'then' block code
-                 fprintf(file, "  # THEN Block\n");
-                 generate_statement(node->child2, file);
-
-                 // Jump past 'else' block if it exists
-                 if (node->child3) {
-                     fprintf(file, "  j %s\n", label2);
-                 }
-
-                 // Else/End label
-                 fprintf(file, "%s:\n", label1);
-
-                 // Generate 'else' block code
-                 if (node->child3) {
-                      fprintf(file, "  # ELSE Block\n");
-                      generate_statement(node->child3, file);
-                      fprintf(file, "%s:\n", label2); // End label after else
-                 }
-                 fprintf(file, "  # END IF\n");
+
+            // Else/End label
+            emit_label(out, label1);
+
+            // Generate 'else' block code
+            if (node->as.else_branch != NIL_NODE) {
+                emit_comment(out, "ELSE Block");
+                generate_statement(node->as.else_branch, out);
+                emit_label(out, label2); // End label after else
             }
-            else if (strcmp(node->value, "WHILE") == 0) {
-                generate_label(label1, sizeof(label1)); // loop_start (condition check)
-                generate_label(label2, sizeof(label2)); // loop_end
-
-                fprintf(file, "  # WHILE Loop\n");
-                fprintf(file, "%s:\n", label1); // Loop start label
-
-                 Node* condition = node->child1;
-                 if (condition->type == COMP) {
-                      // Evaluate left operand of comparison -> a0
-                      generate_expression(condition->child1, file);
-                      // Evaluate right operand of comparison -> a1 (or use immediate)
-                      if(condition->child2->type == INT) {
-                          // Compare a0 with immediate
-                          const char* imm_val = condition->child2->value;
-                          // Branch to loop END (label2) if condition is FALSE
-                          if (strcmp(condition->value, "==") == 0) fprintf(file, "  bne a0, %s, %s\n", imm_val, label2); // Branch if NOT equal
-                          else if (strcmp(condition->value, "!=") == 0) fprintf(file, "  beq a0, %s, %s\n", imm_val, label2); // Branch if equal
-                          else if (strcmp(condition->value, "<") == 0)  fprintf(file, "  bge a0, %s, %s\n", imm_val, label2); // Branch if NOT less (>=)
-                          else if (strcmp(condition->value, "<=") == 0) fprintf(file, "  bgt a0, %s, %s\n", imm_val, label2); // Branch if greater
-                          else if (strcmp(condition->value, ">") == 0)  fprintf(file, "  ble a0, %s, %s\n", imm_val, label2); // Branch if NOT greater (<=)
-                          else if (strcmp(condition->value, ">=") == 0) fprintf(file, "  blt a0, %s, %s\n", imm_val, label2); // Branch if less
-                          else { fprintf(stderr, "Unsupported comparison: %s\n", condition->value); exit(1); }
-                      } else {
-                          // Compare a0 with register a1
-                          fprintf(file, "  mv t0, a0\n"); // Save left result
-                          generate_expression(condition->child2, file); // Right result -> a0
-                          fprintf(file, "  mv t1, a0\n"); // Move right result to t1
-                          // Now compare t0 and t1, branch to END (label2) if FALSE
-                          if (strcmp(condition->value, "==") == 0) fprintf(file, "  bne t0, t1, %s\n", label2);
-                          else if (strcmp(condition->value, "!=") == 0) fprintf(file, "  beq t0, t1, %s\n", label2);
-                          else if (strcmp(condition->value, "<") == 0)  fprintf(file, "  bge t0, t1, %s\n", label2);
-                          else if (strcmp(condition->value, "<=") == 0) fprintf(file, "  bgt t0, t1, %s\n", label2);
-                          else if (strcmp(condition->value, ">") == 0)  fprintf(file, "  ble t0, t1, %s\n", label2);
-                          else if (strcmp(condition->value, ">=") == 0) fprintf(file, "  blt t0, t1, %s\n", label2);
-                          else { fprintf(stderr, "Unsupported comparison: %s\n", condition->value); exit(1); }
-                      }
-                 } else {
-                    // Fallback: Condition is not a simple comparison
-                    generate_expression(condition, file); // Result (0/1) in a0
-                    fprintf(file, "  beqz a0, %s\n", label2); // Branch to end if false (0)
-                 }
-
-                // Generate loop body code
-                fprintf(file, "  # WHILE Body\n");
-                generate_statement(node->child2, file);
-
-                // Jump back to the condition check
-                fprintf(file, "  j %s\n", label1);
-
-                // Loop end label
-                fprintf(file, "%s:\n", label2);
-                fprintf(file, "  # END WHILE\n");
+            emit_comment(out, "END IF");
+            break;
+
+        case KW_WHILE:
+            label1 = generate_label(); // loop body
+            label2 = generate_label(); // loop_end
+
+            // Rotated into a guarded do-while: the condition is tested once before the loop and
+            // again at the bottom, so each iteration takes one conditional branch and no jump
+            emit_comment(out, "WHILE Loop");
+            generate_branch_if(node->child1, 0, label2, out);
+            pin_condition_variables(node->child1);
+
+            // Generate loop body code
+            emit_label(out, label1);
+            emit_comment(out, "WHILE Body");
+            generate_statement(node->child2, out);
+
+            // Loop back while the condition still holds
+            emit_comment(out, "WHILE Test");
+            generate_branch_if(node->child1, 1, label1, out);
+
+            // Loop end label
+            emit_label(out, label2);
+            emit_comment(out, "END WHILE");
+            break;
+
+        case KW_WRITE:
+            // Evaluate the expression to print
+            generate_expression(node->child2, out); // Result in a0
+            // Use printf (adjust if using direct syscall)
+            emit_comment(out, "WRITE using printf");
+            emit_rr(out, MN_MV, REG_A1, REG_A0);
+            emit_la(out, REG_A0, "fmt");
+            emit_symbol(out, MN_CALL, "printf");
+            break;
+
+        case NODE_ASSIGN: {
+            SymbolId variable = ast_node(tree, node->child1)->as.symbol;
+            NodeId value_expression = node->child2;
+
+            // Evaluate the value expression
+            generate_expression(value_expression, out); // Result in a0
+
+            // Look up the variable's offset
+            int offset = variable_offsets[variable];
+            if (offset == 0) {
+                fprintf(stderr, "CodeGen Error: Assignment to undeclared variable '%s'\n", symbol_name(variable));
+                exit(EXIT_FAILURE);
             }
-            else if (strcmp(node->value, "WRITE") == 0) {
-                 // Evaluate the expression to print
-                 generate_expression(node->child2, file); // Result in a0
-                 // Use printf (adjust if using direct syscall)
-                 fprintf(file, "  # WRITE using printf\n");
-                 fprintf(file, "  mv a1, a0\n");
-                 fprintf(file, "  la a0, fmt\n");
-                 fprintf(file, "  call printf\n");
-             }
-            break; // End KEYWORD case
+            emit_variable_comment(out, "Assignment: ", variable, " = ...\n");
+            // Store the result
+            emit_mem(out, MN_SW, REG_A0, offset, FRAME_POINTER);
+            break;
+        }
 
-        case OPERATOR:
-             if (strcmp(node->value, "ASSIGN") == 0) {
-                Node* identifier_node = node->child1;
-                Node* value_expression = node->child2;
-
-                // Evaluate the value expression
-                generate_expression(value_expression, file); // Result in a0
-
-                // Look up the variable's offset
-                int* offset_ptr = (int*)hashmap_get(&variable_map, identifier_node->value, strlen(identifier_node->value));
-                 if (!offset_ptr) {
-                     fprintf(stderr, "CodeGen Error: Assignment to undeclared variable '%s'\n", identifier_node->value);
-                     exit(EXIT_FAILURE);
-                 }
-                 fprintf(file, "  # Assignment: %s = ...\n", identifier_node->value);
-                 // Store the result
-                 fprintf(file, "  sw a0, %d(%s)\n", *offset_ptr, FRAME_POINTER);
-            } else {
-                 fprintf(stderr, "CodeGen Error: Operator '%s' cannot be a standalone statement\n", node->value);
-                 exit(EXIT_FAILURE);
+        case NODE_BLOCK: {
+            emit_comment(out, "Entering Block");
+            NodeId current_stmt_in_block = node->child1;
+            while (current_stmt_in_block != NIL_NODE) {
+                generate_statement(current_stmt_in_block, out);
+                current_stmt_in_block = ast_node(tree, current_stmt_in_block)->next;
             }
-            break; // End OPERATOR case
-
-         case SEPARATOR:
-             if (strcmp(node->value, "BLOCK") == 0) {
-                  fprintf(file, "  # Entering Block\n");
-                  Node *current_stmt_in_block = node->child1;
-                  while (current_stmt_in_block != NULL) {
-                       generate_statement(current_stmt_in_block, file);
-                       current_stmt_in_block = current_stmt_in_block->next;
-                  }
-                  fprintf(file, "  # Exiting Block\n");
-             }
-             break;
+            emit_comment(out, "Exiting Block");
+            break;
+        }
 
         default:
-            fprintf(stderr, "CodeGen Warning: Unexpected node type as statement: %d (%s)\n", node->type, node->value ? node->value : "N/A");
+            if (node->type == OPERATOR || node->type == COMP) {
+                fprintf(stderr, "CodeGen Error: Operator '%s' cannot be a standalone statement\n", token_kind_name(node->kind));
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr, "CodeGen Warning: Unexpected node type as statement: %d (%s)\n", node->type, token_kind_name(node->kind));
             break;
     }
 }
 
 // --- Main Generation Function ---
 
-int generate_code(Node *root, const char *filename) {
+// Codegen metadata (the variable table) is allocated from arena.
+// Output goes through a buffered Emitter and reaches the file in large write() calls.
+int generate_code(const Ast *ast, const char *filename, Arena *arena, const Target *core) {
   // Basic check for valid root node
-  if (!root || !(root->type == BEGINNING && strcmp(root->value, "PROGRAM") == 0)) {
+  if (!ast || ast->root == NIL_NODE || ast_node(ast, ast->root)->kind != NODE_PROGRAM) {
        fprintf(stderr, "CodeGen Error: Invalid root node provided to generate_code.\n");
        return -1;
   }
 
-  FILE *file = fopen(filename, "w");
-  if (file == NULL) {
+  tree = ast;
+  target = core;
+  Emitter emitter;
+  Emitter *out = &emitter;
+  if (emit_open(out, filename) != 0) {
       perror("Error opening output file");
       return -1;
   }
 
-  // Initialize the variable map
-  if (hashmap_create(INITIAL_HASHMAP_SIZE, &variable_map) != 0) {
-      fprintf(stderr, "CodeGen Error: Could not create hashmap\n");
-      fclose(file);
-      return -1;
-  }
+  // Initialize the variable table: one slot per interned symbol
+  variable_offsets = arena_calloc(arena, symbol_count() + 1, sizeof(int));
+  register_need = arena_calloc(arena, ast->count, sizeof(uint8_t));
+  pinned_offsets = arena_calloc(arena, ast->count, sizeof(int));
   current_stack_offset = 0; // Reset offset for each code generation run
   label_count = 0;          // Reset label counter
 
 
   // --- Data Segment ---
-  fprintf(file, ".data\n");
-  fprintf(file, "fmt: .asciz \"%%d\\n\" # Format string for printing integers\n");
+  emit_cstr(out, ".data\n");
+  emit_cstr(out, "fmt: .asciz \"%d\\n\" # Format string for printing integers\n");
 
   // --- Text Segment ---
-  fprintf(file, "\n.text\n");
-  fprintf(file, ".extern printf # Declare printf if used\n");
-  fprintf(file, ".globl main\n");
+  emit_cstr(out, "\n.text\n");
+  emit_cstr(out, ".extern printf # Declare printf if used\n");
+  emit_cstr(out, ".globl main\n");
 
   // --- Main Function Prologue (RV32) ---
-  fprintf(file, "\nmain:\n");
-  fprintf(file, "  # Function Prologue (RV32)\n");
-  emit_push("ra", file);
-  emit_push(FRAME_POINTER, file);
-  fprintf(file, "  mv %s, sp\n", FRAME_POINTER);
+  emit_cstr(out, "\nmain:\n");
+  emit_comment(out, "Function Prologue (RV32)");
+  emit_push(REG_RA, out);
+  emit_push(FRAME_POINTER, out);
+  emit_rr(out, MN_MV, FRAME_POINTER, REG_SP);
   // Calculate total stack space needed *after* variable analysis if possible
   // For now, keep fixed allocation, but know locals are above fp
-  fprintf(file, "  addi sp, sp, -128 # Allocate initial stack space (adjust size as needed)\n");
+  emit_cstr(out, "  addi sp, sp, -128 # Allocate initial stack space (adjust size as needed)\n");
 
 
   // --- Generate Code from AST ---
-  fprintf(file, "\n  # Start of generated code from AST\n");
-  Node *current_stmt = root->child1;
-  while (current_stmt != NULL) {
-      generate_statement(current_stmt, file);
-      current_stmt = current_stmt->next;
+  emit_cstr(out, "\n  # Start of generated code from AST\n");
+  NodeId current_stmt = ast_node(ast, ast->root)->child1;
+  while (current_stmt != NIL_NODE) {
+      generate_statement(current_stmt, out);
+      current_stmt = ast_node(ast, current_stmt)->next;
   }
-  fprintf(file, "  # End of generated code from AST\n\n");
+  emit_cstr(out, "  # End of generated code from AST\n\n");
 
 
   // --- Main Function Epilogue (RV32) ---
-  fprintf(file, "  # Function Epilogue (RV32)\n");
-  fprintf(file, "  mv sp, %s\n", FRAME_POINTER); // Deallocate locals
-  emit_pop(FRAME_POINTER, file);
-  emit_pop("ra", file);
-  fprintf(file, "  ret\n\n");
+  emit_comment(out, "Function Epilogue (RV32)");
+  emit_rr(out, MN_MV, REG_SP, FRAME_POINTER); // Deallocate locals
+  emit_pop(FRAME_POINTER, out);
+  emit_pop(REG_RA, out);
+  emit_cstr(out, "  ret\n\n");
 
   // --- Cleanup ---
-  fclose(file);
-  
-  hashmap_destroy(&variable_map);
+  variable_offsets = NULL; // Owned by the arena
+  register_need = NULL;
+  pinned_offsets = NULL;
+  tree = NULL;
+  if (emit_close(out) != 0) {
+      perror("Error writing output file");
+      return -1;
+  }
 
   printf("RISC-V 32-bit code generation complete (optimized): %s\n", filename);
   return 0;
-}
\ No newline at end of file
+}
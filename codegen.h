@@ -2,9 +2,11 @@
 #define CODEGEN_H_
 
 #include <stdio.h>
-#include "parser.h" // Assuming Node is defined in parser.h
+#include "parser.h"
+#include "arena.h"
+#include "target.h"
 
-int generate_code(Node *node, char *filename);
+int generate_code(const Ast *ast, const char *filename, Arena *arena, const Target *target);
 void traverse_tree(Node *node, FILE *file);
 void push(char *reg, FILE *file);
 void pop(char *reg, FILE *file);
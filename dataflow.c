@@ -0,0 +1,456 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dataflow.h"
+
+// --- Generic Solver ---
+
+void dataflow_init(DataflowProblem *problem, const Cfg *cfg, DataflowDirection direction, uint32_t bits, Arena *arena) {
+    uint32_t n = cfg->block_count;
+    problem->direction = (uint8_t)direction;
+    problem->bits = bits;
+    problem->gen = bitset_array(arena, n, bits);
+    problem->kill = bitset_array(arena, n, bits);
+    problem->in = bitset_array(arena, n, bits);
+    problem->out = bitset_array(arena, n, bits);
+}
+
+// Position of block b in the visiting order: reverse postorder forward, postorder backward
+static uint32_t order_position(const Cfg *cfg, int forward, uint32_t b) {
+    return forward ? cfg->rpo_index[b] : cfg->rpo_count - 1 - cfg->rpo_index[b];
+}
+
+// Worklist iteration to the least fixed point. The worklist is a bitset of pending positions
+// in reverse postorder (forward problems) or postorder (backward) and is swept in that order,
+// wrapping around: acyclic regions settle in one visit, and a loop whose header changes is
+// revisited before the code after it, so each sweep costs about one round per loop nesting
+// level rather than one per loop. Returns the number of block visits.
+uint32_t dataflow_solve(DataflowProblem *problem, const Cfg *cfg, Arena *arena) {
+    const IrFunction *fn = cfg->fn;
+    uint32_t n = cfg->rpo_count;
+    if (n == 0) return 0;
+    int forward = problem->direction == DATAFLOW_FORWARD;
+
+    Bitset pending = bitset_new(arena, n);
+    for (uint32_t i = 0; i < n; i++) bitset_set(&pending, i);
+
+    uint32_t visits = 0;
+    uint32_t position = 0;
+    for (;;) {
+        position = bitset_next(&pending, position);
+        if (position == BITSET_END) {
+            position = bitset_next(&pending, 0);
+            if (position == BITSET_END) break;
+        }
+        bitset_reset(&pending, position);
+        uint32_t b = forward ? cfg->rpo[position] : cfg->rpo[n - 1 - position];
+        visits++;
+
+        const IrBlock *block = &fn->blocks[b];
+        uint32_t succs[2];
+        uint32_t succ_count = ir_successors(block, succs);
+        if (forward) {
+            Bitset *meet = &problem->in[b];
+            bitset_clear(meet);
+            for (uint32_t p = 0; p < block->pred_count; p++) {
+                if (cfg_reachable(cfg, block->preds[p])) bitset_union(meet, &problem->out[block->preds[p]]);
+            }
+            if (!bitset_transfer(&problem->out[b], &problem->gen[b], meet, &problem->kill[b])) continue;
+            for (uint32_t s = 0; s < succ_count; s++) bitset_set(&pending, order_position(cfg, forward, succs[s]));
+        } else {
+            Bitset *meet = &problem->out[b];
+            bitset_clear(meet);
+            for (uint32_t s = 0; s < succ_count; s++) bitset_union(meet, &problem->in[succs[s]]);
+            if (!bitset_transfer(&problem->in[b], &problem->gen[b], meet, &problem->kill[b])) continue;
+            for (uint32_t p = 0; p < block->pred_count; p++) {
+                if (cfg_reachable(cfg, block->preds[p])) bitset_set(&pending, order_position(cfg, forward, block->preds[p]));
+            }
+        }
+    }
+    return visits;
+}
+
+// --- Liveness ---
+
+// Position of pred in the predecessor list of block, i.e. the phi argument it supplies
+static uint32_t pred_index(const IrBlock *block, uint32_t pred) {
+    for (uint32_t p = 0; p < block->pred_count; p++) {
+        if (block->preds[p] == pred) return p;
+    }
+    return NO_BLOCK;
+}
+
+static void give_bit(Liveness *liveness, VReg vreg) {
+    if (liveness->bit_of_vreg[vreg] != NO_BIT) return;
+    liveness->bit_of_vreg[vreg] = liveness->bit_count;
+    liveness->vreg_of_bit[liveness->bit_count++] = vreg;
+}
+
+// Marks operand as an upward-exposed use unless the block already defined it
+static void note_use(const Liveness *liveness, DataflowProblem *problem, uint32_t b, Operand operand) {
+    if (operand.kind != OPND_REG) return;
+    uint32_t bit = liveness->bit_of_vreg[operand.value];
+    if (bit != NO_BIT && !bitset_test(&problem->kill[b], bit)) bitset_set(&problem->gen[b], bit);
+}
+
+static void note_def(const Liveness *liveness, DataflowProblem *problem, uint32_t b, VReg vreg) {
+    if (vreg == NO_VREG) return;
+    uint32_t bit = liveness->bit_of_vreg[vreg];
+    if (bit != NO_BIT) bitset_set(&problem->kill[b], bit);
+}
+
+// Runs body with operand bound to each phi argument that block b passes to its successors
+#define FOR_EACH_PHI_ARG(fn, b, operand, body)                                        \
+    do {                                                                             \
+        uint32_t succs_[2];                                                          \
+        uint32_t succ_count_ = ir_successors(&(fn)->blocks[b], succs_);              \
+        for (uint32_t s_ = 0; s_ < succ_count_; s_++) {                              \
+            const IrBlock *succ_ = &(fn)->blocks[succs_[s_]];                        \
+            uint32_t k_ = pred_index(succ_, (b));                                    \
+            for (uint32_t i_ = 0; i_ < succ_->count; i_++) {                         \
+                const IrInst *phi_ = &succ_->insts[i_];                              \
+                if (phi_->op == IR_NOP) continue;                                    \
+                if (phi_->op != IR_PHI) break;                                       \
+                Operand operand = phi_->args[k_];                                    \
+                body;                                                                \
+            }                                                                        \
+        }                                                                            \
+    } while (0)
+
+// Live-variable analysis over vregs. Giving bits only to vregs that cross a block boundary
+// keeps the sets small: before mem2reg almost every vreg is a LOAD result used in its block.
+Liveness *liveness_compute(const IrFunction *fn, const Cfg *cfg, Arena *arena) {
+    Liveness *liveness = arena_calloc(arena, 1, sizeof(Liveness));
+    liveness->bit_of_vreg = arena_alloc(arena, fn->vreg_count * sizeof(uint32_t));
+    liveness->vreg_of_bit = arena_alloc(arena, fn->vreg_count * sizeof(VReg));
+    for (VReg v = 0; v < fn->vreg_count; v++) liveness->bit_of_vreg[v] = NO_BIT;
+
+    // Pass 1: find the vregs used in a block that did not define them first
+    uint32_t *defined_in = arena_calloc(arena, fn->vreg_count, sizeof(uint32_t)); // Block + 1 of the latest def
+    for (uint32_t i = 0; i < cfg->rpo_count; i++) {
+        uint32_t b = cfg->rpo[i];
+        const IrBlock *block = &fn->blocks[b];
+        for (uint32_t j = 0; j < block->count; j++) {
+            const IrInst *inst = &block->insts[j];
+            if (inst->op == IR_PHI) {
+                give_bit(liveness, inst->dst);
+                for (uint32_t k = 0; k < inst->arg_count; k++) {
+                    if (inst->args[k].kind == OPND_REG) give_bit(liveness, (VReg)inst->args[k].value);
+                }
+                continue;
+            }
+            if (inst->a.kind == OPND_REG && defined_in[inst->a.value] != b + 1) give_bit(liveness, (VReg)inst->a.value);
+            if (inst->b.kind == OPND_REG && defined_in[inst->b.value] != b + 1) give_bit(liveness, (VReg)inst->b.value);
+            if (inst->dst != NO_VREG) defined_in[inst->dst] = b + 1;
+        }
+        const IrTerm *term = &block->term;
+        if (term->a.kind == OPND_REG && defined_in[term->a.value] != b + 1) give_bit(liveness, (VReg)term->a.value);
+        if (term->b.kind == OPND_REG && defined_in[term->b.value] != b + 1) give_bit(liveness, (VReg)term->b.value);
+    }
+
+    // Pass 2: local gen (upward-exposed uses) and kill (definitions) sets
+    DataflowProblem problem;
+    dataflow_init(&problem, cfg, DATAFLOW_BACKWARD, liveness->bit_count, arena);
+    for (uint32_t i = 0; i < cfg->rpo_count; i++) {
+        uint32_t b = cfg->rpo[i];
+        const IrBlock *block = &fn->blocks[b];
+        for (uint32_t j = 0; j < block->count; j++) {
+            const IrInst *inst = &block->insts[j];
+            if (inst->op != IR_PHI) {
+                note_use(liveness, &problem, b, inst->a);
+                note_use(liveness, &problem, b, inst->b);
+            }
+            note_def(liveness, &problem, b, inst->dst);
+        }
+        note_use(liveness, &problem, b, block->term.a);
+        note_use(liveness, &problem, b, block->term.b);
+        // A phi argument is used at the end of the predecessor it comes from
+        FOR_EACH_PHI_ARG(fn, b, arg, note_use(liveness, &problem, b, arg));
+    }
+
+    dataflow_solve(&problem, cfg, arena);
+    liveness->live_in = problem.in;
+    liveness->live_out = problem.out;
+
+    // Phi arguments are live out of their predecessor even when it defines them
+    for (uint32_t i = 0; i < cfg->rpo_count; i++) {
+        uint32_t b = cfg->rpo[i];
+        FOR_EACH_PHI_ARG(fn, b, arg, {
+            if (arg.kind == OPND_REG) bitset_set(&liveness->live_out[b], liveness->bit_of_vreg[arg.value]);
+        });
+    }
+    return liveness;
+}
+
+int liveness_is_live_out(const Liveness *liveness, uint32_t block, VReg vreg) {
+    uint32_t bit = liveness->bit_of_vreg[vreg];
+    return bit != NO_BIT && bitset_test(&liveness->live_out[block], bit);
+}
+
+static void dump_vreg_set(const Liveness *liveness, const Bitset *set, FILE *file) {
+    fprintf(file, "{");
+    const char *separator = "";
+    for (uint32_t bit = bitset_next(set, 0); bit != BITSET_END; bit = bitset_next(set, bit + 1)) {
+        fprintf(file, "%sv%u", separator, (unsigned)liveness->vreg_of_bit[bit]);
+        separator = " ";
+    }
+    fprintf(file, "}");
+}
+
+void liveness_dump(const Liveness *liveness, const Cfg *cfg, FILE *file) {
+    fprintf(file, "=== Liveness: %u cross-block vregs ===\n", (unsigned)liveness->bit_count);
+    for (uint32_t i = 0; i < cfg->rpo_count; i++) {
+        uint32_t b = cfg->rpo[i];
+        fprintf(file, "b%u: in ", (unsigned)b);
+        dump_vreg_set(liveness, &liveness->live_in[b], file);
+        fprintf(file, " out ");
+        dump_vreg_set(liveness, &liveness->live_out[b], file);
+        fprintf(file, "\n");
+    }
+    fprintf(file, "\n");
+}
+
+// --- Sparse Liveness ---
+
+// Growable list of (vreg, block) pairs
+typedef struct {
+    uint32_t *items;
+    uint32_t count;
+    uint32_t capacity;
+} PairList;
+
+static void pair_push(PairList *list, Arena *arena, uint32_t vreg, uint32_t block) {
+    if (list->count == list->capacity) {
+        uint32_t capacity = list->capacity ? list->capacity * 2 : 256;
+        list->items = arena_grow(arena, list->items, list->capacity * 2 * sizeof(uint32_t), capacity * 2 * sizeof(uint32_t));
+        list->capacity = capacity;
+    }
+    list->items[2 * list->count] = vreg;
+    list->items[2 * list->count + 1] = block;
+    list->count++;
+}
+
+// Groups pairs by their key_index component (0: vreg, 1: block) into start/values arrays.
+// Pairs keep their relative order within a group.
+static uint32_t *group_pairs(const PairList *list, int key_index, uint32_t keys, Arena *arena, uint32_t **start) {
+    uint32_t *offsets = arena_calloc(arena, keys + 1, sizeof(uint32_t));
+    for (uint32_t i = 0; i < list->count; i++) offsets[list->items[2 * i + key_index] + 1]++;
+    for (uint32_t k = 0; k < keys; k++) offsets[k + 1] += offsets[k];
+    uint32_t *values = arena_alloc(arena, (list->count + 1) * sizeof(uint32_t));
+    uint32_t *fill = arena_alloc(arena, (keys + 1) * sizeof(uint32_t));
+    memcpy(fill, offsets, keys * sizeof(uint32_t));
+    for (uint32_t i = 0; i < list->count; i++) {
+        values[fill[list->items[2 * i + key_index]]++] = list->items[2 * i + 1 - key_index];
+    }
+    *start = offsets;
+    return values;
+}
+
+// Liveness by path exploration. Each vreg is handled on its own: starting from the blocks
+// where it is used before being defined (and from the predecessors its phi arguments come
+// from), the walk goes up through predecessors, reporting each block the vreg is live into
+// or out of exactly once, and stops at blocks that define it. Preds must be up to date.
+void live_explore(const IrFunction *fn, Arena *arena, LiveVisitor visit, void *context) {
+    uint32_t n = fn->block_count;
+    uint32_t vregs = fn->vreg_count;
+    PairList defs = { NULL, 0, 0 };
+    PairList uses = { NULL, 0, 0 };      // Upward-exposed uses: live into the block
+    PairList phi_uses = { NULL, 0, 0 };  // Phi arguments: live out of the predecessor
+    uint32_t *defined_here = arena_calloc(arena, vregs, sizeof(uint32_t)); // Block + 1
+    uint32_t *used_here = arena_calloc(arena, vregs, sizeof(uint32_t));
+
+#define NOTE_USE(operand)                                                                        \
+    do {                                                                                         \
+        if ((operand).kind == OPND_REG && defined_here[(operand).value] != b + 1 &&               \
+            used_here[(operand).value] != b + 1) {                                               \
+            used_here[(operand).value] = b + 1;                                                  \
+            pair_push(&uses, arena, (uint32_t)(operand).value, b);                                \
+        }                                                                                        \
+    } while (0)
+
+    for (uint32_t b = 0; b < n; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        for (uint32_t i = 0; i < block->count; i++) {
+            const IrInst *inst = &block->insts[i];
+            if (inst->op == IR_PHI) {
+                for (uint32_t k = 0; k < inst->arg_count; k++) {
+                    if (inst->args[k].kind == OPND_REG) pair_push(&phi_uses, arena, (uint32_t)inst->args[k].value, block->preds[k]);
+                }
+            } else if (inst->op != IR_NOP) {
+                NOTE_USE(inst->a);
+                NOTE_USE(inst->b);
+            }
+            if (inst->dst != NO_VREG && inst->op != IR_NOP && defined_here[inst->dst] != b + 1) {
+                defined_here[inst->dst] = b + 1;
+                pair_push(&defs, arena, inst->dst, b);
+            }
+        }
+        NOTE_USE(block->term.a);
+        NOTE_USE(block->term.b);
+    }
+#undef NOTE_USE
+
+    uint32_t *def_start, *use_start, *phi_start;
+    uint32_t *def_blocks = group_pairs(&defs, 0, vregs, arena, &def_start);
+    uint32_t *use_blocks = group_pairs(&uses, 0, vregs, arena, &use_start);
+    uint32_t *phi_blocks = group_pairs(&phi_uses, 0, vregs, arena, &phi_start);
+
+    // Per-block stamps hold the vreg being explored, so they never need clearing
+    uint32_t *defines = arena_calloc(arena, n + 1, sizeof(uint32_t));
+    uint32_t *in_mark = arena_calloc(arena, n + 1, sizeof(uint32_t));
+    uint32_t *out_mark = arena_calloc(arena, n + 1, sizeof(uint32_t));
+    uint32_t *stack = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    for (VReg v = 1; v < vregs; v++) {
+        for (uint32_t d = def_start[v]; d < def_start[v + 1]; d++) defines[def_blocks[d]] = v;
+        uint32_t depth = 0;
+        for (uint32_t u = use_start[v]; u < use_start[v + 1]; u++) {
+            uint32_t b = use_blocks[u];
+            if (in_mark[b] == v) continue;
+            in_mark[b] = v;
+            visit(context, v, b, 0);
+            stack[depth++] = b;
+        }
+        for (uint32_t u = phi_start[v]; u < phi_start[v + 1]; u++) {
+            uint32_t p = phi_blocks[u];
+            if (out_mark[p] != v) {
+                out_mark[p] = v;
+                visit(context, v, p, 1);
+            }
+            if (defines[p] == v || in_mark[p] == v) continue;
+            in_mark[p] = v;
+            visit(context, v, p, 0);
+            stack[depth++] = p;
+        }
+        while (depth > 0) {
+            const IrBlock *block = &fn->blocks[stack[--depth]];
+            for (uint32_t k = 0; k < block->pred_count; k++) {
+                uint32_t p = block->preds[k];
+                if (out_mark[p] != v) {
+                    out_mark[p] = v;
+                    visit(context, v, p, 1);
+                }
+                if (defines[p] == v || in_mark[p] == v) continue;
+                in_mark[p] = v;
+                visit(context, v, p, 0);
+                stack[depth++] = p;
+            }
+        }
+    }
+}
+
+typedef struct {
+    Arena *arena;
+    PairList in;
+    PairList out;
+} LiveSetsBuilder;
+
+static void collect_live(void *context, VReg vreg, uint32_t block, int live_out) {
+    LiveSetsBuilder *builder = context;
+    pair_push(live_out ? &builder->out : &builder->in, builder->arena, vreg, block);
+}
+
+// Live sets as per-block vreg lists. Takes memory proportional to their total size; clients
+// that only need to fold the sets into something smaller should call live_explore directly.
+LiveSets *live_sets_compute(const IrFunction *fn, Arena *arena) {
+    LiveSetsBuilder builder = { arena, { NULL, 0, 0 }, { NULL, 0, 0 } };
+    live_explore(fn, arena, collect_live, &builder);
+    LiveSets *sets = arena_calloc(arena, 1, sizeof(LiveSets));
+    sets->in = group_pairs(&builder.in, 1, fn->block_count, arena, &sets->in_start);
+    sets->out = group_pairs(&builder.out, 1, fn->block_count, arena, &sets->out_start);
+    return sets;
+}
+
+// --- Reaching Definitions ---
+
+// Collects the indices of the STOREs in block b that are the last to their slot in the block,
+// from the end of the block backwards. stored_in holds block + 1 per slot and must not already
+// hold b + 1.
+static uint32_t exposed_stores(const IrBlock *block, uint32_t b, uint32_t *stored_in, uint32_t *out) {
+    uint32_t count = 0;
+    for (uint32_t j = block->count; j-- > 0;) {
+        const IrInst *inst = &block->insts[j];
+        if (inst->op != IR_STORE || stored_in[inst->var] == b + 1) continue;
+        stored_in[inst->var] = b + 1;
+        out[count++] = j;
+    }
+    return count;
+}
+
+// Forward problem over STORE sites. A block kills every STORE to the slots it writes and
+// generates the last STORE to each of them. STOREs overwritten later in their own block
+// never reach a boundary and are left out of the universe, which keeps the dense sets
+// (blocks x sites bits each) as small as this formulation allows.
+ReachingDefs *reaching_defs_compute(const IrFunction *fn, const Cfg *cfg, Arena *arena) {
+    ReachingDefs *reaching = arena_calloc(arena, 1, sizeof(ReachingDefs));
+    uint32_t *stored_in = arena_calloc(arena, fn->var_count + 1, sizeof(uint32_t)); // Block + 1 that last stored the slot
+    uint32_t max_count = 0;
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        if (fn->blocks[b].count > max_count) max_count = fn->blocks[b].count;
+    }
+    uint32_t *indices = arena_alloc(arena, (max_count + 1) * sizeof(uint32_t));
+
+    // Number the exposed STOREs of reachable blocks in block order; a block's sites are contiguous
+    uint32_t *first_def = arena_alloc(arena, (fn->block_count + 1) * sizeof(uint32_t));
+    uint32_t *var_start = arena_calloc(arena, fn->var_count + 2, sizeof(uint32_t));
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        first_def[b] = reaching->def_count;
+        if (!cfg_reachable(cfg, b)) continue;
+        const IrBlock *block = &fn->blocks[b];
+        uint32_t count = exposed_stores(block, b, stored_in, indices);
+        for (uint32_t k = 0; k < count; k++) var_start[block->insts[indices[k]].var + 1]++;
+        reaching->def_count += count;
+    }
+    first_def[fn->block_count] = reaching->def_count;
+
+    reaching->defs = arena_alloc(arena, (reaching->def_count + 1) * sizeof(DefSite));
+    for (uint32_t v = 0; v < fn->var_count; v++) var_start[v + 1] += var_start[v];
+    uint32_t *var_defs = arena_alloc(arena, (reaching->def_count + 1) * sizeof(uint32_t)); // Sites grouped by slot
+    uint32_t *fill = arena_alloc(arena, (fn->var_count + 1) * sizeof(uint32_t));
+    memcpy(fill, var_start, fn->var_count * sizeof(uint32_t));
+    memset(stored_in, 0, (fn->var_count + 1) * sizeof(uint32_t));
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        if (!cfg_reachable(cfg, b)) continue;
+        const IrBlock *block = &fn->blocks[b];
+        uint32_t count = exposed_stores(block, b, stored_in, indices);
+        for (uint32_t k = 0; k < count; k++) {
+            uint32_t d = first_def[b] + k;
+            DefSite site = { b, indices[count - 1 - k], block->insts[indices[count - 1 - k]].var };
+            reaching->defs[d] = site;
+            var_defs[fill[site.var]++] = d;
+        }
+    }
+
+    DataflowProblem problem;
+    dataflow_init(&problem, cfg, DATAFLOW_FORWARD, reaching->def_count, arena);
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        for (uint32_t d = first_def[b]; d < first_def[b + 1]; d++) {
+            uint32_t var = reaching->defs[d].var;
+            for (uint32_t k = var_start[var]; k < var_start[var + 1]; k++) bitset_set(&problem.kill[b], var_defs[k]);
+            bitset_set(&problem.gen[b], d);
+        }
+    }
+
+    dataflow_solve(&problem, cfg, arena);
+    reaching->reach_in = problem.in;
+    reaching->reach_out = problem.out;
+    return reaching;
+}
+
+void reaching_defs_dump(const ReachingDefs *reaching, const IrFunction *fn, const Cfg *cfg, FILE *file) {
+    fprintf(file, "=== Reaching definitions: %u stores ===\n", (unsigned)reaching->def_count);
+    for (uint32_t i = 0; i < cfg->rpo_count; i++) {
+        uint32_t b = cfg->rpo[i];
+        const Bitset *set = &reaching->reach_in[b];
+        fprintf(file, "b%u: in {", (unsigned)b);
+        const char *separator = "";
+        for (uint32_t d = bitset_next(set, 0); d != BITSET_END; d = bitset_next(set, d + 1)) {
+            const DefSite *site = &reaching->defs[d];
+            fprintf(file, "%s%s.%u@b%u:%u", separator, symbol_name(fn->vars[site->var]), (unsigned)site->var,
+                    (unsigned)site->block, (unsigned)site->index);
+            separator = " ";
+        }
+        fprintf(file, "}\n");
+    }
+    fprintf(file, "\n");
+}
@@ -0,0 +1,87 @@
+#ifndef DATAFLOW_H_
+#define DATAFLOW_H_
+
+#include <stdio.h>
+#include "ir.h"
+#include "cfg.h"
+#include "bitset.h"
+#include "arena.h"
+
+// --- Generic Solver ---
+
+typedef enum {
+    DATAFLOW_FORWARD,  // in = union of predecessor outs, out = gen | (in & ~kill)
+    DATAFLOW_BACKWARD, // out = union of successor ins, in = gen | (out & ~kill)
+} DataflowDirection;
+
+// A gen/kill problem over a universe of bits with union as the meet. The client fills gen
+// and kill (one set per block); the solver fills in and out. Unreachable blocks keep empty sets.
+typedef struct {
+    uint8_t direction; // DataflowDirection
+    uint32_t bits;
+    Bitset *gen;
+    Bitset *kill;
+    Bitset *in;
+    Bitset *out;
+} DataflowProblem;
+
+void dataflow_init(DataflowProblem *problem, const Cfg *cfg, DataflowDirection direction, uint32_t bits, Arena *arena);
+uint32_t dataflow_solve(DataflowProblem *problem, const Cfg *cfg, Arena *arena);
+
+// --- Liveness ---
+
+#define NO_BIT ((uint32_t)UINT32_MAX)
+
+// Live vregs at block boundaries. Only vregs that can be live across a block boundary
+// (used in a block that does not define them first, or taking part in a phi) get a bit.
+typedef struct {
+    uint32_t bit_count;
+    uint32_t *bit_of_vreg; // vreg -> bit, NO_BIT for block-local vregs
+    VReg *vreg_of_bit;
+    Bitset *live_in;       // Per block; phi destinations are not live into their block
+    Bitset *live_out;      // Per block; includes the phi arguments the block passes to its successors
+} Liveness;
+
+Liveness *liveness_compute(const IrFunction *fn, const Cfg *cfg, Arena *arena);
+int liveness_is_live_out(const Liveness *liveness, uint32_t block, VReg vreg);
+void liveness_dump(const Liveness *liveness, const Cfg *cfg, FILE *file);
+
+// --- Sparse Liveness ---
+
+// The same live sets as Liveness, as vreg lists. Computed by walking back from every use to
+// the definitions (path exploration), so the cost is proportional to the size of the sets
+// rather than blocks x vregs; this is what register allocation uses on SSA-sized inputs.
+typedef struct {
+    uint32_t *in_start;  // Live-in of b: in[in_start[b] .. in_start[b + 1])
+    VReg *in;
+    uint32_t *out_start; // Live-out of b: out[out_start[b] .. out_start[b + 1])
+    VReg *out;
+} LiveSets;
+
+// Called once per (vreg, block) where vreg is live into (live_out == 0) or out of the block
+typedef void (*LiveVisitor)(void *context, VReg vreg, uint32_t block, int live_out);
+
+void live_explore(const IrFunction *fn, Arena *arena, LiveVisitor visit, void *context);
+LiveSets *live_sets_compute(const IrFunction *fn, Arena *arena);
+
+// --- Reaching Definitions ---
+
+// A STORE to a variable slot that is the last one to its slot in its block
+typedef struct {
+    uint32_t block;
+    uint32_t index; // Instruction index in the block
+    uint32_t var;
+} DefSite;
+
+// STOREs that may reach each block boundary without an intervening STORE to the same slot
+typedef struct {
+    uint32_t def_count;
+    DefSite *defs;
+    Bitset *reach_in;
+    Bitset *reach_out;
+} ReachingDefs;
+
+ReachingDefs *reaching_defs_compute(const IrFunction *fn, const Cfg *cfg, Arena *arena);
+void reaching_defs_dump(const ReachingDefs *reaching, const IrFunction *fn, const Cfg *cfg, FILE *file);
+
+#endif
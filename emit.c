@@ -0,0 +1,277 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <sys/stat.h>
+#define write _write
+#define close _close
+#define OUTPUT_FLAGS (_O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY)
+#define OUTPUT_MODE (_S_IREAD | _S_IWRITE)
+#define open _open
+#else
+#include <unistd.h>
+#define OUTPUT_FLAGS (O_WRONLY | O_CREAT | O_TRUNC)
+#define OUTPUT_MODE 0644
+#endif
+
+#include "emit.h"
+
+// Strings are stored with their lengths so emitting them is a plain memcpy
+typedef struct {
+    const char *text;
+    size_t length;
+} Spelling;
+
+#define SPELL(s) { s, sizeof(s) - 1 }
+
+static const Spelling reg_names[REG_COUNT] = {
+    SPELL("zero"), SPELL("ra"), SPELL("sp"), SPELL("gp"), SPELL("tp"),
+    SPELL("t0"), SPELL("t1"), SPELL("t2"),
+    SPELL("s0"), SPELL("s1"),
+    SPELL("a0"), SPELL("a1"), SPELL("a2"), SPELL("a3"), SPELL("a4"), SPELL("a5"), SPELL("a6"), SPELL("a7"),
+    SPELL("s2"), SPELL("s3"), SPELL("s4"), SPELL("s5"), SPELL("s6"), SPELL("s7"), SPELL("s8"), SPELL("s9"),
+    SPELL("s10"), SPELL("s11"),
+    SPELL("t3"), SPELL("t4"), SPELL("t5"), SPELL("t6"),
+};
+
+// Mnemonics include the indentation and the separating space
+static const Spelling mnemonics[MNEMONIC_COUNT] = {
+    [MN_ADD] = SPELL("  add "),   [MN_SUB] = SPELL("  sub "),   [MN_MUL] = SPELL("  mul "),
+    [MN_MULH] = SPELL("  mulh "), [MN_DIV] = SPELL("  div "),   [MN_REM] = SPELL("  rem "),
+    [MN_SLT] = SPELL("  slt "),   [MN_SGT] = SPELL("  sgt "),   [MN_ADDI] = SPELL("  addi "),
+    [MN_SLTI] = SPELL("  slti "), [MN_XORI] = SPELL("  xori "), [MN_SLLI] = SPELL("  slli "),
+    [MN_SRLI] = SPELL("  srli "), [MN_SRAI] = SPELL("  srai "), [MN_LI] = SPELL("  li "),
+    [MN_MV] = SPELL("  mv "),     [MN_NEG] = SPELL("  neg "),   [MN_SEQZ] = SPELL("  seqz "),
+    [MN_SNEZ] = SPELL("  snez "), [MN_LW] = SPELL("  lw "),     [MN_SW] = SPELL("  sw "),
+    [MN_BEQ] = SPELL("  beq "),   [MN_BNE] = SPELL("  bne "),   [MN_BLT] = SPELL("  blt "),
+    [MN_BGE] = SPELL("  bge "),   [MN_BGT] = SPELL("  bgt "),   [MN_BLE] = SPELL("  ble "),
+    [MN_BEQZ] = SPELL("  beqz "), [MN_BNEZ] = SPELL("  bnez "), [MN_J] = SPELL("  j "),
+    [MN_CALL] = SPELL("  call "), [MN_LA] = SPELL("  la "),     [MN_ECALL] = SPELL("  ecall"),
+    [MN_RET] = SPELL("  ret"),
+};
+
+const char *reg_name(Reg reg) {
+    return reg_names[reg].text;
+}
+
+// --- Output Buffer ---
+
+// Hands everything buffered to the OS in one write() (looping only on short writes)
+static void emit_flush(Emitter *out) {
+    size_t done = 0;
+    while (done < out->length && !out->failed) {
+        long written = (long)write(out->fd, out->buffer + done, (unsigned)(out->length - done));
+        if (written <= 0) {
+            out->failed = 1;
+            break;
+        }
+        done += (size_t)written;
+    }
+    out->bytes_written += done;
+    out->length = 0;
+}
+
+// Makes room for at least size more bytes
+static inline char *emit_reserve(Emitter *out, size_t size) {
+    if (out->capacity - out->length < size) {
+        emit_flush(out);
+    }
+    return out->buffer + out->length;
+}
+
+int emit_open(Emitter *out, const char *filename) {
+    memset(out, 0, sizeof(*out));
+    out->fd = open(filename, OUTPUT_FLAGS, OUTPUT_MODE);
+    if (out->fd < 0) {
+        return -1;
+    }
+    out->buffer = malloc(EMIT_BUFFER_SIZE);
+    if (out->buffer == NULL) {
+        close(out->fd);
+        return -1;
+    }
+    out->capacity = EMIT_BUFFER_SIZE;
+    return 0;
+}
+
+// Flushes the remaining output and closes the file. Returns -1 if any write failed.
+int emit_close(Emitter *out) {
+    emit_flush(out);
+    if (close(out->fd) != 0) {
+        out->failed = 1;
+    }
+    free(out->buffer);
+    out->buffer = NULL;
+    return out->failed ? -1 : 0;
+}
+
+// --- Raw Text ---
+
+void emit_text(Emitter *out, const char *text, size_t length) {
+    if (length > out->capacity) {
+        // Too big to buffer: write it straight through after what is pending
+        emit_flush(out);
+        char *saved = out->buffer;
+        out->buffer = (char *)text;
+        out->length = length;
+        emit_flush(out);
+        out->buffer = saved;
+        return;
+    }
+    char *p = emit_reserve(out, length);
+    memcpy(p, text, length);
+    out->length += length;
+}
+
+void emit_cstr(Emitter *out, const char *text) {
+    emit_text(out, text, strlen(text));
+}
+
+static inline void emit_spelling(Emitter *out, const Spelling *spelling) {
+    char *p = emit_reserve(out, spelling->length);
+    memcpy(p, spelling->text, spelling->length);
+    out->length += spelling->length;
+}
+
+static inline void emit_char(Emitter *out, char c) {
+    *emit_reserve(out, 1) = c;
+    out->length++;
+}
+
+// Decimal conversion without printf: digits are produced backwards into a small scratch buffer
+void emit_int(Emitter *out, long value) {
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    char *p = end;
+    unsigned long magnitude = value < 0 ? 0ul - (unsigned long)value : (unsigned long)value;
+    do {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) {
+        *--p = '-';
+    }
+    emit_text(out, p, (size_t)(end - p));
+}
+
+// "  # text"
+void emit_comment(Emitter *out, const char *text) {
+    emit_text(out, "  # ", 4);
+    emit_cstr(out, text);
+    emit_char(out, '\n');
+}
+
+// --- Instructions ---
+
+static inline void emit_reg(Emitter *out, Reg reg) {
+    emit_spelling(out, &reg_names[reg]);
+}
+
+static inline void emit_separator(Emitter *out) {
+    emit_text(out, ", ", 2);
+}
+
+void emit_rrr(Emitter *out, Mnemonic op, Reg rd, Reg rs1, Reg rs2) {
+    emit_spelling(out, &mnemonics[op]);
+    emit_reg(out, rd);
+    emit_separator(out);
+    emit_reg(out, rs1);
+    emit_separator(out);
+    emit_reg(out, rs2);
+    emit_char(out, '\n');
+}
+
+void emit_rri(Emitter *out, Mnemonic op, Reg rd, Reg rs1, long imm) {
+    emit_spelling(out, &mnemonics[op]);
+    emit_reg(out, rd);
+    emit_separator(out);
+    emit_reg(out, rs1);
+    emit_separator(out);
+    emit_int(out, imm);
+    emit_char(out, '\n');
+}
+
+void emit_rr(Emitter *out, Mnemonic op, Reg rd, Reg rs) {
+    emit_spelling(out, &mnemonics[op]);
+    emit_reg(out, rd);
+    emit_separator(out);
+    emit_reg(out, rs);
+    emit_char(out, '\n');
+}
+
+void emit_ri(Emitter *out, Mnemonic op, Reg rd, long imm) {
+    emit_spelling(out, &mnemonics[op]);
+    emit_reg(out, rd);
+    emit_separator(out);
+    emit_int(out, imm);
+    emit_char(out, '\n');
+}
+
+// "  lw reg, offset(base)"
+void emit_mem(Emitter *out, Mnemonic op, Reg reg, long offset, Reg base) {
+    emit_spelling(out, &mnemonics[op]);
+    emit_reg(out, reg);
+    emit_separator(out);
+    emit_int(out, offset);
+    emit_char(out, '(');
+    emit_reg(out, base);
+    emit_text(out, ")\n", 2);
+}
+
+void emit_label_name(Emitter *out, int label) {
+    emit_char(out, 'L');
+    emit_int(out, label);
+}
+
+void emit_branch(Emitter *out, Mnemonic op, Reg rs1, Reg rs2, int label) {
+    emit_spelling(out, &mnemonics[op]);
+    emit_reg(out, rs1);
+    emit_separator(out);
+    emit_reg(out, rs2);
+    emit_separator(out);
+    emit_label_name(out, label);
+    emit_char(out, '\n');
+}
+
+void emit_branch_zero(Emitter *out, Mnemonic op, Reg rs, int label) {
+    emit_spelling(out, &mnemonics[op]);
+    emit_reg(out, rs);
+    emit_separator(out);
+    emit_label_name(out, label);
+    emit_char(out, '\n');
+}
+
+void emit_jump(Emitter *out, int label) {
+    emit_spelling(out, &mnemonics[MN_J]);
+    emit_label_name(out, label);
+    emit_char(out, '\n');
+}
+
+// "  call symbol"
+void emit_symbol(Emitter *out, Mnemonic op, const char *symbol) {
+    emit_spelling(out, &mnemonics[op]);
+    emit_cstr(out, symbol);
+    emit_char(out, '\n');
+}
+
+void emit_la(Emitter *out, Reg rd, const char *symbol) {
+    emit_spelling(out, &mnemonics[MN_LA]);
+    emit_reg(out, rd);
+    emit_separator(out);
+    emit_cstr(out, symbol);
+    emit_char(out, '\n');
+}
+
+void emit_bare(Emitter *out, Mnemonic op) {
+    emit_spelling(out, &mnemonics[op]);
+    emit_char(out, '\n');
+}
+
+// "Ln:"
+void emit_label(Emitter *out, int label) {
+    emit_label_name(out, label);
+    emit_text(out, ":\n", 2);
+}
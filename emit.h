@@ -0,0 +1,75 @@
+#ifndef EMIT_H_
+#define EMIT_H_
+
+#include <stddef.h>
+
+// RV32 integer registers, in x0..x31 order
+typedef enum {
+    REG_ZERO, REG_RA, REG_SP, REG_GP, REG_TP,
+    REG_T0, REG_T1, REG_T2,
+    REG_S0, REG_S1,
+    REG_A0, REG_A1, REG_A2, REG_A3, REG_A4, REG_A5, REG_A6, REG_A7,
+    REG_S2, REG_S3, REG_S4, REG_S5, REG_S6, REG_S7, REG_S8, REG_S9, REG_S10, REG_S11,
+    REG_T3, REG_T4, REG_T5, REG_T6,
+    REG_COUNT,
+} Reg;
+
+// Instructions and pseudo-instructions the code generators emit
+typedef enum {
+    // rd, rs1, rs2
+    MN_ADD, MN_SUB, MN_MUL, MN_MULH, MN_DIV, MN_REM, MN_SLT, MN_SGT,
+    // rd, rs1, imm
+    MN_ADDI, MN_SLTI, MN_XORI, MN_SLLI, MN_SRLI, MN_SRAI,
+    // rd, imm / rd, rs
+    MN_LI, MN_MV, MN_NEG, MN_SEQZ, MN_SNEZ,
+    // reg, offset(base)
+    MN_LW, MN_SW,
+    // rs1, rs2, label / rs, label
+    MN_BEQ, MN_BNE, MN_BLT, MN_BGE, MN_BGT, MN_BLE, MN_BEQZ, MN_BNEZ,
+    // label / symbol / no operands
+    MN_J, MN_CALL, MN_LA, MN_ECALL, MN_RET,
+    MNEMONIC_COUNT,
+} Mnemonic;
+
+// Buffered writer for assembly text. Output accumulates in one large buffer that is
+// handed to the OS with a single write() whenever it fills up and when it is closed.
+typedef struct {
+    char *buffer;
+    size_t length;        // Bytes waiting in buffer
+    size_t capacity;
+    int fd;               // Output file descriptor
+    int failed;           // Set once a write fails; reported by emit_close
+    size_t bytes_written; // Total bytes flushed so far
+} Emitter;
+
+#define EMIT_BUFFER_SIZE (1024 * 1024)
+
+int emit_open(Emitter *out, const char *filename);
+int emit_close(Emitter *out);
+
+// Raw text
+void emit_text(Emitter *out, const char *text, size_t length);
+void emit_cstr(Emitter *out, const char *text);
+void emit_int(Emitter *out, long value);
+void emit_comment(Emitter *out, const char *text);
+
+// Instructions: each writes one indented line
+void emit_rrr(Emitter *out, Mnemonic op, Reg rd, Reg rs1, Reg rs2);
+void emit_rri(Emitter *out, Mnemonic op, Reg rd, Reg rs1, long imm);
+void emit_rr(Emitter *out, Mnemonic op, Reg rd, Reg rs);
+void emit_ri(Emitter *out, Mnemonic op, Reg rd, long imm);
+void emit_mem(Emitter *out, Mnemonic op, Reg reg, long offset, Reg base);
+void emit_branch(Emitter *out, Mnemonic op, Reg rs1, Reg rs2, int label);
+void emit_branch_zero(Emitter *out, Mnemonic op, Reg rs, int label);
+void emit_jump(Emitter *out, int label);
+void emit_symbol(Emitter *out, Mnemonic op, const char *symbol);
+void emit_la(Emitter *out, Reg rd, const char *symbol);
+void emit_bare(Emitter *out, Mnemonic op);
+
+// Labels
+void emit_label(Emitter *out, int label);
+void emit_label_name(Emitter *out, int label);
+
+const char *reg_name(Reg reg);
+
+#endif
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "evaluate.h"
+#include "cfg.h"
+
+#define EVALUATE_MAX_WRITES 1024 // Writes the evaluated part may print (each becomes an instruction)
+
+// --- Interpreter ---
+
+// Machine state between blocks. Vregs never live across blocks before mem2reg, so the
+// variable slots are all that carries over.
+static IrFunction *fn = NULL;
+static int32_t *vars = NULL;
+static uint8_t *assigned = NULL;  // Slots stored to so far (the others still read as 0)
+static int32_t *values = NULL;    // vreg -> value, for the block being run
+static int32_t *writes = NULL;    // Values printed so far
+static uint32_t write_count = 0;
+
+static int32_t operand_value(Operand operand) {
+    return operand.kind == OPND_IMM ? operand.value : values[operand.value];
+}
+
+static uint32_t block_writes(const IrBlock *block) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < block->count; i++) count += block->insts[i].op == IR_WRITE;
+    return count;
+}
+
+// Runs block b and returns the next block, or NO_BLOCK when the program ends there
+static uint32_t run_block(uint32_t b) {
+    const IrBlock *block = &fn->blocks[b];
+    for (uint32_t i = 0; i < block->count; i++) {
+        const IrInst *inst = &block->insts[i];
+        switch (inst->op) {
+            case IR_NOP:
+                break;
+            case IR_COPY:
+                values[inst->dst] = operand_value(inst->a);
+                break;
+            case IR_LOAD:
+                values[inst->dst] = vars[inst->var];
+                break;
+            case IR_STORE:
+                vars[inst->var] = operand_value(inst->a);
+                assigned[inst->var] = 1;
+                break;
+            case IR_WRITE:
+                writes[write_count++] = operand_value(inst->a);
+                break;
+            default:
+                values[inst->dst] = ir_evaluate((IrOp)inst->op, operand_value(inst->a), operand_value(inst->b));
+                break;
+        }
+    }
+    const IrTerm *term = &block->term;
+    if (term->kind == TERM_JUMP) return term->target[0];
+    if (term->kind == TERM_BRANCH) {
+        return ir_evaluate((IrOp)term->cmp, operand_value(term->a), operand_value(term->b)) ? term->target[0] : term->target[1];
+    }
+    return NO_BLOCK;
+}
+
+// --- Residual Program ---
+
+// Moves the entry block out of block 0, so that block 0 can become the new entry
+static void free_entry_block(void) {
+    uint32_t moved = ir_new_block(fn);
+    fn->blocks[moved] = fn->blocks[0];
+    memset(&fn->blocks[0], 0, sizeof(IrBlock));
+    for (uint32_t b = 1; b < fn->block_count; b++) {
+        IrTerm *term = &fn->blocks[b].term;
+        for (int i = 0; i < 2; i++) {
+            if (term->target[i] == 0) term->target[i] = moved;
+        }
+    }
+}
+
+// --- Pass ---
+
+// Runs on the lowered IR, before mem2reg, whole blocks at a time: a block only starts if the
+// fuel left covers all of it, so the program is always stopped at a block boundary. If it
+// ended, the entry block prints the recorded writes and exits with the same code. Otherwise
+// the entry prints the writes so far, stores the variables' current values and jumps to the
+// block it stopped at; the rest of the program is compiled as usual from there.
+void evaluate_program(IrFunction *function, const CompilerOptions *options) {
+    fn = function;
+    Arena *arena = fn->arena;
+    uint64_t fuel = options->fuel > 0 ? (uint64_t)options->fuel : EVALUATE_DEFAULT_FUEL;
+    vars = arena_calloc(arena, fn->var_count + 1, sizeof(int32_t));
+    assigned = arena_calloc(arena, fn->var_count + 1, sizeof(uint8_t));
+    values = arena_calloc(arena, fn->vreg_count, sizeof(int32_t));
+    writes = arena_alloc(arena, EVALUATE_MAX_WRITES * sizeof(int32_t));
+    write_count = 0;
+
+    uint32_t b = 0;
+    uint32_t blocks_run = 0;
+    const IrTerm *end = NULL;
+    for (;;) {
+        const IrBlock *block = &fn->blocks[b];
+        uint64_t cost = block->count + 1;
+        if (block->term.kind == TERM_NONE || cost > fuel) break;
+        if (write_count + block_writes(block) > EVALUATE_MAX_WRITES) break;
+        fuel -= cost;
+        blocks_run++;
+        uint32_t next = run_block(b);
+        if (next == NO_BLOCK) {
+            end = &block->term;
+            break;
+        }
+        b = next;
+    }
+    if (blocks_run == 0) {
+        fn = NULL;
+        return;
+    }
+
+    IrTerm outcome;
+    if (end != NULL) {
+        outcome = *end;
+        outcome.a = ir_imm(end->kind == TERM_EXIT ? operand_value(end->a) : 0);
+    }
+    free_entry_block();
+    if (b == 0) b = fn->block_count - 1;
+    for (uint32_t i = 0; i < write_count; i++) ir_append(fn, 0, IR_WRITE)->a = ir_imm(writes[i]);
+    if (end != NULL) {
+        fn->blocks[0].term = outcome;
+    } else {
+        for (uint32_t v = 0; v < fn->var_count; v++) {
+            if (!assigned[v]) continue;
+            IrInst *store = ir_append(fn, 0, IR_STORE);
+            store->var = v;
+            store->a = ir_imm(vars[v]);
+        }
+        ir_set_jump(fn, 0, b);
+    }
+    cfg_compute_predecessors(fn);
+    remove_unreachable_blocks(fn, options);
+
+    fn = NULL;
+    vars = NULL;
+    assigned = NULL;
+    values = NULL;
+    writes = NULL;
+}
@@ -0,0 +1,16 @@
+#ifndef EVALUATE_H_
+#define EVALUATE_H_
+
+#include "ir.h"
+#include "pipeline.h"
+
+#define EVALUATE_DEFAULT_FUEL 1000000
+
+// Compile-time evaluation of the whole program. C0 programs read no input, so running the
+// lowered IR from the entry determines everything they print and their exit code. The program
+// is run for a bounded number of instructions (its fuel); whatever part of it ran is replaced
+// by its outcome: the writes it did and, if it got to the end, its exit.
+
+void evaluate_program(IrFunction *fn, const CompilerOptions *options);
+
+#endif
@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "fold.h"
+
+// Tree being folded
+static Ast *tree = NULL;
+
+// --- Arithmetic ---
+
+// Evaluates a binary operator the way the RV32IM instructions do: +, - and * wrap around,
+// division by zero gives -1 and its remainder the dividend, INT_MIN / -1 overflows to INT_MIN
+static int32_t evaluate(TokenKind kind, int32_t a, int32_t b)
+{
+  uint32_t ua = (uint32_t)a;
+  uint32_t ub = (uint32_t)b;
+  switch (kind)
+  {
+  case OP_ADD:
+    return (int32_t)(ua + ub);
+  case OP_SUB:
+    return (int32_t)(ua - ub);
+  case OP_MUL:
+    return (int32_t)(ua * ub);
+  case OP_DIV:
+    if (b == 0)
+    {
+      return -1;
+    }
+    if (a == INT32_MIN && b == -1)
+    {
+      return INT32_MIN;
+    }
+    return a / b;
+  case OP_MOD:
+    if (b == 0)
+    {
+      return a;
+    }
+    if (a == INT32_MIN && b == -1)
+    {
+      return 0;
+    }
+    return a % b;
+  case CMP_EQ:
+    return a == b;
+  case CMP_NEQ:
+    return a != b;
+  case CMP_LESS:
+    return a < b;
+  case CMP_LESS_EQ:
+    return a <= b;
+  case CMP_GREATER:
+    return a > b;
+  case CMP_GREATER_EQ:
+    return a >= b;
+  default:
+    fprintf(stderr, "Fold Error: Unsupported operator '%s'\n", token_kind_name(kind));
+    exit(EXIT_FAILURE);
+  }
+}
+
+// --- Expressions ---
+
+static int is_constant(NodeId id)
+{
+  return ast_node(tree, id)->type == INT;
+}
+
+static int32_t constant_value(NodeId id)
+{
+  return ast_node(tree, id)->as.value;
+}
+
+// Turns node id into an INT literal (its children become unreachable)
+static NodeId make_constant(NodeId id, int32_t value)
+{
+  Node *node = ast_node(tree, id);
+  node->type = INT;
+  node->kind = KIND_NONE;
+  node->child1 = NIL_NODE;
+  node->child2 = NIL_NODE;
+  node->as.value = value;
+  return id;
+}
+
+// The comparison that holds for (b, a) when kind holds for (a, b)
+static TokenKind mirror_comparison(TokenKind kind)
+{
+  switch (kind)
+  {
+  case CMP_LESS:
+    return CMP_GREATER;
+  case CMP_LESS_EQ:
+    return CMP_GREATER_EQ;
+  case CMP_GREATER:
+    return CMP_LESS;
+  case CMP_GREATER_EQ:
+    return CMP_LESS_EQ;
+  default:
+    return kind; // ==, !=, + and * are symmetric
+  }
+}
+
+static int same_variable(NodeId a, NodeId b)
+{
+  const Node *left = ast_node(tree, a);
+  const Node *right = ast_node(tree, b);
+  return left->type == IDENTIFIER && right->type == IDENTIFIER && left->as.symbol == right->as.symbol;
+}
+
+// Rewrites id as "left + offset", spelled with SUB when the offset is negative so literals stay
+// non-negative, or just left when the offset is 0. id's right child must be an INT node.
+static NodeId make_offset(NodeId id, NodeId left, int32_t offset)
+{
+  if (offset == 0)
+  {
+    return left;
+  }
+  Node *node = ast_node(tree, id);
+  node->child1 = left;
+  if (offset < 0 && offset != INT32_MIN)
+  {
+    node->kind = OP_SUB;
+    ast_node(tree, node->child2)->as.value = -offset;
+  }
+  else
+  {
+    node->kind = OP_ADD;
+    ast_node(tree, node->child2)->as.value = offset;
+  }
+  return id;
+}
+
+// Folds the expression rooted at id and returns the node that replaces it
+static NodeId fold_expression(NodeId id)
+{
+  if (id == NIL_NODE)
+  {
+    return id;
+  }
+  Node *node = ast_node(tree, id);
+  if (node->type != OPERATOR && node->type != COMP)
+  {
+    return id;
+  }
+  NodeId left = fold_expression(node->child1);
+  NodeId right = fold_expression(node->child2);
+  node->child1 = left;
+  node->child2 = right;
+  TokenKind kind = (TokenKind)node->kind;
+
+  if (is_constant(left) && is_constant(right))
+  {
+    return make_constant(id, evaluate(kind, constant_value(left), constant_value(right)));
+  }
+
+  // Keep constants on the right, where the code generators turn them into immediates
+  if (is_constant(left) && kind != OP_SUB && kind != OP_DIV && kind != OP_MOD)
+  {
+    node->kind = (uint8_t)mirror_comparison(kind);
+    node->child1 = right;
+    node->child2 = left;
+    kind = (TokenKind)node->kind;
+    left = node->child1;
+    right = node->child2;
+  }
+
+  if (same_variable(left, right))
+  {
+    switch (kind)
+    {
+    case OP_SUB:
+    case OP_MOD: // x % x is 0 even for x == 0
+    case CMP_NEQ:
+    case CMP_LESS:
+    case CMP_GREATER:
+      return make_constant(id, 0);
+    case CMP_EQ:
+    case CMP_LESS_EQ:
+    case CMP_GREATER_EQ:
+      return make_constant(id, 1);
+    default:
+      return id;
+    }
+  }
+
+  if (!is_constant(right))
+  {
+    return id;
+  }
+  int32_t value = constant_value(right);
+  switch (kind)
+  {
+  case OP_ADD:
+  case OP_SUB: {
+    // (y + c1) + c2 -> y + (c1 + c2), and the same for every mix of + and -
+    uint32_t offset = kind == OP_ADD ? (uint32_t)value : 0u - (uint32_t)value;
+    const Node *inner = ast_node(tree, left);
+    if ((inner->kind == OP_ADD || inner->kind == OP_SUB) && is_constant(inner->child2))
+    {
+      uint32_t inner_value = (uint32_t)constant_value(inner->child2);
+      offset += inner->kind == OP_ADD ? inner_value : 0u - inner_value;
+      left = inner->child1;
+    }
+    return make_offset(id, left, (int32_t)offset);
+  }
+  case OP_MUL:
+    if (value == 0)
+    {
+      return make_constant(id, 0);
+    }
+    return value == 1 ? left : id;
+  case OP_DIV:
+    return value == 1 ? left : id;
+  case OP_MOD:
+    return value == 1 ? make_constant(id, 0) : id;
+  default:
+    return id;
+  }
+}
+
+// --- Statements ---
+
+static NodeId fold_statement_list(NodeId first);
+
+// True if the statement declares a variable anywhere inside it. Such code is never dropped:
+// a declaration reserves its variable for the rest of the program, even if it never runs.
+static int contains_declaration(NodeId id)
+{
+  if (id == NIL_NODE)
+  {
+    return 0;
+  }
+  const Node *node = ast_node(tree, id);
+  switch (node->kind)
+  {
+  case NODE_DECLARE_INT:
+    return 1;
+  case NODE_BLOCK:
+    for (NodeId statement = node->child1; statement != NIL_NODE; statement = ast_node(tree, statement)->next)
+    {
+      if (contains_declaration(statement))
+      {
+        return 1;
+      }
+    }
+    return 0;
+  case KW_IF:
+    return contains_declaration(node->child2) || contains_declaration(node->as.else_branch);
+  case KW_WHILE:
+    return contains_declaration(node->child2);
+  default:
+    return 0;
+  }
+}
+
+// Folds the expressions of one statement and its nested statements. Returns the statement
+// that replaces it: itself, the branch an IF with a constant condition always takes, or
+// NIL_NODE when the statement does nothing.
+static NodeId fold_statement(NodeId id)
+{
+  Node *node = ast_node(tree, id);
+  switch (node->kind)
+  {
+  case NODE_DECLARE_INT:
+  case NODE_ASSIGN:
+    node->child2 = fold_expression(node->child2);
+    return id;
+
+  case KW_EXIT:
+    node->child1 = fold_expression(node->child1);
+    return id;
+
+  case KW_WRITE:
+    node->child2 = fold_expression(node->child2);
+    return id;
+
+  case NODE_BLOCK:
+    node->child1 = fold_statement_list(node->child1);
+    return id;
+
+  case KW_IF: {
+    node->child1 = fold_expression(node->child1);
+    node->child2 = fold_statement_list(node->child2);
+    node->as.else_branch = fold_statement_list(node->as.else_branch);
+    if (!is_constant(node->child1))
+    {
+      return id;
+    }
+    int taken = constant_value(node->child1) != 0;
+    NodeId kept = taken ? node->child2 : node->as.else_branch;
+    NodeId dropped = taken ? node->as.else_branch : node->child2;
+    return contains_declaration(dropped) ? id : kept;
+  }
+
+  case KW_WHILE:
+    node->child1 = fold_expression(node->child1);
+    node->child2 = fold_statement_list(node->child2);
+    if (is_constant(node->child1) && constant_value(node->child1) == 0 && !contains_declaration(node->child2))
+    {
+      return NIL_NODE;
+    }
+    return id;
+
+  default:
+    return id;
+  }
+}
+
+// Folds a list of statements linked through next, splicing in replacements. Returns the new
+// first statement.
+static NodeId fold_statement_list(NodeId first)
+{
+  NodeId head = NIL_NODE;
+  NodeId last = NIL_NODE;
+  NodeId id = first;
+  while (id != NIL_NODE)
+  {
+    NodeId next = ast_node(tree, id)->next;
+    NodeId replacement = fold_statement(id);
+    if (replacement != NIL_NODE)
+    {
+      ast_node(tree, replacement)->next = NIL_NODE;
+      if (last == NIL_NODE)
+      {
+        head = replacement;
+      }
+      else
+      {
+        ast_node(tree, last)->next = replacement;
+      }
+      last = replacement;
+    }
+    id = next;
+  }
+  return head;
+}
+
+void fold_constants(Ast *ast)
+{
+  tree = ast;
+  Node *root = ast_node(ast, ast->root);
+  root->child1 = fold_statement_list(root->child1);
+  tree = NULL;
+}
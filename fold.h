@@ -0,0 +1,10 @@
+#ifndef FOLD_H_
+#define FOLD_H_
+
+#include "parser.h"
+
+// Constant folding and algebraic simplification on the AST, run right after parsing.
+// Rewrites the tree in place (it never adds nodes); both code generators see the result.
+void fold_constants(Ast *ast);
+
+#endif
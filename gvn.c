@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gvn.h"
+#include "cfg.h"
+
+#define EMPTY_SLOT ((uint32_t)UINT32_MAX)
+
+// --- Expression Table ---
+
+// An expression key: op applied to two operands, already rewritten to their leaders
+typedef struct {
+    uint8_t op;
+    Operand a, b;
+    VReg value; // vreg holding the result
+} Expression;
+
+// Open addressing with linear probing. Entries are only removed in the reverse order they went
+// in (when the dominator tree walk leaves their block), which restores the exact earlier state,
+// so removal needs no tombstones.
+static Expression *table = NULL;
+static uint32_t table_mask = 0;
+static uint32_t *scope_log = NULL; // Slots filled, in insertion order
+static uint32_t scope_count = 0;
+
+static uint32_t hash_expression(IrOp op, Operand a, Operand b) {
+    uint32_t h = (uint32_t)op * 0x9E3779B1u;
+    h = (h ^ (a.kind * 31u + (uint32_t)a.value)) * 0x85EBCA77u;
+    h = (h ^ (b.kind * 31u + (uint32_t)b.value)) * 0xC2B2AE3Du;
+    return h ^ (h >> 15);
+}
+
+static int same_operand(Operand x, Operand y) {
+    return x.kind == y.kind && x.value == y.value;
+}
+
+// Slot holding the expression, or the empty slot where it would go
+static uint32_t find_slot(IrOp op, Operand a, Operand b) {
+    uint32_t slot = hash_expression(op, a, b) & table_mask;
+    while (table[slot].value != NO_VREG) {
+        const Expression *entry = &table[slot];
+        if (entry->op == op && same_operand(entry->a, a) && same_operand(entry->b, b)) return slot;
+        slot = (slot + 1) & table_mask;
+    }
+    return slot;
+}
+
+// --- Leaders ---
+static Operand *replacement = NULL; // vreg -> value that replaces it, OPND_NONE if it stays
+
+// The value an operand stands for after the replacements so far
+static Operand leader(Operand operand) {
+    while (operand.kind == OPND_REG && replacement[operand.value].kind != OPND_NONE) {
+        operand = replacement[operand.value];
+    }
+    return operand;
+}
+
+static int is_commutative(IrOp op) {
+    return op == IR_ADD || op == IR_MUL || op == IR_SEQ || op == IR_SNE;
+}
+
+// Orders the operands of commutative ops and comparisons so that a + b and b + a, or a < b
+// and b > a, produce the same key: registers by number, immediates on the right
+static void canonicalize(IrInst *inst) {
+    IrOp op = (IrOp)inst->op;
+    if (!is_commutative(op) && !ir_is_compare(op)) return;
+    int swap = inst->a.kind == OPND_IMM ? inst->b.kind == OPND_REG
+                                        : inst->b.kind == OPND_REG && inst->b.value < inst->a.value;
+    if (!swap) return;
+    Operand left = inst->a;
+    inst->a = inst->b;
+    inst->b = left;
+    inst->op = (uint8_t)ir_swap_compare(op);
+}
+
+// --- Numbering ---
+
+// The single value a phi merges, ignoring the phi itself, or OPND_NONE if it merges several
+static Operand phi_single_value(const IrInst *phi) {
+    Operand value = ir_none();
+    for (uint32_t k = 0; k < phi->arg_count; k++) {
+        Operand arg = leader(phi->args[k]);
+        if (arg.kind == OPND_REG && (VReg)arg.value == phi->dst) continue;
+        if (value.kind == OPND_NONE) {
+            value = arg;
+        } else if (!same_operand(value, arg)) {
+            return ir_none();
+        }
+    }
+    return value;
+}
+
+// A phi of block b with the same arguments as an earlier phi of b, or NULL
+static const IrInst *equal_phi(const IrBlock *block, uint32_t index) {
+    const IrInst *phi = &block->insts[index];
+    for (uint32_t j = 0; j < index; j++) {
+        const IrInst *other = &block->insts[j];
+        if (other->op != IR_PHI) continue;
+        uint32_t k = 0;
+        while (k < phi->arg_count && same_operand(leader(phi->args[k]), leader(other->args[k]))) k++;
+        if (k == phi->arg_count) return other;
+    }
+    return NULL;
+}
+
+// Numbers the instructions of block b, deleting those whose value is already available
+static void number_block(IrFunction *fn, uint32_t b) {
+    IrBlock *block = &fn->blocks[b];
+    for (uint32_t i = 0; i < block->count; i++) {
+        IrInst *inst = &block->insts[i];
+        switch (inst->op) {
+            case IR_NOP:
+                break;
+
+            case IR_PHI: {
+                Operand value = phi_single_value(inst);
+                const IrInst *twin = value.kind == OPND_NONE ? equal_phi(block, i) : NULL;
+                if (twin != NULL) value = ir_reg(twin->dst);
+                if (value.kind == OPND_NONE) break;
+                replacement[inst->dst] = value;
+                inst->op = IR_NOP;
+                break;
+            }
+
+            case IR_COPY:
+                replacement[inst->dst] = leader(inst->a);
+                inst->op = IR_NOP;
+                break;
+
+            default: {
+                inst->a = leader(inst->a);
+                inst->b = leader(inst->b);
+                if (!ir_is_binary((IrOp)inst->op)) break;
+                canonicalize(inst);
+                uint32_t slot = find_slot((IrOp)inst->op, inst->a, inst->b);
+                if (table[slot].value != NO_VREG) {
+                    replacement[inst->dst] = ir_reg(table[slot].value);
+                    inst->op = IR_NOP;
+                    break;
+                }
+                table[slot].op = inst->op;
+                table[slot].a = inst->a;
+                table[slot].b = inst->b;
+                table[slot].value = inst->dst;
+                scope_log[scope_count++] = slot;
+                break;
+            }
+        }
+    }
+    block->term.a = leader(block->term.a);
+    block->term.b = leader(block->term.b);
+}
+
+// Walks the dominator tree without recursion, like SSA renaming. Each stack entry is
+// block * 2 (enter) or block * 2 + 1 (leave, forgetting the block's expressions).
+static void number_dominator_tree(IrFunction *fn, const Cfg *cfg, Arena *arena) {
+    uint32_t n = fn->block_count;
+    uint32_t *stack = arena_alloc(arena, (2 * n + 1) * sizeof(uint32_t));
+    uint32_t *scope_mark = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    uint32_t depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0) {
+        uint32_t entry = stack[--depth];
+        uint32_t b = entry >> 1;
+        if (entry & 1) {
+            while (scope_count > scope_mark[b]) table[scope_log[--scope_count]].value = NO_VREG;
+            continue;
+        }
+        scope_mark[b] = scope_count;
+        number_block(fn, b);
+        stack[depth++] = b * 2 + 1;
+        for (uint32_t c = cfg->dom_child_start[b + 1]; c-- > cfg->dom_child_start[b];) {
+            stack[depth++] = cfg->dom_children[c] * 2;
+        }
+    }
+}
+
+// Phi arguments on back edges, and uses of phis folded after their block was numbered,
+// still name deleted vregs: point everything at the leaders and drop the NOPs
+static void rewrite_uses(IrFunction *fn) {
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        IrBlock *block = &fn->blocks[b];
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < block->count; i++) {
+            IrInst *inst = &block->insts[i];
+            if (inst->op == IR_NOP) continue;
+            if (inst->op == IR_PHI) {
+                for (uint32_t k = 0; k < inst->arg_count; k++) inst->args[k] = leader(inst->args[k]);
+            } else {
+                inst->a = leader(inst->a);
+                inst->b = leader(inst->b);
+            }
+            block->insts[kept++] = *inst;
+        }
+        block->count = kept;
+        block->term.a = leader(block->term.a);
+        block->term.b = leader(block->term.b);
+    }
+}
+
+// --- Pass ---
+
+// Runs on SSA form: a value computed once keeps its vreg, so an expression is available
+// wherever its first evaluation dominates. (Repeated loads of an unchanged variable are
+// already one vreg after mem2reg.) DIV and REM cannot trap on RV32, so they are numbered too.
+void gvn_eliminate(IrFunction *fn, const CompilerOptions *options) {
+    (void)options;
+    Arena *arena = fn->arena;
+    Cfg *cfg = cfg_build(fn, arena);
+
+    uint32_t expressions = 0;
+    for (uint32_t b = 0; b < fn->block_count; b++) expressions += fn->blocks[b].count;
+    uint32_t capacity = 16;
+    while (capacity < 2 * expressions) capacity *= 2;
+    table = arena_calloc(arena, capacity, sizeof(Expression));
+    table_mask = capacity - 1;
+    scope_log = arena_alloc(arena, (expressions + 1) * sizeof(uint32_t));
+    scope_count = 0;
+    replacement = arena_calloc(arena, fn->vreg_count, sizeof(Operand));
+
+    number_dominator_tree(fn, cfg, arena);
+    rewrite_uses(fn);
+
+    table = NULL;
+    scope_log = NULL;
+    replacement = NULL;
+}
@@ -0,0 +1,13 @@
+#ifndef GVN_H_
+#define GVN_H_
+
+#include "ir.h"
+#include "pipeline.h"
+
+// Dominator-based global value numbering over SSA form. An instruction computing the same
+// operation on the same values as one in a dominating position is deleted and its uses read
+// the earlier result; copies and phis that merge a single value are folded away as well.
+
+void gvn_eliminate(IrFunction *fn, const CompilerOptions *options);
+
+#endif
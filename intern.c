@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "intern.h"
+#include "arena.h"
+#include "./hashmap/hashmap.h"
+
+#define INITIAL_INTERN_CAPACITY 256
+
+// --- Global Intern Pool ---
+// Every distinct identifier spelling is stored once and numbered densely from 0,
+// so later phases can index plain arrays by SymbolId instead of hashing names.
+
+static struct hashmap_s symbol_map; // spelling -> SymbolId + 1 (so that NULL means "absent")
+static int symbol_map_ready = 0;
+static Arena symbol_arena;          // Owns the spellings
+static char **symbol_names = NULL;  // SymbolId -> NUL-terminated spelling
+static size_t *symbol_lengths = NULL;
+static size_t symbols_used = 0;
+static size_t symbols_capacity = 0;
+
+static void intern_out_of_memory(void)
+{
+  fprintf(stderr, "Error: Memory allocation failed in intern pool\n");
+  exit(EXIT_FAILURE);
+}
+
+// Returns the symbol for text[0, length), adding it to the pool on first sight
+SymbolId intern(const char *text, size_t length)
+{
+  if (!symbol_map_ready)
+  {
+    if (hashmap_create(INITIAL_INTERN_CAPACITY, &symbol_map) != 0)
+    {
+      intern_out_of_memory();
+    }
+    arena_init(&symbol_arena, 16 * 1024);
+    symbol_map_ready = 1;
+  }
+
+  void *found = hashmap_get(&symbol_map, text, (hashmap_uint32_t)length);
+  if (found != NULL)
+  {
+    return (SymbolId)((uintptr_t)found - 1);
+  }
+
+  if (symbols_used == symbols_capacity)
+  {
+    symbols_capacity = symbols_capacity ? symbols_capacity * 2 : INITIAL_INTERN_CAPACITY;
+    symbol_names = realloc(symbol_names, sizeof(char *) * symbols_capacity);
+    symbol_lengths = realloc(symbol_lengths, sizeof(size_t) * symbols_capacity);
+    if (symbol_names == NULL || symbol_lengths == NULL)
+    {
+      intern_out_of_memory();
+    }
+  }
+
+  // The pool owns its copy: the hashmap keys must outlive the source text
+  char *name = arena_strndup(&symbol_arena, text, length);
+
+  SymbolId symbol = (SymbolId)symbols_used++;
+  symbol_names[symbol] = name;
+  symbol_lengths[symbol] = length;
+  if (hashmap_put(&symbol_map, name, (hashmap_uint32_t)length, (void *)((uintptr_t)symbol + 1)) != 0)
+  {
+    intern_out_of_memory();
+  }
+  return symbol;
+}
+
+const char *symbol_name(SymbolId symbol)
+{
+  return symbol < symbols_used ? symbol_names[symbol] : "<no symbol>";
+}
+
+size_t symbol_length(SymbolId symbol)
+{
+  return symbol < symbols_used ? symbol_lengths[symbol] : 0;
+}
+
+// Number of distinct symbols; valid SymbolIds are 0 .. symbol_count() - 1
+size_t symbol_count(void)
+{
+  return symbols_used;
+}
+
+// Releases every interned spelling; previously returned SymbolIds become invalid
+void intern_reset(void)
+{
+  free(symbol_names);
+  free(symbol_lengths);
+  symbol_names = NULL;
+  symbol_lengths = NULL;
+  symbols_used = 0;
+  symbols_capacity = 0;
+  if (symbol_map_ready)
+  {
+    hashmap_destroy(&symbol_map);
+    arena_destroy(&symbol_arena);
+    symbol_map_ready = 0;
+  }
+}
@@ -0,0 +1,17 @@
+#ifndef INTERN_H_
+#define INTERN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t SymbolId;
+
+#define NO_SYMBOL ((SymbolId)UINT32_MAX)
+
+SymbolId intern(const char *text, size_t length);
+const char *symbol_name(SymbolId symbol);
+size_t symbol_length(SymbolId symbol);
+size_t symbol_count(void);
+void intern_reset(void);
+
+#endif
@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ir.h"
+
+#define INITIAL_BLOCKS 16
+#define INITIAL_INSTS 8
+#define INITIAL_VARS 16
+
+// --- Construction ---
+
+IrFunction *ir_function_new(Arena *arena) {
+    IrFunction *fn = arena_calloc(arena, 1, sizeof(IrFunction));
+    fn->arena = arena;
+    fn->vreg_count = 1; // vreg 0 is NO_VREG
+    return fn;
+}
+
+// Appends an empty block and returns its index. Block pointers are invalidated.
+uint32_t ir_new_block(IrFunction *fn) {
+    if (fn->block_count == fn->block_capacity) {
+        uint32_t capacity = fn->block_capacity ? fn->block_capacity * 2 : INITIAL_BLOCKS;
+        fn->blocks = arena_grow(fn->arena, fn->blocks, fn->block_capacity * sizeof(IrBlock), capacity * sizeof(IrBlock));
+        fn->block_capacity = capacity;
+    }
+    uint32_t id = fn->block_count++;
+    memset(&fn->blocks[id], 0, sizeof(IrBlock));
+    fn->blocks[id].term.target[0] = NO_BLOCK;
+    fn->blocks[id].term.target[1] = NO_BLOCK;
+    return id;
+}
+
+VReg ir_new_vreg(IrFunction *fn) {
+    return fn->vreg_count++;
+}
+
+// Allocates a fresh variable slot; redeclaring a name gets a new slot, like a new stack offset did
+uint32_t ir_new_var(IrFunction *fn, SymbolId name) {
+    if (fn->var_count == fn->var_capacity) {
+        uint32_t capacity = fn->var_capacity ? fn->var_capacity * 2 : INITIAL_VARS;
+        fn->vars = arena_grow(fn->arena, fn->vars, fn->var_capacity * sizeof(SymbolId), capacity * sizeof(SymbolId));
+        fn->var_capacity = capacity;
+    }
+    fn->vars[fn->var_count] = name;
+    return fn->var_count++;
+}
+
+// Appends an instruction to block and returns it for the caller to fill in.
+// The pointer is only valid until the next instruction is added to the same block.
+IrInst *ir_append(IrFunction *fn, uint32_t block, IrOp op) {
+    IrBlock *b = &fn->blocks[block];
+    if (b->count == b->capacity) {
+        uint32_t capacity = b->capacity ? b->capacity * 2 : INITIAL_INSTS;
+        b->insts = arena_grow(fn->arena, b->insts, b->capacity * sizeof(IrInst), capacity * sizeof(IrInst));
+        b->capacity = capacity;
+    }
+    IrInst *inst = &b->insts[b->count++];
+    memset(inst, 0, sizeof(*inst));
+    inst->op = (uint8_t)op;
+    return inst;
+}
+
+void ir_set_jump(IrFunction *fn, uint32_t block, uint32_t target) {
+    IrTerm *term = &fn->blocks[block].term;
+    memset(term, 0, sizeof(*term));
+    term->kind = TERM_JUMP;
+    term->target[0] = target;
+    term->target[1] = NO_BLOCK;
+}
+
+void ir_set_branch(IrFunction *fn, uint32_t block, IrOp cmp, Operand a, Operand b, uint32_t if_true, uint32_t if_false) {
+    IrTerm *term = &fn->blocks[block].term;
+    term->kind = TERM_BRANCH;
+    term->cmp = (uint8_t)cmp;
+    term->a = a;
+    term->b = b;
+    term->target[0] = if_true;
+    term->target[1] = if_false;
+}
+
+void ir_set_exit(IrFunction *fn, uint32_t block, Operand code) {
+    IrTerm *term = &fn->blocks[block].term;
+    memset(term, 0, sizeof(*term));
+    term->kind = TERM_EXIT;
+    term->a = code;
+    term->target[0] = NO_BLOCK;
+    term->target[1] = NO_BLOCK;
+}
+
+void ir_set_return(IrFunction *fn, uint32_t block) {
+    IrTerm *term = &fn->blocks[block].term;
+    memset(term, 0, sizeof(*term));
+    term->kind = TERM_RETURN;
+    term->target[0] = NO_BLOCK;
+    term->target[1] = NO_BLOCK;
+}
+
+// --- Queries ---
+
+// Writes the block's successors to out and returns how many there are (0-2)
+uint32_t ir_successors(const IrBlock *block, uint32_t out[2]) {
+    switch (block->term.kind) {
+        case TERM_JUMP:
+            out[0] = block->term.target[0];
+            return 1;
+        case TERM_BRANCH:
+            out[0] = block->term.target[0];
+            if (block->term.target[1] == block->term.target[0]) return 1;
+            out[1] = block->term.target[1];
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+// Comparison that holds exactly when cmp does not
+IrOp ir_invert_compare(IrOp cmp) {
+    switch (cmp) {
+        case IR_SEQ: return IR_SNE;
+        case IR_SNE: return IR_SEQ;
+        case IR_SLT: return IR_SGE;
+        case IR_SGE: return IR_SLT;
+        case IR_SLE: return IR_SGT;
+        case IR_SGT: return IR_SLE;
+        default: return cmp;
+    }
+}
+
+// Comparison that holds for (b, a) exactly when cmp holds for (a, b)
+IrOp ir_swap_compare(IrOp cmp) {
+    switch (cmp) {
+        case IR_SLT: return IR_SGT;
+        case IR_SGT: return IR_SLT;
+        case IR_SLE: return IR_SGE;
+        case IR_SGE: return IR_SLE;
+        default: return cmp;
+    }
+}
+
+// Value of a op b for an arithmetic or comparison op, as the RV32IM instructions compute it:
+// +, - and * wrap around, division by zero gives -1 and its remainder the dividend, and
+// INT_MIN / -1 overflows to INT_MIN with remainder 0
+int32_t ir_evaluate(IrOp op, int32_t a, int32_t b) {
+    uint32_t ua = (uint32_t)a, ub = (uint32_t)b;
+    switch (op) {
+        case IR_ADD: return (int32_t)(ua + ub);
+        case IR_SUB: return (int32_t)(ua - ub);
+        case IR_MUL: return (int32_t)(ua * ub);
+        case IR_DIV:
+            if (b == 0) return -1;
+            if (a == INT32_MIN && b == -1) return INT32_MIN;
+            return a / b;
+        case IR_REM:
+            if (b == 0) return a;
+            if (a == INT32_MIN && b == -1) return 0;
+            return a % b;
+        case IR_SEQ: return a == b;
+        case IR_SNE: return a != b;
+        case IR_SLT: return a < b;
+        case IR_SLE: return a <= b;
+        case IR_SGT: return a > b;
+        case IR_SGE: return a >= b;
+        default:
+            fprintf(stderr, "CodeGen Error: Cannot evaluate '%s'\n", ir_op_name(op));
+            exit(EXIT_FAILURE);
+    }
+}
+
+// --- Printing ---
+
+static const char *const ir_op_names[IR_OP_COUNT] = {
+    [IR_NOP] = "nop",
+    [IR_COPY] = "copy",
+    [IR_ADD] = "add",
+    [IR_SUB] = "sub",
+    [IR_MUL] = "mul",
+    [IR_DIV] = "div",
+    [IR_REM] = "rem",
+    [IR_SEQ] = "seq",
+    [IR_SNE] = "sne",
+    [IR_SLT] = "slt",
+    [IR_SLE] = "sle",
+    [IR_SGT] = "sgt",
+    [IR_SGE] = "sge",
+    [IR_LOAD] = "load",
+    [IR_STORE] = "store",
+    [IR_WRITE] = "write",
+    [IR_PHI] = "phi",
+};
+
+const char *ir_op_name(IrOp op) {
+    return op < IR_OP_COUNT ? ir_op_names[op] : "?";
+}
+
+static void dump_operand(Operand operand, FILE *file) {
+    switch (operand.kind) {
+        case OPND_REG: fprintf(file, "v%u", (unsigned)operand.value); break;
+        case OPND_IMM: fprintf(file, "%d", operand.value); break;
+        default: fprintf(file, "_"); break;
+    }
+}
+
+// Variables print as name.slot so that redeclarations stay distinguishable
+static void dump_var(const IrFunction *fn, uint32_t var, FILE *file) {
+    fprintf(file, "%s.%u", symbol_name(fn->vars[var]), (unsigned)var);
+}
+
+static void dump_inst(const IrFunction *fn, const IrInst *inst, FILE *file) {
+    fprintf(file, "  ");
+    if (inst->dst != NO_VREG) {
+        fprintf(file, "v%u = ", (unsigned)inst->dst);
+    }
+    fprintf(file, "%s", ir_op_name(inst->op));
+    switch (inst->op) {
+        case IR_LOAD:
+            fprintf(file, " ");
+            dump_var(fn, inst->var, file);
+            break;
+        case IR_STORE:
+            fprintf(file, " ");
+            dump_var(fn, inst->var, file);
+            fprintf(file, ", ");
+            dump_operand(inst->a, file);
+            break;
+        case IR_PHI:
+            for (uint32_t i = 0; i < inst->arg_count; i++) {
+                fprintf(file, i ? ", " : " ");
+                dump_operand(inst->args[i], file);
+            }
+            break;
+        default:
+            if (inst->a.kind != OPND_NONE) {
+                fprintf(file, " ");
+                dump_operand(inst->a, file);
+            }
+            if (inst->b.kind != OPND_NONE) {
+                fprintf(file, ", ");
+                dump_operand(inst->b, file);
+            }
+            break;
+    }
+    fprintf(file, "\n");
+}
+
+static void dump_term(const IrTerm *term, FILE *file) {
+    switch (term->kind) {
+        case TERM_JUMP:
+            fprintf(file, "  jump b%u\n", (unsigned)term->target[0]);
+            break;
+        case TERM_BRANCH:
+            fprintf(file, "  br %s ", ir_op_name(term->cmp));
+            dump_operand(term->a, file);
+            fprintf(file, ", ");
+            dump_operand(term->b, file);
+            fprintf(file, " -> b%u, b%u\n", (unsigned)term->target[0], (unsigned)term->target[1]);
+            break;
+        case TERM_EXIT:
+            fprintf(file, "  exit ");
+            dump_operand(term->a, file);
+            fprintf(file, "\n");
+            break;
+        case TERM_RETURN:
+            fprintf(file, "  return\n");
+            break;
+        default:
+            fprintf(file, "  <no terminator>\n");
+            break;
+    }
+}
+
+// Prints the function in a readable text form, headed by the pipeline stage that produced it
+void ir_dump(const IrFunction *fn, FILE *file, const char *stage) {
+    fprintf(file, "=== IR after %s: %u blocks, %u vregs, %u variables ===\n", stage, (unsigned)fn->block_count,
+            (unsigned)(fn->vreg_count - 1), (unsigned)fn->var_count);
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        fprintf(file, "b%u:\n", (unsigned)b);
+        for (uint32_t i = 0; i < block->count; i++) {
+            if (block->insts[i].op != IR_NOP) {
+                dump_inst(fn, &block->insts[i], file);
+            }
+        }
+        dump_term(&block->term, file);
+    }
+    fprintf(file, "\n");
+}
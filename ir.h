@@ -0,0 +1,144 @@
+#ifndef IR_H_
+#define IR_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "intern.h"
+#include "arena.h"
+
+// Linear three-address IR: a function is a list of basic blocks, each holding a straight-line
+// sequence of instructions and ending in exactly one terminator. Values live in virtual
+// registers (vregs); source variables live in numbered variable slots and are accessed with
+// explicit LOAD/STORE until a pass promotes them.
+
+typedef uint32_t VReg; // Virtual register number; 0 is never a valid vreg
+
+#define NO_VREG ((VReg)0)
+#define NO_BLOCK ((uint32_t)UINT32_MAX)
+
+typedef enum {
+    OPND_NONE,
+    OPND_REG, // value is a VReg
+    OPND_IMM, // value is a 32-bit constant
+} OperandKind;
+
+typedef struct {
+    uint8_t kind;  // OperandKind
+    int32_t value;
+} Operand;
+
+typedef enum {
+    IR_NOP,   // Deleted instruction, skipped by every consumer
+    IR_COPY,  // dst = a
+    // Arithmetic: dst = a op b (32-bit wraparound; DIV/REM follow the RISC-V M rules)
+    IR_ADD,
+    IR_SUB,
+    IR_MUL,
+    IR_DIV,
+    IR_REM,
+    // Comparisons: dst = (a cmp b) ? 1 : 0. Also used as the condition of TERM_BRANCH.
+    IR_SEQ,
+    IR_SNE,
+    IR_SLT,
+    IR_SLE,
+    IR_SGT,
+    IR_SGE,
+    // Memory
+    IR_LOAD,  // dst = variable slot var
+    IR_STORE, // variable slot var = a
+    // Effects
+    IR_WRITE, // print a
+    IR_PHI,   // dst = args[i] when entered from the i-th predecessor
+    IR_OP_COUNT,
+} IrOp;
+
+typedef struct {
+    uint8_t op;          // IrOp
+    VReg dst;            // Defined vreg, NO_VREG if none
+    Operand a, b;        // Source operands
+    uint32_t var;        // Variable slot of LOAD/STORE
+    Operand *args;       // PHI incoming values, one per predecessor (in predecessor order)
+    uint32_t arg_count;
+} IrInst;
+
+typedef enum {
+    TERM_NONE,   // Block under construction
+    TERM_JUMP,   // goto target[0]
+    TERM_BRANCH, // if (a cmp b) goto target[0] else goto target[1]
+    TERM_EXIT,   // exit(a)
+    TERM_RETURN, // leave main normally
+} TermKind;
+
+typedef struct {
+    uint8_t kind;       // TermKind
+    uint8_t cmp;        // Comparison of TERM_BRANCH (IR_SEQ .. IR_SGE)
+    Operand a, b;
+    uint32_t target[2]; // Successor blocks: taken/jump target first, fallthrough second
+} IrTerm;
+
+typedef struct {
+    IrInst *insts;
+    uint32_t count;
+    uint32_t capacity;
+    IrTerm term;
+    uint32_t *preds;     // Predecessor blocks (see cfg_compute_predecessors); PHI args follow this order
+    uint32_t pred_count;
+} IrBlock;
+
+typedef struct {
+    IrBlock *blocks;    // blocks[0] is the entry block
+    uint32_t block_count;
+    uint32_t block_capacity;
+    uint32_t vreg_count; // Number of vregs allocated so far, plus one (NO_VREG)
+    SymbolId *vars;      // Variable slot -> declared name
+    uint32_t var_count;
+    uint32_t var_capacity;
+    Arena *arena;        // Owns everything above
+} IrFunction;
+
+// --- Operands ---
+static inline Operand ir_reg(VReg vreg) {
+    Operand operand = { OPND_REG, (int32_t)vreg };
+    return operand;
+}
+
+static inline Operand ir_imm(int32_t value) {
+    Operand operand = { OPND_IMM, value };
+    return operand;
+}
+
+static inline Operand ir_none(void) {
+    Operand operand = { OPND_NONE, 0 };
+    return operand;
+}
+
+static inline int ir_is_compare(IrOp op) {
+    return op >= IR_SEQ && op <= IR_SGE;
+}
+
+static inline int ir_is_binary(IrOp op) {
+    return op >= IR_ADD && op <= IR_SGE;
+}
+
+// --- Construction ---
+IrFunction *ir_function_new(Arena *arena);
+uint32_t ir_new_block(IrFunction *fn);
+VReg ir_new_vreg(IrFunction *fn);
+uint32_t ir_new_var(IrFunction *fn, SymbolId name);
+IrInst *ir_append(IrFunction *fn, uint32_t block, IrOp op);
+void ir_set_jump(IrFunction *fn, uint32_t block, uint32_t target);
+void ir_set_branch(IrFunction *fn, uint32_t block, IrOp cmp, Operand a, Operand b, uint32_t if_true, uint32_t if_false);
+void ir_set_exit(IrFunction *fn, uint32_t block, Operand code);
+void ir_set_return(IrFunction *fn, uint32_t block);
+
+// --- Queries ---
+uint32_t ir_successors(const IrBlock *block, uint32_t out[2]);
+IrOp ir_invert_compare(IrOp cmp);
+IrOp ir_swap_compare(IrOp cmp);
+int32_t ir_evaluate(IrOp op, int32_t a, int32_t b);
+
+// --- Printing ---
+const char *ir_op_name(IrOp op);
+void ir_dump(const IrFunction *fn, FILE *file, const char *stage);
+
+#endif
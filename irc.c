@@ -0,0 +1,658 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "regalloc.h"
+#include "cfg.h"
+#include "dataflow.h"
+
+// Iterated register coalescing (George and Appel): Chaitin-Briggs graph coloring where copies
+// between vregs are coalesced as long as Briggs' test says the merged node stays colorable,
+// and given up (frozen) only when nothing else can be simplified. Spilled vregs leave the graph
+// and the coloring is redone without them; the printer reloads them through its scratch
+// registers, so no spill code has to be inserted into the IR.
+
+// Colors in order of preference: the caller-saved temporaries, then the callee-saved registers
+static const Reg colors[] = { REG_T3, REG_T4, REG_T5, REG_T6, REG_S1, REG_S2, REG_S3, REG_S4,
+                              REG_S5, REG_S6, REG_S7, REG_S8, REG_S9, REG_S10, REG_S11 };
+
+#define K ((uint32_t)(sizeof(colors) / sizeof(colors[0])))
+#define TEMP_COLORS 4          // colors[0..TEMP_COLORS) are clobbered by the printf call of WRITE
+#define PRECOLORED TEMP_COLORS // Nodes 0..3 stand for t3-t6; vreg v is node PRECOLORED + v
+#define NO_COLOR ((uint8_t)0xFF)
+#define INFINITE_DEGREE ((uint32_t)UINT32_MAX / 2)
+#define MAX_LOOP_WEIGHT 6      // Spill costs count a use in a loop nest of depth d 10^d times, up to 10^6
+
+typedef enum {
+    NODE_ABSENT,     // Not in the graph: unused or spilled in an earlier round
+    NODE_PRECOLORED,
+    NODE_SIMPLIFY,   // Low degree, not move-related
+    NODE_FREEZE,     // Low degree, move-related
+    NODE_SPILL,      // High degree
+    NODE_SELECT,     // Removed from the graph, on the select stack
+    NODE_COALESCED,  // Merged into alias[n]
+    NODE_COLORED,
+    NODE_SPILLED,
+} NodeState;
+
+typedef enum {
+    MOVE_WORKLIST,    // May be coalescable
+    MOVE_ACTIVE,      // Not coalescable yet
+    MOVE_COALESCED,
+    MOVE_CONSTRAINED, // Both ends interfere
+    MOVE_FROZEN,      // Given up on
+} MoveState;
+
+typedef struct {
+    uint32_t *items;
+    uint32_t count;
+    uint32_t capacity;
+} NodeList;
+
+typedef struct {
+    uint32_t dst;
+    uint32_t src;
+} Move;
+
+typedef struct {
+    double priority; // Spill cost per interference edge when pushed
+    uint32_t node;
+} SpillCandidate;
+
+// Binary min-heap of spill candidates
+typedef struct {
+    SpillCandidate *items;
+    uint32_t count;
+    uint32_t capacity;
+} SpillHeap;
+
+typedef struct {
+    Arena *arena;
+    uint32_t node_count;
+
+    // Interference: a hash set of node pairs, plus adjacency lists for the vreg nodes
+    uint64_t *edges;
+    uint32_t edge_capacity; // Power of two
+    uint32_t edge_shift;    // 64 - log2(edge_capacity): hashes take the top bits of the product
+    uint32_t edge_count;
+    NodeList *adjacent;
+    uint32_t *degree;
+
+    Move *moves;
+    uint32_t move_count;
+    uint8_t *move_state;
+    NodeList *node_moves; // Moves each node takes part in
+
+    uint8_t *state;
+    uint32_t *alias;
+    uint8_t *color;
+    double *cost;
+
+    // Worklists are stacks (the spill worklist a heap) with lazy deletion: an entry counts only
+    // while its node or move is still in the matching state.
+    NodeList simplify;
+    NodeList freeze;
+    SpillHeap spill;
+    NodeList moves_ready;
+    NodeList select;
+
+    uint32_t *stamp; // Union of two adjacency lists in the Briggs test
+    uint32_t stamp_id;
+} Graph;
+
+static void list_push(Arena *arena, NodeList *list, uint32_t item) {
+    if (list->count == list->capacity) {
+        uint32_t capacity = list->capacity ? list->capacity * 2 : 4;
+        list->items = arena_grow(arena, list->items, list->capacity * sizeof(uint32_t), capacity * sizeof(uint32_t));
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = item;
+}
+
+static double spill_priority(const Graph *graph, uint32_t node) {
+    return graph->cost[node] / graph->degree[node];
+}
+
+static void heap_push(Arena *arena, SpillHeap *heap, double priority, uint32_t node) {
+    if (heap->count == heap->capacity) {
+        uint32_t capacity = heap->capacity ? heap->capacity * 2 : 16;
+        heap->items = arena_grow(arena, heap->items, heap->capacity * sizeof(SpillCandidate), capacity * sizeof(SpillCandidate));
+        heap->capacity = capacity;
+    }
+    uint32_t i = heap->count++;
+    while (i > 0 && heap->items[(i - 1) / 2].priority > priority) {
+        heap->items[i] = heap->items[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap->items[i] = (SpillCandidate){ priority, node };
+}
+
+static SpillCandidate heap_pop(SpillHeap *heap) {
+    SpillCandidate top = heap->items[0];
+    SpillCandidate last = heap->items[--heap->count];
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && heap->items[child + 1].priority < heap->items[child].priority) child++;
+        if (heap->items[child].priority >= last.priority) break;
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    if (heap->count > 0) heap->items[i] = last;
+    return top;
+}
+
+// --- Interference Graph ---
+
+static uint32_t edge_slot(const Graph *graph, uint64_t key) {
+    uint32_t mask = graph->edge_capacity - 1;
+    uint32_t slot = (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> graph->edge_shift);
+    while (graph->edges[slot] != 0 && graph->edges[slot] != key) slot = (slot + 1) & mask;
+    return slot;
+}
+
+// Pairs are keyed smaller node first; node ids differ, so no key is 0 (the empty marker)
+static uint64_t edge_key(uint32_t u, uint32_t v) {
+    return u < v ? ((uint64_t)u << 32) | v : ((uint64_t)v << 32) | u;
+}
+
+static int interferes(const Graph *graph, uint32_t u, uint32_t v) {
+    uint64_t key = edge_key(u, v);
+    return graph->edges[edge_slot(graph, key)] == key;
+}
+
+static void add_edge(Graph *graph, uint32_t u, uint32_t v) {
+    if (u == v) return;
+    uint64_t key = edge_key(u, v);
+    uint32_t slot = edge_slot(graph, key);
+    if (graph->edges[slot] == key) return;
+    graph->edges[slot] = key;
+    graph->edge_count++;
+    if (graph->state[u] != NODE_PRECOLORED) {
+        list_push(graph->arena, &graph->adjacent[u], v);
+        graph->degree[u]++;
+    }
+    if (graph->state[v] != NODE_PRECOLORED) {
+        list_push(graph->arena, &graph->adjacent[v], u);
+        graph->degree[v]++;
+    }
+
+    // Keep the load factor under one half
+    if (graph->edge_count * 2 > graph->edge_capacity) {
+        uint64_t *old = graph->edges;
+        uint32_t old_capacity = graph->edge_capacity;
+        graph->edge_capacity *= 2;
+        graph->edge_shift--;
+        graph->edges = arena_calloc(graph->arena, graph->edge_capacity, sizeof(uint64_t));
+        for (uint32_t i = 0; i < old_capacity; i++) {
+            if (old[i] != 0) graph->edges[edge_slot(graph, old[i])] = old[i];
+        }
+    }
+}
+
+// The vregs live at a point of a block, as a sparse set for constant-time insert and remove
+typedef struct {
+    uint32_t *members;
+    uint32_t *index; // node -> position in members, valid when members[index[n]] == n
+    uint32_t count;
+} LiveSet;
+
+static int live_contains(const LiveSet *live, uint32_t node) {
+    uint32_t i = live->index[node];
+    return i < live->count && live->members[i] == node;
+}
+
+static void live_insert(LiveSet *live, uint32_t node) {
+    if (live_contains(live, node)) return;
+    live->index[node] = live->count;
+    live->members[live->count++] = node;
+}
+
+static void live_remove(LiveSet *live, uint32_t node) {
+    if (!live_contains(live, node)) return;
+    uint32_t i = live->index[node];
+    uint32_t last = live->members[--live->count];
+    live->members[i] = last;
+    live->index[last] = i;
+}
+
+static void live_use(const Graph *graph, LiveSet *live, Operand operand) {
+    if (operand.kind == OPND_REG && graph->state[PRECOLORED + operand.value] != NODE_ABSENT) {
+        live_insert(live, PRECOLORED + operand.value);
+    }
+}
+
+static void add_cost(Graph *graph, Operand operand, double weight) {
+    if (operand.kind == OPND_REG) graph->cost[PRECOLORED + operand.value] += weight;
+}
+
+// Collects the live-out vregs of every block as (block, vreg) pairs
+typedef struct {
+    Arena *arena;
+    uint32_t *blocks;
+    VReg *vregs;
+    uint32_t count;
+    uint32_t capacity;
+} LiveOutPairs;
+
+static void collect_live_out(void *context, VReg vreg, uint32_t block, int live_out) {
+    LiveOutPairs *pairs = context;
+    if (!live_out) return;
+    if (pairs->count == pairs->capacity) {
+        uint32_t capacity = pairs->capacity ? pairs->capacity * 2 : 64;
+        pairs->blocks = arena_grow(pairs->arena, pairs->blocks, pairs->capacity * sizeof(uint32_t), capacity * sizeof(uint32_t));
+        pairs->vregs = arena_grow(pairs->arena, pairs->vregs, pairs->capacity * sizeof(VReg), capacity * sizeof(VReg));
+        pairs->capacity = capacity;
+    }
+    pairs->blocks[pairs->count] = block;
+    pairs->vregs[pairs->count] = vreg;
+    pairs->count++;
+}
+
+// Walks every block backwards from its live-out set: a definition interferes with everything
+// live after it (except the source of a copy, which may share its register), and every vreg
+// live across a WRITE interferes with the temporaries the call clobbers.
+static void build(Graph *graph, const IrFunction *fn, const uint32_t *out_start, const VReg *out,
+                  const double *block_weight) {
+    LiveSet live;
+    live.members = arena_alloc(graph->arena, graph->node_count * sizeof(uint32_t));
+    live.index = arena_calloc(graph->arena, graph->node_count, sizeof(uint32_t));
+    live.count = 0;
+
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        double weight = block_weight[b];
+        live.count = 0;
+        for (uint32_t i = out_start[b]; i < out_start[b + 1]; i++) {
+            live_use(graph, &live, (Operand){ OPND_REG, out[i] });
+        }
+        live_use(graph, &live, block->term.a);
+        live_use(graph, &live, block->term.b);
+        add_cost(graph, block->term.a, weight);
+        add_cost(graph, block->term.b, weight);
+
+        for (uint32_t i = block->count; i-- > 0;) {
+            const IrInst *inst = &block->insts[i];
+            if (inst->op == IR_NOP) continue;
+            if (inst->op == IR_WRITE) {
+                for (uint32_t l = 0; l < live.count; l++) {
+                    for (uint32_t t = 0; t < TEMP_COLORS; t++) add_edge(graph, live.members[l], t);
+                }
+            }
+            if (inst->dst != NO_VREG && graph->state[PRECOLORED + inst->dst] != NODE_ABSENT) {
+                uint32_t dst = PRECOLORED + inst->dst;
+                if (inst->op == IR_COPY && inst->a.kind == OPND_REG &&
+                    graph->state[PRECOLORED + inst->a.value] != NODE_ABSENT) {
+                    uint32_t src = PRECOLORED + inst->a.value;
+                    live_remove(&live, src);
+                    uint32_t move = graph->move_count++;
+                    graph->moves[move] = (Move){ dst, src };
+                    graph->move_state[move] = MOVE_WORKLIST;
+                    list_push(graph->arena, &graph->node_moves[dst], move);
+                    list_push(graph->arena, &graph->node_moves[src], move);
+                    list_push(graph->arena, &graph->moves_ready, move);
+                }
+                for (uint32_t l = 0; l < live.count; l++) add_edge(graph, live.members[l], dst);
+                live_remove(&live, dst);
+                graph->cost[dst] += weight;
+            }
+            live_use(graph, &live, inst->a);
+            live_use(graph, &live, inst->b);
+            add_cost(graph, inst->a, weight);
+            add_cost(graph, inst->b, weight);
+        }
+    }
+}
+
+// --- Worklists ---
+
+static int move_related(const Graph *graph, uint32_t node) {
+    const NodeList *moves = &graph->node_moves[node];
+    for (uint32_t i = 0; i < moves->count; i++) {
+        uint8_t state = graph->move_state[moves->items[i]];
+        if (state == MOVE_ACTIVE || state == MOVE_WORKLIST) return 1;
+    }
+    return 0;
+}
+
+// A node still in the graph (not on the select stack or merged into another)
+static int in_graph(const Graph *graph, uint32_t node) {
+    return graph->state[node] != NODE_SELECT && graph->state[node] != NODE_COALESCED;
+}
+
+static void set_state(Graph *graph, uint32_t node, NodeState state) {
+    graph->state[node] = (uint8_t)state;
+    if (state == NODE_SIMPLIFY) list_push(graph->arena, &graph->simplify, node);
+    else if (state == NODE_FREEZE) list_push(graph->arena, &graph->freeze, node);
+    else if (state == NODE_SPILL) heap_push(graph->arena, &graph->spill, spill_priority(graph, node), node);
+}
+
+static void make_worklists(Graph *graph) {
+    for (uint32_t n = PRECOLORED; n < graph->node_count; n++) {
+        if (graph->state[n] == NODE_ABSENT) continue;
+        if (graph->degree[n] >= K) set_state(graph, n, NODE_SPILL);
+        else if (move_related(graph, n)) set_state(graph, n, NODE_FREEZE);
+        else set_state(graph, n, NODE_SIMPLIFY);
+    }
+}
+
+static void enable_moves(Graph *graph, uint32_t node) {
+    const NodeList *moves = &graph->node_moves[node];
+    for (uint32_t i = 0; i < moves->count; i++) {
+        uint32_t move = moves->items[i];
+        if (graph->move_state[move] != MOVE_ACTIVE) continue;
+        graph->move_state[move] = MOVE_WORKLIST;
+        list_push(graph->arena, &graph->moves_ready, move);
+    }
+}
+
+// A neighbor of a removed node lost an edge; at K - 1 it becomes colorable, and moves that
+// were blocked by it or its neighbors may coalesce now
+static void decrement_degree(Graph *graph, uint32_t node) {
+    if (graph->state[node] == NODE_PRECOLORED) return;
+    if (graph->degree[node]-- != K) return;
+    enable_moves(graph, node);
+    const NodeList *adjacent = &graph->adjacent[node];
+    for (uint32_t i = 0; i < adjacent->count; i++) {
+        if (in_graph(graph, adjacent->items[i])) enable_moves(graph, adjacent->items[i]);
+    }
+    if (graph->state[node] == NODE_SPILL) {
+        set_state(graph, node, move_related(graph, node) ? NODE_FREEZE : NODE_SIMPLIFY);
+    }
+}
+
+// Follows the alias chain of a coalesced node, pointing every node on it straight at the end
+static uint32_t get_alias(Graph *graph, uint32_t node) {
+    uint32_t root = node;
+    while (graph->state[root] == NODE_COALESCED) root = graph->alias[root];
+    while (graph->state[node] == NODE_COALESCED) {
+        uint32_t next = graph->alias[node];
+        graph->alias[node] = root;
+        node = next;
+    }
+    return root;
+}
+
+// Moves a node that is no longer move-related and has low degree to the simplify worklist
+static void add_worklist(Graph *graph, uint32_t node) {
+    if (graph->state[node] == NODE_FREEZE && !move_related(graph, node) && graph->degree[node] < K) {
+        set_state(graph, node, NODE_SIMPLIFY);
+    }
+}
+
+// --- Simplify, Coalesce, Freeze, Spill ---
+
+static void simplify(Graph *graph, uint32_t node) {
+    graph->state[node] = NODE_SELECT;
+    list_push(graph->arena, &graph->select, node);
+    const NodeList *adjacent = &graph->adjacent[node];
+    for (uint32_t i = 0; i < adjacent->count; i++) {
+        if (in_graph(graph, adjacent->items[i])) decrement_degree(graph, adjacent->items[i]);
+    }
+}
+
+// Briggs: merging u and v is safe if the result has fewer than K neighbors of significant degree
+static int conservative(Graph *graph, uint32_t u, uint32_t v) {
+    uint32_t significant = 0;
+    graph->stamp_id++;
+    uint32_t nodes[2] = { u, v };
+    for (int k = 0; k < 2; k++) {
+        const NodeList *adjacent = &graph->adjacent[nodes[k]];
+        for (uint32_t i = 0; i < adjacent->count; i++) {
+            uint32_t t = adjacent->items[i];
+            if (!in_graph(graph, t) || graph->stamp[t] == graph->stamp_id) continue;
+            graph->stamp[t] = graph->stamp_id;
+            if (graph->degree[t] >= K && ++significant >= K) return 0;
+        }
+    }
+    return 1;
+}
+
+static void combine(Graph *graph, uint32_t u, uint32_t v) {
+    graph->state[v] = NODE_COALESCED;
+    graph->alias[v] = u;
+    graph->cost[u] += graph->cost[v];
+    enable_moves(graph, v);
+
+    // Append the shorter move list to the longer one so chains of copies merge in O(n log n)
+    NodeList *into = &graph->node_moves[u];
+    NodeList *from = &graph->node_moves[v];
+    if (from->count > into->count) {
+        NodeList swap = *into;
+        *into = *from;
+        *from = swap;
+    }
+    for (uint32_t i = 0; i < from->count; i++) list_push(graph->arena, into, from->items[i]);
+
+    const NodeList *adjacent = &graph->adjacent[v];
+    for (uint32_t i = 0; i < adjacent->count; i++) {
+        uint32_t t = adjacent->items[i];
+        if (!in_graph(graph, t)) continue;
+        add_edge(graph, t, u);
+        decrement_degree(graph, t);
+    }
+    if (graph->degree[u] >= K && graph->state[u] == NODE_FREEZE) set_state(graph, u, NODE_SPILL);
+}
+
+// Both ends of every move here are vregs: nothing is copied to or from t3-t6, so George's
+// test for precolored nodes is never needed
+static void coalesce(Graph *graph, uint32_t move) {
+    uint32_t u = get_alias(graph, graph->moves[move].dst);
+    uint32_t v = get_alias(graph, graph->moves[move].src);
+    if (u == v) {
+        graph->move_state[move] = MOVE_COALESCED;
+        add_worklist(graph, u);
+    } else if (interferes(graph, u, v)) {
+        graph->move_state[move] = MOVE_CONSTRAINED;
+        add_worklist(graph, u);
+        add_worklist(graph, v);
+    } else if (conservative(graph, u, v)) {
+        graph->move_state[move] = MOVE_COALESCED;
+        combine(graph, u, v);
+        add_worklist(graph, u);
+    } else {
+        graph->move_state[move] = MOVE_ACTIVE;
+    }
+}
+
+static void freeze_moves(Graph *graph, uint32_t node) {
+    const NodeList *moves = &graph->node_moves[node];
+    for (uint32_t i = 0; i < moves->count; i++) {
+        uint32_t move = moves->items[i];
+        if (graph->move_state[move] != MOVE_ACTIVE && graph->move_state[move] != MOVE_WORKLIST) continue;
+        graph->move_state[move] = MOVE_FROZEN;
+        uint32_t other = get_alias(graph, graph->moves[move].dst);
+        if (other == get_alias(graph, node)) other = get_alias(graph, graph->moves[move].src);
+        if (graph->state[other] == NODE_FREEZE && !move_related(graph, other) && graph->degree[other] < K) {
+            set_state(graph, other, NODE_SIMPLIFY);
+        }
+    }
+}
+
+// Chooses the potential spill with the lowest cost per edge it would remove, or 0 if there is
+// none. Degrees change while a node waits in the heap, so an entry whose priority is out of
+// date goes back in with the current one.
+static uint32_t select_spill(Graph *graph) {
+    while (graph->spill.count > 0) {
+        SpillCandidate candidate = heap_pop(&graph->spill);
+        if (graph->state[candidate.node] != NODE_SPILL) continue;
+        double priority = spill_priority(graph, candidate.node);
+        if (priority == candidate.priority) return candidate.node;
+        heap_push(graph->arena, &graph->spill, priority, candidate.node);
+    }
+    return 0;
+}
+
+// Pops the next entry of a lazily deleted node worklist, or 0 if it is empty
+static uint32_t pop_node(Graph *graph, NodeList *list, NodeState state) {
+    while (list->count > 0) {
+        uint32_t node = list->items[--list->count];
+        if (graph->state[node] == state) return node;
+    }
+    return 0;
+}
+
+// --- Coloring ---
+
+// Picks a color no colored neighbor has: the color of a move partner if possible, so the copy
+// disappears, then a temporary, then a saved register the prologue already saves.
+static uint8_t pick_color(Graph *graph, uint32_t node, uint32_t saved_mask) {
+    uint32_t ok = ((uint32_t)1 << K) - 1;
+    const NodeList *adjacent = &graph->adjacent[node];
+    for (uint32_t i = 0; i < adjacent->count; i++) {
+        uint32_t t = get_alias(graph, adjacent->items[i]);
+        if (graph->state[t] == NODE_COLORED || graph->state[t] == NODE_PRECOLORED) ok &= ~((uint32_t)1 << graph->color[t]);
+    }
+    if (ok == 0) return NO_COLOR;
+
+    const NodeList *moves = &graph->node_moves[node];
+    for (uint32_t i = 0; i < moves->count; i++) {
+        const Move *move = &graph->moves[moves->items[i]];
+        uint32_t other = get_alias(graph, move->dst);
+        if (other == node) other = get_alias(graph, move->src);
+        if (graph->state[other] == NODE_COLORED && (ok & ((uint32_t)1 << graph->color[other]))) {
+            return graph->color[other];
+        }
+    }
+    for (uint32_t c = 0; c < K; c++) {
+        if ((ok & ((uint32_t)1 << c)) && (c < TEMP_COLORS || (saved_mask & ((uint32_t)1 << colors[c])))) return (uint8_t)c;
+    }
+    for (uint32_t c = 0; c < K; c++) {
+        if (ok & ((uint32_t)1 << c)) return (uint8_t)c;
+    }
+    return NO_COLOR;
+}
+
+// One round of build, simplify/coalesce/freeze/spill and select. Returns the number of actual
+// spills, which are marked in spilled[] for the next round.
+static uint32_t color_graph(const IrFunction *fn, Arena *arena, const uint32_t *out_start, const VReg *out,
+                            const double *block_weight, const uint8_t *present, uint8_t *spilled,
+                            RegAssignment *assignment) {
+    Graph graph;
+    memset(&graph, 0, sizeof(graph));
+    graph.arena = arena;
+    uint32_t n = graph.node_count = PRECOLORED + fn->vreg_count;
+    graph.edge_capacity = 1024;
+    graph.edge_shift = 64 - 10;
+    graph.edges = arena_calloc(arena, graph.edge_capacity, sizeof(uint64_t));
+    graph.adjacent = arena_calloc(arena, n, sizeof(NodeList));
+    graph.degree = arena_calloc(arena, n, sizeof(uint32_t));
+    graph.node_moves = arena_calloc(arena, n, sizeof(NodeList));
+    graph.state = arena_calloc(arena, n, sizeof(uint8_t));
+    graph.alias = arena_calloc(arena, n, sizeof(uint32_t));
+    graph.color = arena_alloc(arena, n * sizeof(uint8_t));
+    graph.cost = arena_calloc(arena, n, sizeof(double));
+    graph.stamp = arena_calloc(arena, n, sizeof(uint32_t));
+    memset(graph.color, NO_COLOR, n);
+
+    uint32_t copy_count = 0;
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        for (uint32_t i = 0; i < fn->blocks[b].count; i++) copy_count += fn->blocks[b].insts[i].op == IR_COPY;
+    }
+    graph.moves = arena_alloc(arena, (copy_count + 1) * sizeof(Move));
+    graph.move_state = arena_alloc(arena, copy_count + 1);
+
+    for (uint32_t t = 0; t < PRECOLORED; t++) {
+        graph.state[t] = NODE_PRECOLORED;
+        graph.color[t] = (uint8_t)t;
+        graph.degree[t] = INFINITE_DEGREE;
+    }
+    for (VReg v = 1; v < fn->vreg_count; v++) {
+        if (present[v] && !spilled[v]) graph.state[PRECOLORED + v] = NODE_SIMPLIFY; // Placeholder until make_worklists
+    }
+
+    build(&graph, fn, out_start, out, block_weight);
+    make_worklists(&graph);
+
+    for (;;) {
+        uint32_t node;
+        if ((node = pop_node(&graph, &graph.simplify, NODE_SIMPLIFY)) != 0) {
+            simplify(&graph, node);
+        } else if (graph.moves_ready.count > 0) {
+            uint32_t move = graph.moves_ready.items[--graph.moves_ready.count];
+            if (graph.move_state[move] == MOVE_WORKLIST) coalesce(&graph, move);
+        } else if ((node = pop_node(&graph, &graph.freeze, NODE_FREEZE)) != 0) {
+            set_state(&graph, node, NODE_SIMPLIFY);
+            freeze_moves(&graph, node);
+        } else if ((node = select_spill(&graph)) != 0) {
+            set_state(&graph, node, NODE_SIMPLIFY);
+            freeze_moves(&graph, node);
+        } else {
+            break;
+        }
+    }
+
+    // Pop the select stack, coloring each node against its already colored neighbors
+    uint32_t spill_count = 0;
+    uint32_t saved_mask = 0;
+    while (graph.select.count > 0) {
+        uint32_t node = graph.select.items[--graph.select.count];
+        uint8_t color = pick_color(&graph, node, saved_mask);
+        if (color == NO_COLOR) {
+            graph.state[node] = NODE_SPILLED;
+            spilled[node - PRECOLORED] = 1;
+            spill_count++;
+            continue;
+        }
+        graph.state[node] = NODE_COLORED;
+        graph.color[node] = color;
+        if (color >= TEMP_COLORS) saved_mask |= (uint32_t)1 << colors[color];
+    }
+    if (spill_count > 0) return spill_count;
+
+    for (VReg v = 1; v < fn->vreg_count; v++) {
+        if (!present[v] || spilled[v]) continue;
+        uint8_t color = graph.color[get_alias(&graph, PRECOLORED + v)];
+        assignment->reg[v] = (uint8_t)colors[color];
+        assignment->assigned++;
+    }
+    assignment->saved_mask = saved_mask;
+    return 0;
+}
+
+RegAssignment *regalloc_irc(const IrFunction *fn, Arena *arena) {
+    RegAssignment *assignment = regalloc_new_assignment(fn, arena);
+
+    // Live-out sets, in CSR form by block
+    LiveOutPairs pairs = { arena, NULL, NULL, 0, 0 };
+    live_explore(fn, arena, collect_live_out, &pairs);
+    uint32_t *out_start = arena_calloc(arena, fn->block_count + 2, sizeof(uint32_t));
+    for (uint32_t i = 0; i < pairs.count; i++) out_start[pairs.blocks[i] + 2]++;
+    for (uint32_t b = 0; b < fn->block_count; b++) out_start[b + 2] += out_start[b + 1];
+    VReg *out = arena_alloc(arena, (pairs.count + 1) * sizeof(VReg));
+    for (uint32_t i = 0; i < pairs.count; i++) out[out_start[pairs.blocks[i] + 1]++] = pairs.vregs[i];
+
+    // Spill costs weigh each block by its loop nesting
+    Cfg *cfg = cfg_build(fn, arena);
+    cfg_compute_loops(cfg, arena);
+    double *block_weight = arena_alloc(arena, (fn->block_count + 1) * sizeof(double));
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        uint32_t depth = cfg->loop_depth[b] < MAX_LOOP_WEIGHT ? cfg->loop_depth[b] : MAX_LOOP_WEIGHT;
+        block_weight[b] = 1;
+        while (depth-- > 0) block_weight[b] *= 10;
+    }
+
+    uint8_t *present = arena_calloc(arena, fn->vreg_count, sizeof(uint8_t));
+    uint8_t *spilled = arena_calloc(arena, fn->vreg_count, sizeof(uint8_t));
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        for (uint32_t i = 0; i < block->count; i++) {
+            const IrInst *inst = &block->insts[i];
+            if (inst->op == IR_NOP) continue;
+            if (inst->dst != NO_VREG) present[inst->dst] = 1;
+            if (inst->a.kind == OPND_REG) present[inst->a.value] = 1;
+            if (inst->b.kind == OPND_REG) present[inst->b.value] = 1;
+        }
+        if (block->term.a.kind == OPND_REG) present[block->term.a.value] = 1;
+        if (block->term.b.kind == OPND_REG) present[block->term.b.value] = 1;
+    }
+
+    // Each round spills at least one more vreg, so this ends
+    while (color_graph(fn, arena, out_start, out, block_weight, present, spilled, assignment) > 0) {
+    }
+    for (VReg v = 1; v < fn->vreg_count; v++) {
+        if (spilled[v]) regalloc_spill(assignment, v);
+    }
+    return assignment;
+}
@@ -1,41 +1,74 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 
-typedef enum
+#include "lexer.h"
+#include "scan.h"
+
+size_t line_num = 0;
+
+// Text of the source currently being lexed; token slices are offsets into it
+static const char *source_text = "";
+
+// Returns the token's spelling. Slices point into the source and are NOT NUL-terminated,
+// so always pair this with token_length.
+const char *token_text(Token token)
 {
-  BEGINNING,
-  INT,
-  KEYWORD,
-  SEPARATOR,
-  OPERATOR,
-  IDENTIFIER,
-  STRING,
-  COMP,
-  END_OF_TOKENS,
-} TokenType;
+  return source_text + token.offset;
+}
 
-typedef struct
+size_t token_length(Token token)
 {
-  TokenType type;
-  char *value;
-  size_t line_num;
-} Token;
+  return token.length;
+}
 
-size_t line_num = 0;
-size_t tokens_index = 0;
+// Printable names of the fine-grained kinds, indexed by TokenKind
+static const char *const token_kind_names[TOKEN_KIND_COUNT] = {
+    [KIND_NONE] = "NONE",
+    [KW_EXIT] = "EXIT",
+    [KW_INT] = "INT",
+    [KW_IF] = "IF",
+    [KW_ELSE] = "ELSE",
+    [KW_WHILE] = "WHILE",
+    [KW_WRITE] = "WRITE",
+    [OP_ASSIGN] = "=",
+    [OP_ADD] = "+",
+    [OP_SUB] = "-",
+    [OP_MUL] = "*",
+    [OP_DIV] = "/",
+    [OP_MOD] = "%",
+    [CMP_EQ] = "==",
+    [CMP_NEQ] = "!=",
+    [CMP_LESS] = "<",
+    [CMP_LESS_EQ] = "<=",
+    [CMP_GREATER] = ">",
+    [CMP_GREATER_EQ] = ">=",
+    [SEP_SEMICOLON] = ";",
+    [SEP_COMMA] = ",",
+    [SEP_LPAREN] = "(",
+    [SEP_RPAREN] = ")",
+    [SEP_LBRACE] = "{",
+    [SEP_RBRACE] = "}",
+    [NODE_PROGRAM] = "PROGRAM",
+    [NODE_BLOCK] = "BLOCK",
+    [NODE_DECLARE_INT] = "DECLARE_INT",
+    [NODE_ASSIGN] = "ASSIGN",
+};
+
+const char *token_kind_name(TokenKind kind)
+{
+  return kind < TOKEN_KIND_COUNT && token_kind_names[kind] ? token_kind_names[kind] : "?";
+}
 
 void print_token(Token token)
 {
   printf("TOKEN VALUE: ");
-  printf("'");
-  for (int i = 0; token.value[i] != '\0'; i++)
+  printf("'%.*s'", (int)token_length(token), token_text(token));
+  printf("\nline number: %lu", (unsigned long)token.line_num);
+  if (token.kind != KIND_NONE)
   {
-    printf("%c", token.value[i]);
+    printf(" KIND: %s", token_kind_name(token.kind));
   }
-  printf("'");
-  printf("\nline number: %lu", (unsigned long)token.line_num);
 
   switch (token.type)
   {
@@ -69,270 +102,415 @@ void print_token(Token token)
   }
 }
 
-Token *generate_number(char *current, int *current_index)
+// Fills token (a slot of the token array) with a slice covering current[start, end) of the source
+Token *generate_slice(Token *token, size_t start, size_t end, TokenType type)
 {
-  Token *token = malloc(sizeof(Token));
   token->line_num = line_num; // Directly assign the value of line_num
-  token->type = INT;
-  char *value = malloc(sizeof(char) * 8);
-  int value_index = 0;
-  while (isdigit(current[*current_index]) && current[*current_index] != '\0')
-  {
-    value[value_index] = current[*current_index];
-    value_index++;
-    *current_index += 1;
-  }
-  value[value_index] = '\0';
-  token->value = value;
+  token->type = type;
+  token->kind = KIND_NONE;
+  token->offset = start;
+  token->length = end - start;
+  token->symbol = NO_SYMBOL;
   return token;
 }
 
-Token *generate_keyword_or_identifier(char *current, int *current_index)
+Token *generate_number(Token *token, const char *current, size_t length, size_t *current_index)
 {
-  Token *token = malloc(sizeof(Token));
-  token->line_num = line_num;                // Directly assign the value of line_num
-  char *keyword = malloc(sizeof(char) * 64); // Increase buffer size for longer keywords
-  int keyword_index = 0;
+  size_t start = *current_index;
+  *current_index = scan_digits(current, start, length);
+  return generate_slice(token, start, *current_index, INT);
+}
 
-  while (isalpha(current[*current_index]) && current[*current_index] != '\0')
-  {
-    keyword[keyword_index] = current[*current_index];
-    keyword_index++;
-    *current_index += 1;
-  }
-  keyword[keyword_index] = '\0';
+// --- Keyword Recognition ---
+// Keywords live in a perfect hash table keyed on (length, first char, second char).
+// KEYWORD_SLOT is evaluated at compile time to place the entries below and at run time
+// for each identifier, so recognizing a word costs one hash and at most one memcmp.
+// To add a keyword, add one line; a collision shows up as an -Woverride-init warning
+// (part of -Wextra) and means the multipliers in KEYWORD_SLOT need retuning.
+// The current multipliers also leave "for" a free slot.
+#define KEYWORD_TABLE_SIZE 32
+#define KEYWORD_MIN_LENGTH 2
+#define KEYWORD_MAX_LENGTH 7
+#define KEYWORD_SLOT(length, first, second) (((length) + (first) + 2 * (second)) & (KEYWORD_TABLE_SIZE - 1))
+// The first two characters are spelled out because string indexing is not a constant expression
+#define KEYWORD_ENTRY(spelling, first, second, type, kind) \
+  [KEYWORD_SLOT(sizeof(spelling) - 1, first, second)] = {spelling, sizeof(spelling) - 1, type, kind}
 
-  keyword[keyword_index] = '\0';
-  if (strcmp(keyword, "exit") == 0)
-  {
-    token->type = KEYWORD;
-    token->value = "EXIT";
-  }
-  else if (strcmp(keyword, "int") == 0)
-  {
-    token->type = KEYWORD;
-    token->value = "INT";
-  }
-  else if (strcmp(keyword, "if") == 0)
-  {
-    token->type = KEYWORD;
-    token->value = "IF";
-  }
-  else if (strcmp(keyword, "while") == 0)
-  {
-    token->type = KEYWORD;
-    token->value = "WHILE";
-  }
-  else if (strcmp(keyword, "write") == 0)
-  {
-    token->type = KEYWORD;
-    token->value = "WRITE";
-  }
-  else if (strcmp(keyword, "eq") == 0)
-  {
-    token->type = COMP;
-    token->value = "EQ";
-  }
-  else if (strcmp(keyword, "neq") == 0)
+typedef struct
+{
+  const char *spelling;
+  size_t length; // 0 marks an empty slot
+  TokenType type;
+  TokenKind kind;
+} Keyword;
+
+static const Keyword keyword_table[KEYWORD_TABLE_SIZE] = {
+    KEYWORD_ENTRY("exit", 'e', 'x', KEYWORD, KW_EXIT),
+    KEYWORD_ENTRY("int", 'i', 'n', KEYWORD, KW_INT),
+    KEYWORD_ENTRY("if", 'i', 'f', KEYWORD, KW_IF),
+    KEYWORD_ENTRY("else", 'e', 'l', KEYWORD, KW_ELSE),
+    KEYWORD_ENTRY("while", 'w', 'h', KEYWORD, KW_WHILE),
+    KEYWORD_ENTRY("write", 'w', 'r', KEYWORD, KW_WRITE),
+    KEYWORD_ENTRY("eq", 'e', 'q', COMP, CMP_EQ),
+    KEYWORD_ENTRY("neq", 'n', 'e', COMP, CMP_NEQ),
+    KEYWORD_ENTRY("less", 'l', 'e', COMP, CMP_LESS),
+    KEYWORD_ENTRY("greater", 'g', 'r', COMP, CMP_GREATER),
+};
+
+// Returns the keyword spelled by word[0, length), or NULL for an identifier
+static const Keyword *find_keyword(const char *word, size_t length)
+{
+  if (length < KEYWORD_MIN_LENGTH || length > KEYWORD_MAX_LENGTH)
   {
-    token->type = COMP;
-    token->value = "NEQ";
+    return NULL; // Most identifiers are rejected here without hashing
   }
-  else if (strcmp(keyword, "less") == 0)
+  const Keyword *keyword = &keyword_table[KEYWORD_SLOT(length, (unsigned char)word[0], (unsigned char)word[1])];
+  if (keyword->length == length && memcmp(keyword->spelling, word, length) == 0)
   {
-    token->type = COMP;
-    token->value = "LESS";
+    return keyword;
   }
-  else if (strcmp(keyword, "greater") == 0)
+  return NULL;
+}
+
+Token *generate_keyword_or_identifier(Token *token, const char *current, size_t length, size_t *current_index)
+{
+  size_t start = *current_index;
+  *current_index = scan_alpha(current, start, length);
+
+  generate_slice(token, start, *current_index, IDENTIFIER);
+  const Keyword *keyword = find_keyword(current + start, token->length);
+  if (keyword != NULL)
   {
-    token->type = COMP;
-    token->value = "GREATER";
+    token->type = keyword->type;
+    token->kind = keyword->kind;
   }
   else
   {
-    token->type = IDENTIFIER;
-    token->value = keyword;
+    token->symbol = intern(current + start, token->length); // Identifiers are interned once, here
   }
   return token;
 }
 
-Token *generate_string_token(char *current, int *current_index)
+Token *generate_string_token(Token *token, const char *current, size_t length, size_t *current_index)
 {
-  Token *token = malloc(sizeof(Token));
-  token->line_num = line_num;
-  token->type = STRING;
-  char *value = malloc(sizeof(char) * 256); // Allocate memory for the string
-  int value_index = 0;
-
+  size_t token_line = line_num;
   *current_index += 1; // Skip the opening quote
-  while (current[*current_index] != '"' && current[*current_index] != '\0')
+  size_t start = *current_index;
+  while (*current_index < length && current[*current_index] != '"')
   {
     if (current[*current_index] == '\n')
     {
       line_num++; // Handle multiline strings
     }
-    value[value_index++] = current[*current_index];
     *current_index += 1;
   }
 
-  if (current[*current_index] == '"')
-  {
-    *current_index += 1; // Skip the closing quote
-  }
-  else
+  if (*current_index >= length)
   {
     printf("Error: Unterminated string on line %lu\n", (unsigned long)line_num);
     exit(1);
   }
 
-  value[value_index] = '\0'; // Null-terminate the string
-  token->value = value;
+  generate_slice(token, start, *current_index, STRING); // Slice excludes the quotes
+  token->line_num = token_line;
+  *current_index += 1; // Skip the closing quote
   return token;
 }
 
-Token *generate_separator_or_operator(char *current, int *current_index, TokenType type)
+Token *generate_separator_or_operator(Token *token, size_t *current_index, size_t width, TokenType type, TokenKind kind)
 {
-  Token *token = malloc(sizeof(Token));
-  token->line_num = line_num; // Directly assign the value of line_num
-  char *value = malloc(sizeof(char) * 2);
-  value[0] = current[*current_index];
-  value[1] = '\0';
-  token->value = value;
-  token->type = type;
-  *current_index += 1;
+  generate_slice(token, *current_index, *current_index + width, type);
+  token->kind = kind;
+  *current_index += width;
   return token;
 }
 
-Token *lexer(FILE *file)
-{
-    int length;
-    char *current = NULL;
-
-    // Get the file size
-    fseek(file, 0, SEEK_END);
-    length = ftell(file);
-    printf("File size: %d bytes\n", length); // Debugging output
-    fseek(file, 0, SEEK_SET);
-
-    // Allocate memory for the input buffer
-    current = malloc(sizeof(char) * ((size_t)length + 1)); // Cast length to size_t
-    if (current == NULL)
-    {
-        printf("Error: Memory allocation failed\n");
-        exit(1);
-    }
+// --- Token Stream ---
 
-    // Read the file into the buffer
-    size_t bytes_read = fread(current, 1, (size_t)length, file); // Cast length to size_t
-    fclose(file);
+#define INITIAL_LINE_RUNS 64
 
-    // Null-terminate the input buffer
-    current[bytes_read] = '\0';
+// Allocates stream arrays sized from the source length. Dense C0 code averages one token
+// per 4-7 bytes, so length / 3 rarely needs to grow; growing is still supported.
+static void token_stream_init(TokenStream *stream, const Source *source, Arena *arena)
+{
+  memset(stream, 0, sizeof(*stream));
+  stream->arena = arena;
+  stream->text = source->data;
+  stream->capacity = source->length / 3 + 16;
+  stream->types = arena_alloc(arena, stream->capacity * sizeof(uint8_t));
+  stream->kinds = arena_alloc(arena, stream->capacity * sizeof(uint8_t));
+  stream->offsets = arena_alloc(arena, stream->capacity * sizeof(uint32_t));
+  stream->lengths = arena_alloc(arena, stream->capacity * sizeof(uint32_t));
+  stream->symbols = arena_alloc(arena, stream->capacity * sizeof(SymbolId));
+  stream->line_runs_capacity = INITIAL_LINE_RUNS;
+  stream->line_run_starts = arena_alloc(arena, stream->line_runs_capacity * sizeof(uint32_t));
+  stream->line_run_lines = arena_alloc(arena, stream->line_runs_capacity * sizeof(uint32_t));
+}
+
+// Packs a token into the stream's arrays
+static void token_stream_push(TokenStream *stream, const Token *token)
+{
+  Arena *arena = stream->arena;
+  if (stream->count == stream->capacity)
+  {
+    size_t old = stream->capacity;
+    stream->capacity *= 2;
+    stream->types = arena_grow(arena, stream->types, old * sizeof(uint8_t), stream->capacity * sizeof(uint8_t));
+    stream->kinds = arena_grow(arena, stream->kinds, old * sizeof(uint8_t), stream->capacity * sizeof(uint8_t));
+    stream->offsets = arena_grow(arena, stream->offsets, old * sizeof(uint32_t), stream->capacity * sizeof(uint32_t));
+    stream->lengths = arena_grow(arena, stream->lengths, old * sizeof(uint32_t), stream->capacity * sizeof(uint32_t));
+    stream->symbols = arena_grow(arena, stream->symbols, old * sizeof(SymbolId), stream->capacity * sizeof(SymbolId));
+  }
 
-    // Check for discrepancies between file size and bytes read
-    if (bytes_read != (size_t)length)
+  // Lines are stored once per run of tokens sharing a line, not once per token
+  if (stream->line_runs == 0 || stream->line_run_lines[stream->line_runs - 1] != token->line_num)
+  {
+    if (stream->line_runs == stream->line_runs_capacity)
     {
-        printf("Warning: Bytes read (%lu) do not match file size (%d)\n", (unsigned long)bytes_read, length);
+      size_t old = stream->line_runs_capacity;
+      stream->line_runs_capacity *= 2;
+      stream->line_run_starts = arena_grow(arena, stream->line_run_starts, old * sizeof(uint32_t), stream->line_runs_capacity * sizeof(uint32_t));
+      stream->line_run_lines = arena_grow(arena, stream->line_run_lines, old * sizeof(uint32_t), stream->line_runs_capacity * sizeof(uint32_t));
     }
+    stream->line_run_starts[stream->line_runs] = (uint32_t)stream->count;
+    stream->line_run_lines[stream->line_runs] = (uint32_t)token->line_num;
+    stream->line_runs++;
+  }
 
-    // Debugging: Print the input buffer
-    printf("Input buffer:\n%s\n", current);
-
-    int current_index = 0;
+  size_t index = stream->count++;
+  stream->types[index] = (uint8_t)token->type;
+  stream->kinds[index] = (uint8_t)token->kind;
+  stream->offsets[index] = (uint32_t)token->offset;
+  stream->lengths[index] = (uint32_t)token->length;
+  stream->symbols[index] = token->symbol;
+}
 
-    size_t number_of_tokens = 12;                             // Change type to size_t
-    Token *tokens = malloc(sizeof(Token) * number_of_tokens); // No need to cast number_of_tokens to size_t
-    if (tokens == NULL)
+// Line number of the token at index. Sequential lookups move a cursor forward;
+// anything else falls back to a binary search over the runs.
+size_t token_line(TokenStream *stream, size_t index)
+{
+  size_t run = stream->line_cursor;
+  if (run >= stream->line_runs || stream->line_run_starts[run] > index)
+  {
+    size_t low = 0;
+    size_t high = stream->line_runs;
+    while (high - low > 1)
     {
-        printf("Error: Memory allocation failed\n");
-        exit(1);
+      size_t mid = low + (high - low) / 2;
+      if (stream->line_run_starts[mid] <= index)
+      {
+        low = mid;
+      }
+      else
+      {
+        high = mid;
+      }
     }
+    run = low;
+  }
+  while (run + 1 < stream->line_runs && stream->line_run_starts[run + 1] <= index)
+  {
+    run++;
+  }
+  stream->line_cursor = run;
+  return stream->line_runs ? stream->line_run_lines[run] : 0;
+}
+
+// Unpacks the token at index (clamped to the END_OF_TOKENS entry)
+Token token_at(TokenStream *stream, size_t index)
+{
+  if (index >= stream->count)
+  {
+    index = stream->count - 1;
+  }
+  Token token;
+  token.type = (TokenType)stream->types[index];
+  token.kind = (TokenKind)stream->kinds[index];
+  token.offset = stream->offsets[index];
+  token.length = stream->lengths[index];
+  token.symbol = stream->symbols[index];
+  token.line_num = token_line(stream, index);
+  return token;
+}
 
-    size_t local_tokens_index = 0; // Local variable remains size_t
+// --- Pull Lexer ---
+
+// Scans the next token into token, producing END_OF_TOKENS once the source is exhausted
+// (and on every call after that). Generators track lines through line_num, which is
+// loaded from and saved back to the lexer around each scan.
+static void lex_token(Lexer *lexer, Token *token)
+{
+    const char *current = lexer->text;
+    size_t length = lexer->length;
+    size_t current_index = lexer->index;
+    line_num = lexer->line;
+    Token *produced = NULL;
 
-    while (current[current_index] != '\0')
+    while (produced == NULL && current_index < length)
     {
-        if (isspace(current[current_index]))
+        char c = current[current_index];
+        unsigned char char_kind = char_class[(unsigned char)c];
+        if (char_kind & CHAR_SPACE)
         {
-            if (current[current_index] == '\n')
-            {
-                line_num++;
-            }
-            current_index++;
-            continue; // Skip whitespace
+            // Skip the whole whitespace run at once, counting its newlines
+            current_index = scan_whitespace(current, current_index, length, &line_num);
+            continue;
         }
 
-        Token *token = NULL;
+        char next = current_index + 1 < length ? current[current_index + 1] : '\0';
 
-        if (current[current_index] == ';' || current[current_index] == ',' ||
-            current[current_index] == '(' || current[current_index] == ')' ||
-            current[current_index] == '{' || current[current_index] == '}')
-        {
-            token = generate_separator_or_operator(current, &current_index, SEPARATOR);
-        }
-        else if (current[current_index] == '=' || current[current_index] == '+' ||
-                 current[current_index] == '-' || current[current_index] == '*' ||
-                 current[current_index] == '/' || current[current_index] == '%')
-        {
-            token = generate_separator_or_operator(current, &current_index, OPERATOR);
-        }
-        else if (current[current_index] == '"')
-        {
-            token = generate_string_token(current, &current_index);
-        }
-        else if (isdigit(current[current_index]))
-        {
-            token = generate_number(current, &current_index);
-        }
-        else if (isalpha(current[current_index]))
-        {
-            token = generate_keyword_or_identifier(current, &current_index);
-        }
-        else if (current[current_index] == '>' || current[current_index] == '<' ||
-                 current[current_index] == '=' || current[current_index] == '!')
+        switch (c)
         {
-            if (current[current_index + 1] == '=')
+        case ';':
+            produced = generate_separator_or_operator(token, &current_index, 1, SEPARATOR, SEP_SEMICOLON);
+            break;
+        case ',':
+            produced = generate_separator_or_operator(token, &current_index, 1, SEPARATOR, SEP_COMMA);
+            break;
+        case '(':
+            produced = generate_separator_or_operator(token, &current_index, 1, SEPARATOR, SEP_LPAREN);
+            break;
+        case ')':
+            produced = generate_separator_or_operator(token, &current_index, 1, SEPARATOR, SEP_RPAREN);
+            break;
+        case '{':
+            produced = generate_separator_or_operator(token, &current_index, 1, SEPARATOR, SEP_LBRACE);
+            break;
+        case '}':
+            produced = generate_separator_or_operator(token, &current_index, 1, SEPARATOR, SEP_RBRACE);
+            break;
+        case '+':
+            produced = generate_separator_or_operator(token, &current_index, 1, OPERATOR, OP_ADD);
+            break;
+        case '-':
+            produced = generate_separator_or_operator(token, &current_index, 1, OPERATOR, OP_SUB);
+            break;
+        case '*':
+            produced = generate_separator_or_operator(token, &current_index, 1, OPERATOR, OP_MUL);
+            break;
+        case '/':
+            produced = generate_separator_or_operator(token, &current_index, 1, OPERATOR, OP_DIV);
+            break;
+        case '%':
+            produced = generate_separator_or_operator(token, &current_index, 1, OPERATOR, OP_MOD);
+            break;
+        case '=':
+            if (next == '=')
             {
-                token = generate_separator_or_operator(current, &current_index, COMP);
-                current_index++; // Skip the second character of the operator
+                produced = generate_separator_or_operator(token, &current_index, 2, COMP, CMP_EQ);
             }
             else
             {
-                token = generate_separator_or_operator(current, &current_index, COMP);
+                produced = generate_separator_or_operator(token, &current_index, 1, OPERATOR, OP_ASSIGN);
             }
-        }
-        else
-        {
-            printf("Warning: Unrecognized character '%c' on line %lu\n", current[current_index], (unsigned long)line_num);
-            current_index++; // Skip the unrecognized character
-            continue;
-        }
-
-        if (token != NULL)
-        {
-            if (local_tokens_index >= number_of_tokens)
+            break;
+        case '<':
+            produced = next == '=' ? generate_separator_or_operator(token, &current_index, 2, COMP, CMP_LESS_EQ)
+                                   : generate_separator_or_operator(token, &current_index, 1, COMP, CMP_LESS);
+            break;
+        case '>':
+            produced = next == '=' ? generate_separator_or_operator(token, &current_index, 2, COMP, CMP_GREATER_EQ)
+                                   : generate_separator_or_operator(token, &current_index, 1, COMP, CMP_GREATER);
+            break;
+        case '!':
+            // A lone '!' has no meaning yet; it is kept as a kind-less comparator
+            produced = next == '=' ? generate_separator_or_operator(token, &current_index, 2, COMP, CMP_NEQ)
+                                   : generate_separator_or_operator(token, &current_index, 1, COMP, KIND_NONE);
+            break;
+        case '"':
+            produced = generate_string_token(token, current, length, &current_index);
+            break;
+        default:
+            if (char_kind & CHAR_DIGIT)
+            {
+                produced = generate_number(token, current, length, &current_index);
+            }
+            else if (char_kind & CHAR_ALPHA)
+            {
+                produced = generate_keyword_or_identifier(token, current, length, &current_index);
+            }
+            else
             {
-                number_of_tokens *= 2;                                      // Double the size of the array
-                tokens = realloc(tokens, sizeof(Token) * number_of_tokens); // No cast needed
-                if (tokens == NULL)
-                {
-                    printf("Error: Memory allocation failed\n");
-                    exit(1);
-                }
+                printf("Warning: Unrecognized character '%c' on line %lu\n", c, (unsigned long)line_num);
+                current_index++; // Skip the unrecognized character
             }
-            tokens[local_tokens_index] = *token;
-            local_tokens_index++;
-            free(token); // Free the temporary token structure
+            break;
         }
     }
 
-    // Append END_OF_TOKENS
-    tokens[local_tokens_index].value = "\0";
-    tokens[local_tokens_index].type = END_OF_TOKENS;
-    tokens[local_tokens_index].line_num = line_num;
+    if (produced == NULL)
+    {
+        generate_slice(token, length, length, END_OF_TOKENS);
+    }
+    lexer->index = current_index;
+    lexer->line = line_num;
+}
+
+void lexer_init(Lexer *lexer, const Source *source)
+{
+  if (source->length > UINT32_MAX)
+  {
+    printf("Error: Source larger than 4 GiB is not supported\n");
+    exit(1);
+  }
+  memset(lexer, 0, sizeof(*lexer));
+  lexer->text = source->data;
+  lexer->length = source->length;
+  source_text = source->data;
+  line_num = 0;
+}
+
+// Returns the token k positions ahead without consuming anything (k = 0 is the next token).
+// k must be below LEXER_LOOKAHEAD.
+Token peek_token(Lexer *lexer, size_t k)
+{
+  if (k >= LEXER_LOOKAHEAD)
+  {
+    printf("Error: Lookahead of %lu tokens exceeds the lexer window\n", (unsigned long)k);
+    exit(1);
+  }
+  while (lexer->ring_count <= k)
+  {
+    size_t slot = (lexer->ring_head + lexer->ring_count) & (LEXER_LOOKAHEAD - 1);
+    lex_token(lexer, &lexer->ring[slot]);
+    lexer->ring_count++;
+  }
+  return lexer->ring[(lexer->ring_head + k) & (LEXER_LOOKAHEAD - 1)];
+}
+
+// Consumes and returns the next token. After the end of the source it keeps returning END_OF_TOKENS.
+Token next_token(Lexer *lexer)
+{
+  Token token;
+  if (lexer->ring_count == 0)
+  {
+    lex_token(lexer, &token); // Nothing buffered: scan straight into the result
+    return token;
+  }
+  token = lexer->ring[lexer->ring_head];
+  lexer->ring_head = (lexer->ring_head + 1) & (LEXER_LOOKAHEAD - 1);
+  lexer->ring_count--;
+  return token;
+}
+
+// Lexes the whole source up front into a TokenStream. The parser pulls tokens from a Lexer
+// instead; this is only for tools that want every token at once, such as the token dump.
+// Tokens reference (offset, length) slices of source->data, so the source must stay open
+// for as long as they are in use. The stream is allocated from arena and lives as long as it does.
+TokenStream *lexer(const Source *source, Arena *arena)
+{
+  Lexer state;
+  lexer_init(&state, source);
+
+  TokenStream *stream = arena_alloc(arena, sizeof(TokenStream));
+  token_stream_init(stream, source, arena);
 
-    printf("END_OF_TOKENS assigned at index %lu, line number: %lu\n", (unsigned long)local_tokens_index, (unsigned long)line_num);
+  Token token;
+  do
+  {
+    token = next_token(&state);
+    token_stream_push(stream, &token);
+  } while (token.type != END_OF_TOKENS);
 
-    free(current); // Free the input buffer
-    return tokens;
-}
\ No newline at end of file
+  return stream;
+}
@@ -1,6 +1,11 @@
 #ifndef LEXER_H_
 #define LEXER_H_
 
+#include <stddef.h>
+#include "source.h"
+#include "intern.h"
+#include "arena.h"
+
 typedef enum {
   BEGINNING,
   INT,
@@ -13,16 +18,100 @@ typedef enum {
   END_OF_TOKENS,
 } TokenType;
 
+// Fine-grained classification of tokens (and of the AST nodes built from them)
+typedef enum {
+  KIND_NONE, // Literals, identifiers and strings: the spelling comes from the source
+  // Keywords
+  KW_EXIT,
+  KW_INT,
+  KW_IF,
+  KW_ELSE,
+  KW_WHILE,
+  KW_WRITE,
+  // Operators
+  OP_ASSIGN,
+  OP_ADD,
+  OP_SUB,
+  OP_MUL,
+  OP_DIV,
+  OP_MOD,
+  // Comparators
+  CMP_EQ,
+  CMP_NEQ,
+  CMP_LESS,
+  CMP_LESS_EQ,
+  CMP_GREATER,
+  CMP_GREATER_EQ,
+  // Separators
+  SEP_SEMICOLON,
+  SEP_COMMA,
+  SEP_LPAREN,
+  SEP_RPAREN,
+  SEP_LBRACE,
+  SEP_RBRACE,
+  // Nodes that only exist in the AST
+  NODE_PROGRAM,
+  NODE_BLOCK,
+  NODE_DECLARE_INT,
+  NODE_ASSIGN,
+  TOKEN_KIND_COUNT,
+} TokenKind;
+
+#include <stdint.h>
+
+// Unpacked view of a single token, assembled on demand from a TokenStream
 typedef struct {
   TokenType type;
-  char *value;
+  TokenKind kind;
+  size_t offset;   // Start of the token's text in the source
+  size_t length;   // Length of the token's text in the source
+  SymbolId symbol; // Interned name for IDENTIFIER tokens, NO_SYMBOL otherwise
   size_t line_num;
 } Token;
 
+// Structure-of-arrays token storage: about 14 bytes per token plus 8 bytes per source line.
+// The last entry is always END_OF_TOKENS.
+typedef struct {
+  uint8_t *types;             // TokenType per token
+  uint8_t *kinds;             // TokenKind per token
+  uint32_t *offsets;          // Source offset per token
+  uint32_t *lengths;          // Source length per token
+  SymbolId *symbols;          // Interned name per token (NO_SYMBOL if not an identifier)
+  uint32_t *line_run_starts;  // First token index of each run of tokens on the same line
+  uint32_t *line_run_lines;   // Line number of each run
+  size_t line_runs;
+  size_t line_runs_capacity;
+  size_t line_cursor;         // Run of the last line lookup; makes sequential lookups O(1)
+  size_t count;
+  size_t capacity;
+  const char *text;           // Source text the offsets point into
+  Arena *arena;
+} TokenStream;
+
+// Lookahead window of the pull lexer; a power of two so ring indices wrap with a mask
+#define LEXER_LOOKAHEAD 4
+
+// Incremental lexer: tokens are produced on demand by next_token/peek_token and only the
+// lookahead window is ever buffered, so token memory stays constant regardless of input size.
+typedef struct {
+  const char *text;              // Source text, scanned in place
+  size_t length;
+  size_t index;                  // Scan position in text
+  size_t line;                   // Line of the scan position
+  Token ring[LEXER_LOOKAHEAD];   // Buffered tokens not yet consumed
+  size_t ring_head;              // Ring slot of the next token to consume
+  size_t ring_count;             // Number of buffered tokens
+} Lexer;
+
 void print_token(Token token);
-Token *generate_number(char *current, int *current_index);
-Token *generate_keyword(char *current, int *current_index);
-Token *generate_separator_or_operator(char *current, int *current_index, TokenType type);
-Token *lexer(FILE *file);
+const char *token_kind_name(TokenKind kind);
+const char *token_text(Token token);
+size_t token_length(Token token);
+Token token_at(TokenStream *stream, size_t index);
+size_t token_line(TokenStream *stream, size_t index);
+void lexer_init(Lexer *lexer, const Source *source);
+Token next_token(Lexer *lexer);
+Token peek_token(Lexer *lexer, size_t k);
+TokenStream *lexer(const Source *source, Arena *arena);
 
-#endif
\ No newline at end of file
+#endif
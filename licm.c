@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "licm.h"
+#include "cfg.h"
+#include "rv32.h"
+
+#define CONSTANT_BUDGET 4 // Constants one loop may hold in registers across its iterations
+
+// --- Preheaders ---
+
+// The header's only predecessor from outside the loop, or NO_BLOCK if it has several (C0's
+// structured loops always have one entry edge, but a loop entered twice is simply skipped)
+static uint32_t entry_block(const IrFunction *fn, const Cfg *cfg, uint32_t loop, uint32_t *index) {
+    const IrBlock *header = &fn->blocks[cfg->loops[loop].header];
+    uint32_t entry = NO_BLOCK;
+    for (uint32_t k = 0; k < header->pred_count; k++) {
+        if (cfg_in_loop(cfg, loop, header->preds[k])) continue;
+        if (entry != NO_BLOCK) return NO_BLOCK;
+        entry = header->preds[k];
+        *index = k;
+    }
+    return entry;
+}
+
+// Gives every loop a preheader, a block outside it that falls straight into the header. When
+// the entry block also branches elsewhere (the guard of a rotated WHILE), the entry edge is
+// split; the new block takes its place in the header's predecessors, so phis stay in step.
+// Returns 1 if blocks were added.
+static int insert_preheaders(IrFunction *fn, const Cfg *cfg) {
+    int added = 0;
+    for (uint32_t l = 0; l < cfg->loop_count; l++) {
+        uint32_t header = cfg->loops[l].header;
+        uint32_t index = 0;
+        uint32_t entry = entry_block(fn, cfg, l, &index);
+        uint32_t succs[2];
+        if (entry == NO_BLOCK || ir_successors(&fn->blocks[entry], succs) == 1) continue;
+
+        uint32_t preheader = ir_new_block(fn);
+        ir_set_jump(fn, preheader, header);
+        IrTerm *term = &fn->blocks[entry].term;
+        for (int i = 0; i < 2; i++) {
+            if (term->target[i] == header) term->target[i] = preheader;
+        }
+        fn->blocks[header].preds[index] = preheader;
+        fn->blocks[preheader].preds = arena_alloc(fn->arena, sizeof(uint32_t));
+        fn->blocks[preheader].preds[0] = entry;
+        fn->blocks[preheader].pred_count = 1;
+        added = 1;
+    }
+    return added;
+}
+
+// --- Hoisting ---
+static IrFunction *fn = NULL;
+static const Cfg *cfg = NULL;
+static uint32_t *def_block = NULL; // vreg -> block defining it
+
+static int is_invariant(uint32_t loop, Operand operand) {
+    return operand.kind != OPND_REG || !cfg_in_loop(cfg, loop, def_block[operand.value]);
+}
+
+// Moves the invariant instructions of the loop to the end of its preheader. Blocks are visited
+// in reverse postorder, so an instruction's operands are hoisted before it is looked at. Every
+// op is safe to run speculatively: division by zero has a defined result on RV32.
+static void hoist_invariants(uint32_t loop, uint32_t preheader) {
+    const Loop *info = &cfg->loops[loop];
+    for (uint32_t j = 0; j < info->block_count; j++) {
+        uint32_t b = cfg->loop_blocks[info->block_start + j];
+        IrBlock *block = &fn->blocks[b];
+        for (uint32_t i = 0; i < block->count; i++) {
+            IrInst *inst = &block->insts[i];
+            if (!ir_is_binary((IrOp)inst->op) && inst->op != IR_COPY) continue;
+            if (!is_invariant(loop, inst->a) || !is_invariant(loop, inst->b)) continue;
+            IrInst moved = *inst;
+            inst->op = IR_NOP;
+            *ir_append(fn, preheader, (IrOp)moved.op) = moved;
+            def_block[moved.dst] = preheader;
+        }
+    }
+}
+
+// Constants already given a register in the loop being processed
+static int32_t constant_values[CONSTANT_BUDGET];
+static VReg constant_vregs[CONSTANT_BUDGET];
+static uint32_t constant_count = 0;
+
+// Replaces an immediate the printer would load with li by a vreg set once in the preheader
+static void materialize(Operand *operand, uint32_t preheader) {
+    if (operand->kind != OPND_IMM || operand->value == 0) return;
+    for (uint32_t c = 0; c < constant_count; c++) {
+        if (constant_values[c] == operand->value) {
+            *operand = ir_reg(constant_vregs[c]);
+            return;
+        }
+    }
+    if (constant_count == CONSTANT_BUDGET) return;
+    IrInst *copy = ir_append(fn, preheader, IR_COPY);
+    copy->dst = ir_new_vreg(fn);
+    copy->a = *operand;
+    def_block[copy->dst] = preheader;
+    constant_values[constant_count] = operand->value;
+    constant_vregs[constant_count++] = copy->dst;
+    *operand = ir_reg(copy->dst);
+}
+
+// Gives the constants of the loop's own blocks (not those of nested loops, which already have
+// theirs in preheaders inside this loop) a register, up to CONSTANT_BUDGET of them
+static void hoist_constants(uint32_t loop, uint32_t preheader, const Target *target) {
+    const Loop *info = &cfg->loops[loop];
+    constant_count = 0;
+    for (uint32_t j = 0; j < info->block_count; j++) {
+        uint32_t b = cfg->loop_blocks[info->block_start + j];
+        if (cfg->innermost_loop[b] != loop) continue;
+        IrBlock *block = &fn->blocks[b];
+        for (uint32_t i = 0; i < block->count; i++) {
+            IrInst *inst = &block->insts[i];
+            if (!ir_is_binary((IrOp)inst->op)) continue;
+            materialize(&inst->a, preheader);
+            if (inst->b.kind == OPND_IMM && !rv32_fits_immediate((IrOp)inst->op, inst->b.value, target)) {
+                materialize(&inst->b, preheader);
+            }
+        }
+        if (block->term.kind == TERM_BRANCH) {
+            materialize(&block->term.a, preheader);
+            materialize(&block->term.b, preheader);
+        }
+    }
+}
+
+// --- Pass ---
+
+// Runs on SSA form, where a vreg defined outside a loop holds the same value in every
+// iteration. Invariant code hoisted out of an inner loop lands in its preheader, inside the
+// enclosing loop, and moves on from there when the enclosing loop is processed.
+void licm_hoist_invariants(IrFunction *function, const CompilerOptions *options) {
+    fn = function;
+    Arena *arena = fn->arena;
+    Cfg *loops = cfg_build(fn, arena);
+    cfg_compute_loops(loops, arena);
+    if (loops->loop_count == 0) {
+        fn = NULL;
+        return;
+    }
+    if (insert_preheaders(fn, loops)) {
+        loops = cfg_build(fn, arena);
+        cfg_compute_loops(loops, arena);
+    }
+    cfg = loops;
+
+    // Constants add at most CONSTANT_BUDGET vregs per loop
+    def_block = arena_calloc(arena, fn->vreg_count + CONSTANT_BUDGET * cfg->loop_count, sizeof(uint32_t));
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        for (uint32_t i = 0; i < block->count; i++) {
+            if (block->insts[i].dst != NO_VREG) def_block[block->insts[i].dst] = b;
+        }
+    }
+
+    // Loops are numbered outermost first, so going backwards handles nested loops first
+    for (uint32_t l = cfg->loop_count; l-- > 0;) {
+        uint32_t index;
+        uint32_t preheader = entry_block(fn, cfg, l, &index);
+        uint32_t succs[2];
+        if (preheader == NO_BLOCK || ir_successors(&fn->blocks[preheader], succs) != 1) continue;
+        hoist_invariants(l, preheader);
+        hoist_constants(l, preheader, options->target);
+    }
+
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        IrBlock *block = &fn->blocks[b];
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < block->count; i++) {
+            if (block->insts[i].op != IR_NOP) block->insts[kept++] = block->insts[i];
+        }
+        block->count = kept;
+    }
+    fn = NULL;
+    cfg = NULL;
+    def_block = NULL;
+}
@@ -0,0 +1,13 @@
+#ifndef LICM_H_
+#define LICM_H_
+
+#include "ir.h"
+#include "pipeline.h"
+
+// Loop-invariant code motion over SSA form. Every loop gets a preheader; arithmetic whose
+// operands do not change inside the loop moves there, innermost loops first, and so do the
+// constants the RV32 printer would otherwise load with li on every iteration.
+
+void licm_hoist_invariants(IrFunction *fn, const CompilerOptions *options);
+
+#endif
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lexer.h"
+#include "parser.h"
+#include "intern.h"
+#include "lower.h"
+
+// --- Lowering State ---
+static const Ast *tree = NULL;
+static IrFunction *fn = NULL;
+static uint32_t current_block = 0;   // Block receiving new instructions
+static uint32_t *current_var = NULL; // SymbolId -> variable slot + 1, 0 if undeclared
+static uint32_t *pinned_var = NULL;  // NodeId -> slot + 1 a WHILE condition's variable had at the loop entry, 0 if none
+
+// Maps an AST operator/comparator kind to its IR opcode
+static IrOp lower_operator(TokenKind kind) {
+    switch (kind) {
+        case OP_ADD: return IR_ADD;
+        case OP_SUB: return IR_SUB;
+        case OP_MUL: return IR_MUL;
+        case OP_DIV: return IR_DIV;
+        case OP_MOD: return IR_REM;
+        case CMP_EQ: return IR_SEQ;
+        case CMP_NEQ: return IR_SNE;
+        case CMP_LESS: return IR_SLT;
+        case CMP_LESS_EQ: return IR_SLE;
+        case CMP_GREATER: return IR_SGT;
+        case CMP_GREATER_EQ: return IR_SGE;
+        default:
+            fprintf(stderr, "CodeGen Error: Unsupported operator '%s'\n", token_kind_name(kind));
+            exit(EXIT_FAILURE);
+    }
+}
+
+static uint32_t lookup_var(SymbolId symbol, const char *message) {
+    uint32_t slot = current_var[symbol];
+    if (slot == 0) {
+        fprintf(stderr, "CodeGen Error: %s '%s'\n", message, symbol_name(symbol));
+        exit(EXIT_FAILURE);
+    }
+    return slot - 1;
+}
+
+// Starts emitting into a new block that nothing jumps to (code after exit)
+static void start_unreachable_block(void) {
+    current_block = ir_new_block(fn);
+}
+
+// --- Expressions ---
+
+// Lowers an expression and returns the operand holding its value. Literals become immediates.
+static Operand lower_expression(NodeId id) {
+    const Node *node = ast_node(tree, id);
+    switch (node->type) {
+        case INT:
+            return ir_imm(node->as.value);
+
+        case IDENTIFIER: {
+            uint32_t var = pinned_var[id] ? pinned_var[id] - 1 : lookup_var(node->as.symbol, "Undefined variable");
+            IrInst *load = ir_append(fn, current_block, IR_LOAD);
+            load->dst = ir_new_vreg(fn);
+            load->var = var;
+            return ir_reg(load->dst);
+        }
+
+        case OPERATOR:
+        case COMP: {
+            IrOp op = lower_operator(node->kind);
+            Operand a = lower_expression(node->child1);
+            Operand b = lower_expression(node->child2);
+            IrInst *inst = ir_append(fn, current_block, op);
+            inst->dst = ir_new_vreg(fn);
+            inst->a = a;
+            inst->b = b;
+            return ir_reg(inst->dst);
+        }
+
+        default:
+            fprintf(stderr, "CodeGen Error: Unexpected node type in expression: %d (%s)\n", node->type, token_kind_name(node->kind));
+            exit(EXIT_FAILURE);
+    }
+}
+
+// Ends the current block with a branch to if_true/if_false on the condition.
+// Comparisons are fused into the branch; anything else branches on "value != 0".
+static void lower_condition(NodeId id, uint32_t if_true, uint32_t if_false) {
+    const Node *node = ast_node(tree, id);
+    if (node->type == COMP) {
+        IrOp cmp = lower_operator(node->kind);
+        Operand a = lower_expression(node->child1);
+        Operand b = lower_expression(node->child2);
+        ir_set_branch(fn, current_block, cmp, a, b, if_true, if_false);
+    } else {
+        Operand value = lower_expression(id);
+        ir_set_branch(fn, current_block, IR_SNE, value, ir_imm(0), if_true, if_false);
+    }
+}
+
+// Binds the variables of a WHILE condition to the declarations visible at the loop entry. The
+// condition is lowered again after the body, which may declare new variables of the same names.
+static void pin_condition_variables(NodeId id) {
+    const Node *node = ast_node(tree, id);
+    if (node->type == IDENTIFIER) {
+        pinned_var[id] = current_var[node->as.symbol];
+    } else if (node->type == OPERATOR || node->type == COMP) {
+        pin_condition_variables(node->child1);
+        pin_condition_variables(node->child2);
+    }
+}
+
+// --- Statements ---
+
+static void lower_statement(NodeId id);
+
+static void lower_statement_list(NodeId id) {
+    while (id != NIL_NODE) {
+        lower_statement(id);
+        id = ast_node(tree, id)->next;
+    }
+}
+
+static void lower_statement(NodeId id) {
+    if (id == NIL_NODE) return;
+    const Node *node = ast_node(tree, id);
+
+    switch (node->kind) {
+        case NODE_DECLARE_INT: {
+            SymbolId symbol = ast_node(tree, node->child1)->as.symbol;
+            // The new variable is already visible in its own initializer, as in codegen.c
+            uint32_t var = ir_new_var(fn, symbol);
+            current_var[symbol] = var + 1;
+            Operand value = lower_expression(node->child2);
+            IrInst *store = ir_append(fn, current_block, IR_STORE);
+            store->var = var;
+            store->a = value;
+            break;
+        }
+
+        case NODE_ASSIGN: {
+            SymbolId symbol = ast_node(tree, node->child1)->as.symbol;
+            Operand value = lower_expression(node->child2);
+            IrInst *store = ir_append(fn, current_block, IR_STORE);
+            store->var = lookup_var(symbol, "Assignment to undeclared variable");
+            store->a = value;
+            break;
+        }
+
+        case KW_EXIT: {
+            Operand code = lower_expression(node->child1);
+            ir_set_exit(fn, current_block, code);
+            start_unreachable_block();
+            break;
+        }
+
+        case KW_WRITE: {
+            Operand value = lower_expression(node->child2);
+            IrInst *write = ir_append(fn, current_block, IR_WRITE);
+            write->a = value;
+            break;
+        }
+
+        case KW_IF: {
+            uint32_t then_block = ir_new_block(fn);
+            uint32_t else_block = node->as.else_branch != NIL_NODE ? ir_new_block(fn) : NO_BLOCK;
+            uint32_t join_block = ir_new_block(fn);
+            lower_condition(node->child1, then_block, else_block != NO_BLOCK ? else_block : join_block);
+
+            current_block = then_block;
+            lower_statement(node->child2);
+            ir_set_jump(fn, current_block, join_block);
+
+            if (else_block != NO_BLOCK) {
+                current_block = else_block;
+                lower_statement(node->as.else_branch);
+                ir_set_jump(fn, current_block, join_block);
+            }
+            current_block = join_block;
+            break;
+        }
+
+        case KW_WHILE: {
+            // Guarded do-while: the condition is tested before entering the body and again at
+            // its end, so the back edge is the only branch per iteration and the body is the
+            // loop header
+            uint32_t body = ir_new_block(fn);
+            uint32_t exit_block = ir_new_block(fn);
+            lower_condition(node->child1, body, exit_block);
+            pin_condition_variables(node->child1);
+
+            current_block = body;
+            lower_statement(node->child2);
+            lower_condition(node->child1, body, exit_block);
+
+            current_block = exit_block;
+            break;
+        }
+
+        case NODE_BLOCK:
+            lower_statement_list(node->child1);
+            break;
+
+        default:
+            if (node->type == OPERATOR || node->type == COMP) {
+                fprintf(stderr, "CodeGen Error: Operator '%s' cannot be a standalone statement\n", token_kind_name(node->kind));
+                exit(EXIT_FAILURE);
+            }
+            fprintf(stderr, "CodeGen Warning: Unexpected node type as statement: %d (%s)\n", node->type, token_kind_name(node->kind));
+            break;
+    }
+}
+
+// --- Entry Point ---
+
+// Lowers the whole program into a single IR function (main). Variables stay in memory slots.
+IrFunction *lower_program(const Ast *ast, Arena *arena) {
+    tree = ast;
+    fn = ir_function_new(arena);
+    current_var = arena_calloc(arena, symbol_count() + 1, sizeof(uint32_t));
+    pinned_var = arena_calloc(arena, ast->count, sizeof(uint32_t));
+    current_block = ir_new_block(fn);
+
+    lower_statement_list(ast_node(ast, ast->root)->child1);
+    ir_set_return(fn, current_block);
+
+    IrFunction *result = fn;
+    tree = NULL;
+    fn = NULL;
+    current_var = NULL;
+    pinned_var = NULL;
+    return result;
+}
@@ -0,0 +1,9 @@
+#ifndef LOWER_H_
+#define LOWER_H_
+
+#include "parser.h"
+#include "ir.h"
+
+IrFunction *lower_program(const Ast *ast, Arena *arena);
+
+#endif
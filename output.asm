@@ -19,9 +19,9 @@ main:
   li a0, 42
   sw a0, -4(s0)
   # WHILE Loop
-L0:
   lw a0, -4(s0)
-  ble a0, 0, L1
+  ble a0, zero, L1
+L0:
   # WHILE Body
   # Entering Block
   lw a0, -4(s0)
@@ -29,7 +29,9 @@ L0:
   # Assignment: x = ...
   sw a0, -4(s0)
   # Exiting Block
-  j L0
+  # WHILE Test
+  lw a0, -4(s0)
+  bgt a0, zero, L0
 L1:
   # END WHILE
   li a0, 0
@@ -16,96 +16,145 @@ void parser_error(const char *message, size_t line_number)
   exit(EXIT_FAILURE);
 }
 
+// Tree being built by the parser
+static Ast *tree = NULL;
+
+#define INITIAL_NODE_CAPACITY 256
+
 // Node Creation
-Node *create_node(char *value, TokenType type)
+// Appends a node to the pool and returns its index. Any Node pointer taken before this call
+// may be invalidated, so assign a child's index to a local before storing it in its parent.
+NodeId create_node(TokenType type, TokenKind kind)
 {
-  Node *node = malloc(sizeof(Node));
-  if (!node)
+  if (tree->count == tree->capacity)
   {
-    perror("Failed to allocate memory for Node");
-    exit(EXIT_FAILURE);
+    uint32_t capacity = tree->capacity ? tree->capacity * 2 : INITIAL_NODE_CAPACITY;
+    Node *nodes = realloc(tree->nodes, (size_t)capacity * sizeof(Node));
+    if (nodes == NULL)
+    {
+      fprintf(stderr, "Error: Out of memory for AST nodes\n");
+      exit(EXIT_FAILURE);
+    }
+    tree->nodes = nodes;
+    tree->capacity = capacity;
   }
-  // Allocate memory and copy the value
-  if (value != NULL)
+
+  NodeId id = tree->count++;
+  Node *node = ast_node(tree, id);
+  memset(node, 0, sizeof(*node));
+  node->type = (uint8_t)type;
+  node->kind = (uint8_t)kind;
+  return id;
+}
+
+// Creates a node for a literal token: INT literals keep their value, strings their interned text
+NodeId create_node_from_token(Token token, TokenType type)
+{
+  NodeId id = create_node(type, token.kind);
+  if (type == INT)
   {
-    node->value = malloc(strlen(value) + 1);
-    if (!node->value)
+    // Accumulate in 32 bits so literals wrap exactly like RV32 registers do
+    uint32_t value = 0;
+    const char *text = token_text(token);
+    for (size_t i = 0; i < token_length(token); i++)
     {
-      perror("Failed to allocate memory for Node value");
-      free(node);
-      exit(EXIT_FAILURE);
+      value = value * 10u + (uint32_t)(text[i] - '0');
     }
-    strcpy(node->value, value);
+    ast_node(tree, id)->as.value = (int32_t)value;
   }
   else
   {
-    node->value = NULL; // Allow nodes without string values (like 'PROGRAM')
+    ast_node(tree, id)->as.symbol = intern(token_text(token), token_length(token));
   }
-
-  node->type = type;
-  node->child1 = NULL;
-  node->child2 = NULL;
-  node->child3 = NULL;
-  node->next = NULL;
-  return node;
+  return id;
 }
 
-// Free AST
-void free_tree(Node *node)
+// Creates an IDENTIFIER node that carries only the token's interned symbol
+NodeId create_symbol_node(Token token)
 {
-  if (node == NULL)
-  {
-    return;
-  }
-  free_tree(node->child1);
-  free_tree(node->child2);
-  free_tree(node->child3);
-  free_tree(node->next); // Free statement sequences
-  free(node->value);     // Free the copied string
-  free(node);
+  NodeId id = create_node(IDENTIFIER, KIND_NONE);
+  ast_node(tree, id)->as.symbol = token.symbol;
+  return id;
 }
 
 // Print AST (Updated for new structure)
-void print_tree(Node *node, int indent, const char *identifier)
+void print_tree(const Ast *ast, NodeId id, int indent, const char *identifier)
 {
-  if (node == NULL)
+  if (id == NIL_NODE)
   {
     return;
   }
+  const Node *node = ast_node(ast, id);
   for (int i = 0; i < indent; i++)
   {
     printf("  ");
   }
 
   printf("%s -> ", identifier);
-  // Print node type and value (if available)
-  // You might want a function to convert TokenType enum back to string for better printing
+  // Print node type and payload (if any)
   printf("Type: %d", node->type);
-  if (node->value)
+  if (node->kind != KIND_NONE)
+  {
+    printf(", Kind: %s", token_kind_name(node->kind));
+  }
+  switch (node->type)
   {
-    printf(", Value: \"%s\"", node->value);
+  case INT:
+    printf(", Value: %ld", (long)node->as.value);
+    break;
+  case STRING:
+    printf(", Value: \"%s\"", symbol_name(node->as.symbol));
+    break;
+  case IDENTIFIER:
+    printf(", Symbol: \"%s\" (#%lu)", symbol_name(node->as.symbol), (unsigned long)node->as.symbol);
+    break;
+  default:
+    break;
   }
   printf("\n");
 
-  print_tree(node->child1, indent + 1, "Child1");
-  print_tree(node->child2, indent + 1, "Child2");
-  print_tree(node->child3, indent + 1, "Child3");
-  print_tree(node->next, indent, "NextStmt"); // Next statement is at the same level
+  print_tree(ast, node->child1, indent + 1, "Child1");
+  print_tree(ast, node->child2, indent + 1, "Child2");
+  if (node->kind == KW_IF)
+  {
+    print_tree(ast, node->as.else_branch, indent + 1, "Child3");
+  }
+  print_tree(ast, node->next, indent, "NextStmt"); // Next statement is at the same level
+}
+
+// Reports how much memory the node pool takes
+void print_ast_stats(const Ast *ast)
+{
+  uint32_t nodes = ast->count - 1; // Not counting the NIL_NODE slot
+  printf("AST: %lu nodes, %lu bytes used (%lu bytes per node), %lu bytes reserved\n", (unsigned long)nodes,
+         (unsigned long)ast->count * sizeof(Node), (unsigned long)sizeof(Node),
+         (unsigned long)ast->capacity * sizeof(Node));
+}
+
+// Releases the node pool; every NodeId of the tree becomes invalid
+void free_tree(Ast *ast)
+{
+  if (ast == NULL)
+  {
+    return;
+  }
+  free(ast->nodes);
+  free(ast);
 }
 
 // --- Token Handling Helper ---
 
-// Consumes the current token if it matches the expected type and optionally value.
-// Advances the token pointer. Errors out if mismatch.
-Token consume_token(Token **current_token_ptr, TokenType expected_type, const char *expected_value)
+// Consumes the current token if it matches the expected type and optionally kind
+// (KIND_NONE accepts any kind). Advances the token pointer. Errors out if mismatch.
+Token consume_token(Lexer *tokens, TokenType expected_type, TokenKind expected_kind)
 {
-  Token current = **current_token_ptr;
+  Token current = peek_token(tokens, 0);
   if (current.type == END_OF_TOKENS)
   {
     char error_msg[200]; // Increased buffer size for safety
-    if (expected_value)
+    if (expected_kind != KIND_NONE)
     {
-      sprintf(error_msg, "Unexpected end of input. Expected token type %d (\"%s\")", expected_type, expected_value);
+      sprintf(error_msg, "Unexpected end of input. Expected token type %d (\"%s\")", expected_type, token_kind_name(expected_kind));
     }
     else
     {
@@ -116,44 +165,62 @@ Token consume_token(Token **current_token_ptr, TokenType expected_type, const ch
   if (current.type != expected_type)
   {
     char error_msg[100];
-    sprintf(error_msg, "Expected token type %d but got %d ('%s')", expected_type, current.type, current.value);
+    sprintf(error_msg, "Expected token type %d but got %d ('%.*s')", expected_type, current.type,
+            (int)token_length(current) > 40 ? 40 : (int)token_length(current), token_text(current));
     parser_error(error_msg, current.line_num);
   }
-  if (expected_value != NULL && strcmp(current.value, expected_value) != 0)
+  if (expected_kind != KIND_NONE && current.kind != expected_kind)
   {
     char error_msg[100];
-    sprintf(error_msg, "Expected token value '%s' but got '%s'", expected_value, current.value);
+    sprintf(error_msg, "Expected token value '%s' but got '%.*s'", token_kind_name(expected_kind),
+            (int)token_length(current) > 40 ? 40 : (int)token_length(current), token_text(current));
     parser_error(error_msg, current.line_num);
   }
-  (*current_token_ptr)++; // Advance the pointer in the caller
+  next_token(tokens); // Advance past the token
   return current;
 }
 
 // Peeks at the current token type without consuming
-TokenType peek_token_type(Token **current_token_ptr)
+TokenType peek_token_type(Lexer *tokens)
+{
+  return peek_token(tokens, 0).type;
+}
+
+// Peeks at the current token kind without consuming
+TokenKind peek_token_kind(Lexer *tokens)
 {
-  return (**current_token_ptr).type;
+  return peek_token(tokens, 0).kind;
 }
 
 // --- Parsing Functions ---
 
 // Forward declarations for recursive parsing
-Node *parse_statement(Token **current_token_ptr);
-Node *parse_expression(Token **current_token_ptr);
-Node *parse_block(Token **current_token_ptr);
+NodeId parse_statement(Lexer *tokens);
+NodeId parse_expression(Lexer *tokens);
+NodeId parse_block(Lexer *tokens);
 
-// Parses a simple factor (INT, IDENTIFIER)
-Node *parse_factor(Token **current_token_ptr)
+// Parses a factor: INT, IDENTIFIER, STRING or '(' expression ')'
+NodeId parse_factor(Lexer *tokens)
 {
-  Token current = **current_token_ptr;
-  Node *node = NULL;
+  Token current = peek_token(tokens, 0);
+  NodeId node = NIL_NODE;
 
-  if (current.type == INT || current.type == IDENTIFIER || current.type == STRING)
+  if (current.type == IDENTIFIER)
+  {
+    node = create_symbol_node(current);
+    next_token(tokens); // Consume the token
+  }
+  else if (current.type == INT || current.type == STRING)
+  {
+    node = create_node_from_token(current, current.type);
+    next_token(tokens); // Consume the token
+  }
+  else if (current.type == SEPARATOR && current.kind == SEP_LPAREN)
   {
-    node = create_node(current.value, current.type);
-    (*current_token_ptr)++; // Consume the token
+    next_token(tokens);
+    node = parse_expression(tokens);
+    consume_token(tokens, SEPARATOR, SEP_RPAREN);
   }
-  // TODO: Add handling for parenthesized expressions '(' expression ')' here
   else
   {
     parser_error("Expected Integer, Identifier, String, or '('", current.line_num);
@@ -161,94 +228,134 @@ Node *parse_factor(Token **current_token_ptr)
   return node;
 }
 
-// Parses a simple expression (Factor [OPERATOR Factor]) - VERY basic!
-// Does NOT handle precedence or associativity correctly.
-Node *parse_expression(Token **current_token_ptr)
+// Binding strength of a binary operator token, 0 if the token does not continue an expression.
+// Comparisons bind loosest, then + and -, then * / %. All of them associate to the left.
+static int binary_precedence(Token token)
 {
-  Node *left_node = parse_factor(current_token_ptr);
-
-  // Check if the next token is an operator (or comparison)
-  TokenType next_type = peek_token_type(current_token_ptr);
-  if (next_type == OPERATOR || next_type == COMP)
+  if (token.type == COMP)
   {
-    Token op_token = consume_token(current_token_ptr, next_type, NULL);
-    Node *op_node = create_node(op_token.value, op_token.type);
-    Node *right_node = parse_factor(current_token_ptr); // Parse the right side
-
-    op_node->child1 = left_node;
-    op_node->child2 = right_node;
-    return op_node; // Return the operation node
+    return 1;
   }
-  else
+  if (token.type == OPERATOR)
+  {
+    switch (token.kind)
+    {
+    case OP_ADD:
+    case OP_SUB:
+      return 2;
+    case OP_MUL:
+    case OP_DIV:
+    case OP_MOD:
+      return 3;
+    default:
+      break;
+    }
+  }
+  return 0;
+}
+
+#define MAX_PRECEDENCE 3
+
+// Parses operands joined by operators of at least min_precedence (precedence climbing)
+static NodeId parse_binary(Lexer *tokens, int min_precedence)
+{
+  NodeId left_node = min_precedence > MAX_PRECEDENCE ? parse_factor(tokens) : parse_binary(tokens, min_precedence + 1);
+  if (min_precedence > MAX_PRECEDENCE)
   {
-    // It's just a single factor
     return left_node;
   }
+
+  // Each further operator at this level takes everything parsed so far as its left operand
+  while (binary_precedence(peek_token(tokens, 0)) == min_precedence)
+  {
+    Token op_token = peek_token(tokens, 0);
+    next_token(tokens);
+    NodeId op_node = create_node(op_token.type, op_token.kind);
+    NodeId right_node = parse_binary(tokens, min_precedence + 1);
+
+    ast_node(tree, op_node)->child1 = left_node;
+    ast_node(tree, op_node)->child2 = right_node;
+    left_node = op_node;
+  }
+  return left_node;
+}
+
+// Parses an expression: comparisons of sums of products of factors
+NodeId parse_expression(Lexer *tokens)
+{
+  return parse_binary(tokens, 1);
 }
 
 // Parses an EXIT statement: EXIT ( expression ) ;
-Node *parse_exit_statement(Token **current_token_ptr)
+NodeId parse_exit_statement(Lexer *tokens)
 {
-  consume_token(current_token_ptr, KEYWORD, "EXIT");
-  Node *exit_node = create_node("EXIT", KEYWORD);
+  consume_token(tokens, KEYWORD, KW_EXIT);
+  NodeId exit_node = create_node(KEYWORD, KW_EXIT);
 
-  consume_token(current_token_ptr, SEPARATOR, "(");
-  exit_node->child1 = parse_expression(current_token_ptr); // Argument
-  consume_token(current_token_ptr, SEPARATOR, ")");
-  consume_token(current_token_ptr, SEPARATOR, ";");
+  consume_token(tokens, SEPARATOR, SEP_LPAREN);
+  NodeId argument = parse_expression(tokens);
+  ast_node(tree, exit_node)->child1 = argument;
+  consume_token(tokens, SEPARATOR, SEP_RPAREN);
+  consume_token(tokens, SEPARATOR, SEP_SEMICOLON);
 
   return exit_node;
 }
 
 // Parses a WRITE statement: WRITE ( expression, expression ) ;
-Node *parse_write_statement(Token **current_token_ptr)
+NodeId parse_write_statement(Lexer *tokens)
 {
-  consume_token(current_token_ptr, KEYWORD, "WRITE");
-  Node *write_node = create_node("WRITE", KEYWORD);
-
-  consume_token(current_token_ptr, SEPARATOR, "(");
-  write_node->child1 = parse_expression(current_token_ptr); // First arg (string/identifier)
-  consume_token(current_token_ptr, SEPARATOR, ",");
-  write_node->child2 = parse_expression(current_token_ptr); // Second arg (length/value)
-  consume_token(current_token_ptr, SEPARATOR, ")");
-  consume_token(current_token_ptr, SEPARATOR, ";");
+  consume_token(tokens, KEYWORD, KW_WRITE);
+  NodeId write_node = create_node(KEYWORD, KW_WRITE);
+
+  consume_token(tokens, SEPARATOR, SEP_LPAREN);
+  NodeId first = parse_expression(tokens); // First arg (string/identifier)
+  ast_node(tree, write_node)->child1 = first;
+  consume_token(tokens, SEPARATOR, SEP_COMMA);
+  NodeId second = parse_expression(tokens); // Second arg (length/value)
+  ast_node(tree, write_node)->child2 = second;
+  consume_token(tokens, SEPARATOR, SEP_RPAREN);
+  consume_token(tokens, SEPARATOR, SEP_SEMICOLON);
 
   return write_node;
 }
 
 // Parses variable declaration or assignment
 // INT identifier = expression ;  OR  identifier = expression ;
-Node *parse_assignment_or_declaration(Token **current_token_ptr)
+NodeId parse_assignment_or_declaration(Lexer *tokens)
 {
-  Node *node = NULL;
-  Token first_token = **current_token_ptr;
+  NodeId node = NIL_NODE;
+  Token first_token = peek_token(tokens, 0);
 
-  if (first_token.type == KEYWORD && strcmp(first_token.value, "INT") == 0)
+  if (first_token.kind == KW_INT)
   {
     // Declaration: INT identifier = expression ;
-    consume_token(current_token_ptr, KEYWORD, "INT");
-    node = create_node("DECLARE_INT", KEYWORD); // Use a specific type
+    consume_token(tokens, KEYWORD, KW_INT);
+    node = create_node(KEYWORD, NODE_DECLARE_INT); // Use a specific type
 
-    Token identifier_token = consume_token(current_token_ptr, IDENTIFIER, NULL);
-    node->child1 = create_node(identifier_token.value, IDENTIFIER); // Store identifier name
+    Token identifier_token = consume_token(tokens, IDENTIFIER, KIND_NONE);
+    NodeId identifier = create_symbol_node(identifier_token); // Store identifier name
+    ast_node(tree, node)->child1 = identifier;
 
-    consume_token(current_token_ptr, OPERATOR, "=");
-    node->child2 = parse_expression(current_token_ptr); // Store initial value expression
+    consume_token(tokens, OPERATOR, OP_ASSIGN);
+    NodeId value = parse_expression(tokens); // Store initial value expression
+    ast_node(tree, node)->child2 = value;
 
-    consume_token(current_token_ptr, SEPARATOR, ";");
+    consume_token(tokens, SEPARATOR, SEP_SEMICOLON);
   }
   else if (first_token.type == IDENTIFIER)
   {
     // Assignment: identifier = expression ;
-    Token identifier_token = consume_token(current_token_ptr, IDENTIFIER, NULL);
-    node = create_node("ASSIGN", OPERATOR); // Use a specific type
+    Token identifier_token = consume_token(tokens, IDENTIFIER, KIND_NONE);
+    node = create_node(OPERATOR, NODE_ASSIGN); // Use a specific type
 
-    node->child1 = create_node(identifier_token.value, IDENTIFIER); // Store identifier name
+    NodeId identifier = create_symbol_node(identifier_token); // Store identifier name
+    ast_node(tree, node)->child1 = identifier;
 
-    consume_token(current_token_ptr, OPERATOR, "=");
-    node->child2 = parse_expression(current_token_ptr); // Store value expression
+    consume_token(tokens, OPERATOR, OP_ASSIGN);
+    NodeId value = parse_expression(tokens); // Store value expression
+    ast_node(tree, node)->child2 = value;
 
-    consume_token(current_token_ptr, SEPARATOR, ";");
+    consume_token(tokens, SEPARATOR, SEP_SEMICOLON);
   }
   else
   {
@@ -258,181 +365,175 @@ Node *parse_assignment_or_declaration(Token **current_token_ptr)
 }
 
 // Parses an IF statement: IF ( expression ) statement_or_block [ ELSE statement_or_block ]
-Node *parse_if_statement(Token **current_token_ptr)
+NodeId parse_if_statement(Lexer *tokens)
 {
-  consume_token(current_token_ptr, KEYWORD, "IF");
-  Node *if_node = create_node("IF", KEYWORD);
+  consume_token(tokens, KEYWORD, KW_IF);
+  NodeId if_node = create_node(KEYWORD, KW_IF);
 
-  consume_token(current_token_ptr, SEPARATOR, "(");
-  if_node->child1 = parse_expression(current_token_ptr); // Condition
-  consume_token(current_token_ptr, SEPARATOR, ")");
+  consume_token(tokens, SEPARATOR, SEP_LPAREN);
+  NodeId condition = parse_expression(tokens);
+  ast_node(tree, if_node)->child1 = condition;
+  consume_token(tokens, SEPARATOR, SEP_RPAREN);
 
   // Parse the 'then' part (can be a single statement or a block)
-  if (peek_token_type(current_token_ptr) == SEPARATOR && strcmp((**current_token_ptr).value, "{") == 0)
+  NodeId then_branch;
+  if (peek_token_kind(tokens) == SEP_LBRACE)
   {
-    if_node->child2 = parse_block(current_token_ptr);
+    then_branch = parse_block(tokens);
   }
   else
   {
-    if_node->child2 = parse_statement(current_token_ptr);
+    then_branch = parse_statement(tokens);
+  }
+  ast_node(tree, if_node)->child2 = then_branch;
+
+  // Optional 'else' part
+  if (peek_token_kind(tokens) == KW_ELSE)
+  {
+    consume_token(tokens, KEYWORD, KW_ELSE);
+    NodeId else_branch;
+    if (peek_token_kind(tokens) == SEP_LBRACE)
+    {
+      else_branch = parse_block(tokens);
+    }
+    else
+    {
+      else_branch = parse_statement(tokens);
+    }
+    ast_node(tree, if_node)->as.else_branch = else_branch;
   }
 
   return if_node;
 }
 
 // Parses a WHILE statement: WHILE ( expression ) statement_or_block
-Node *parse_while_statement(Token **current_token_ptr)
+NodeId parse_while_statement(Lexer *tokens)
 {
-  consume_token(current_token_ptr, KEYWORD, "WHILE");
-  Node *while_node = create_node("WHILE", KEYWORD);
+  consume_token(tokens, KEYWORD, KW_WHILE);
+  NodeId while_node = create_node(KEYWORD, KW_WHILE);
 
-  consume_token(current_token_ptr, SEPARATOR, "(");
-  while_node->child1 = parse_expression(current_token_ptr); // Condition
-  consume_token(current_token_ptr, SEPARATOR, ")");
+  consume_token(tokens, SEPARATOR, SEP_LPAREN);
+  NodeId condition = parse_expression(tokens);
+  ast_node(tree, while_node)->child1 = condition;
+  consume_token(tokens, SEPARATOR, SEP_RPAREN);
 
   // Parse the body (can be a single statement or a block)
-  if (peek_token_type(current_token_ptr) == SEPARATOR && strcmp((**current_token_ptr).value, "{") == 0)
+  NodeId body;
+  if (peek_token_kind(tokens) == SEP_LBRACE)
   {
-    while_node->child2 = parse_block(current_token_ptr);
+    body = parse_block(tokens);
   }
   else
   {
-    while_node->child2 = parse_statement(current_token_ptr);
+    body = parse_statement(tokens);
   }
+  ast_node(tree, while_node)->child2 = body;
 
   return while_node;
 }
 
 // Parses a statement based on the current token
-Node *parse_statement(Token **current_token_ptr)
+NodeId parse_statement(Lexer *tokens)
 {
-  TokenType type = peek_token_type(current_token_ptr);
-  Token current = **current_token_ptr; // For checking value
-
-  if (type == KEYWORD)
+  switch (peek_token_kind(tokens))
   {
-    if (strcmp(current.value, "EXIT") == 0)
-    {
-      return parse_exit_statement(current_token_ptr);
-    }
-    else if (strcmp(current.value, "INT") == 0)
-    {
-      return parse_assignment_or_declaration(current_token_ptr);
-    }
-    else if (strcmp(current.value, "IF") == 0)
-    {
-      return parse_if_statement(current_token_ptr);
-    }
-    else if (strcmp(current.value, "WHILE") == 0)
-    {
-      return parse_while_statement(current_token_ptr);
-    }
-    else if (strcmp(current.value, "WRITE") == 0)
+  case KW_EXIT:
+    return parse_exit_statement(tokens);
+  case KW_INT:
+    return parse_assignment_or_declaration(tokens);
+  case KW_IF:
+    return parse_if_statement(tokens);
+  case KW_WHILE:
+    return parse_while_statement(tokens);
+  case KW_WRITE:
+    return parse_write_statement(tokens);
+  case SEP_LBRACE:
+    return parse_block(tokens);
+  case SEP_SEMICOLON:
+    // Empty statement
+    consume_token(tokens, SEPARATOR, SEP_SEMICOLON);
+    return NIL_NODE; // Represent empty statement as NIL_NODE
+  default:
+    if (peek_token_type(tokens) == IDENTIFIER)
     {
-      return parse_write_statement(current_token_ptr);
+      // Must be an assignment if it starts with an identifier
+      return parse_assignment_or_declaration(tokens);
     }
-    // Add other keywords (WHILE, FOR, etc.) here
-  }
-  else if (type == IDENTIFIER)
-  {
-    // Must be an assignment if it starts with an identifier
-    return parse_assignment_or_declaration(current_token_ptr);
-  }
-  else if (type == SEPARATOR && strcmp(current.value, "{") == 0)
-  {
-    return parse_block(current_token_ptr);
-  }
-  else if (type == SEPARATOR && strcmp(current.value, ";") == 0)
-  {
-    // Empty statement
-    consume_token(current_token_ptr, SEPARATOR, ";");
-    return NULL; // Represent empty statement as NULL or a specific node type
+    break;
   }
 
   // If we get here, it's an unexpected token at the start of a statement
-  parser_error("Unexpected token at start of statement", current.line_num);
-  return NULL; // Should not reach here
+  parser_error("Unexpected token at start of statement", peek_token(tokens, 0).line_num);
+  return NIL_NODE; // Should not reach here
 }
 
-// Parses a block of statements: { statement* }
-Node *parse_block(Token **current_token_ptr)
+// Parses statements into a list linked through 'next' until END_OF_TOKENS or (when
+// stop_at_brace is set) a closing brace. Returns the first statement.
+static NodeId parse_statement_list(Lexer *tokens, int stop_at_brace)
 {
-  consume_token(current_token_ptr, SEPARATOR, "{");
-
-  Node *block_node = create_node("BLOCK", SEPARATOR); // Represents the block scope
-  Node *head_statement = NULL;
-  Node *last_statement = NULL;
+  NodeId head_statement = NIL_NODE;
+  NodeId last_statement = NIL_NODE;
 
-  while (peek_token_type(current_token_ptr) != END_OF_TOKENS &&
-         !(peek_token_type(current_token_ptr) == SEPARATOR && strcmp((**current_token_ptr).value, "}") == 0))
+  while (peek_token_type(tokens) != END_OF_TOKENS &&
+         !(stop_at_brace && peek_token_kind(tokens) == SEP_RBRACE))
   {
-    Node *statement = parse_statement(current_token_ptr);
-    if (statement != NULL)
-    { // Handle empty statements if they return NULL
-      if (head_statement == NULL)
+    NodeId statement = parse_statement(tokens);
+    if (statement != NIL_NODE)
+    { // Empty statements produce no node
+      if (head_statement == NIL_NODE)
       {
         head_statement = statement;
-        last_statement = statement;
       }
       else
       {
-        last_statement->next = statement; // Link statements using 'next'
-        last_statement = statement;
+        ast_node(tree, last_statement)->next = statement; // Link statements using 'next'
       }
+      last_statement = statement;
     }
   }
+  return head_statement;
+}
+
+// Parses a block of statements: { statement* }
+NodeId parse_block(Lexer *tokens)
+{
+  consume_token(tokens, SEPARATOR, SEP_LBRACE);
+
+  NodeId block_node = create_node(SEPARATOR, NODE_BLOCK); // Represents the block scope
+  NodeId head_statement = parse_statement_list(tokens, 1);
 
-  consume_token(current_token_ptr, SEPARATOR, "}");
+  consume_token(tokens, SEPARATOR, SEP_RBRACE);
 
-  block_node->child1 = head_statement; // First statement in the block
+  ast_node(tree, block_node)->child1 = head_statement; // First statement in the block
   return block_node;
 }
 
 // Main Parser Function
-Node *parser(Token *tokens)
+// Tokens are pulled from the lexer as needed, so the token array is never materialized.
+// The tree lives in one contiguous node pool; release it with free_tree.
+Ast *parser(Lexer *tokens)
 {
-  // Check if the input token array is empty or NULL
-  if (tokens == NULL || tokens[0].type == END_OF_TOKENS)
+  tree = calloc(1, sizeof(Ast));
+  if (tree == NULL)
   {
-    Node *root = create_node("PROGRAM", BEGINNING); // Still return a root
-    root->child1 = NULL;                            // Indicate no statements
-    return root;
+    fprintf(stderr, "Error: Out of memory for AST\n");
+    exit(EXIT_FAILURE);
   }
+  create_node(BEGINNING, KIND_NONE); // Occupies index 0 so that NIL_NODE never names a real node
 
-  Token *current_token = tokens; // Pointer to the current token
-  Node *root = create_node("PROGRAM", BEGINNING);
-  Node *head_statement = NULL;
-  Node *last_statement = NULL;
+  NodeId root = create_node(BEGINNING, NODE_PROGRAM);
+  tree->root = root;
 
-  // Expecting a sequence of statements
-  // Loop as long as we haven't reached the end
-  // Pass the ADDRESS of current_token so helper functions can advance it
-  while (peek_token_type(&current_token) != END_OF_TOKENS)
+  // Expecting a sequence of statements; an empty program still gets a root.
+  // Helper functions pull tokens from the lexer as they consume them
+  if (tokens != NULL)
   {
-    // Parse one statement. parse_statement will advance current_token
-    Node *statement = parse_statement(&current_token);
-
-    // Add the parsed statement to the linked list of statements
-    if (statement != NULL)
-    { // Check if parse_statement returned a valid node (e.g., not an empty ';')
-      if (head_statement == NULL)
-      {
-        // First statement found
-        head_statement = statement;
-        last_statement = statement;
-      }
-      else
-      {
-        // Add to the end of the list
-        last_statement->next = statement;
-        last_statement = statement; // Update the tail pointer
-      }
-    }
-    // If statement is NULL (e.g., empty statement), we just continue to the next token
+    NodeId head_statement = parse_statement_list(tokens, 0);
+    // Link the first statement of the sequence to the program root
+    ast_node(tree, root)->child1 = head_statement;
   }
 
-  // Link the first statement of the sequence to the program root
-  root->child1 = head_statement;
-
-  return root;
+  Ast *ast = tree;
+  tree = NULL;
+  return ast;
 }
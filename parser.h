@@ -1,22 +1,55 @@
 #ifndef PARSER_H_
 #define PARSER_H_
 
-typedef struct Node
+#include <stdint.h>
+#include "lexer.h"
+#include "intern.h"
+
+// Nodes are referred to by their index in the tree's node pool; index 0 is never a real node
+typedef uint32_t NodeId;
+
+#define NIL_NODE ((NodeId)0)
+
+// One AST node: 20 bytes, stored by value in the contiguous pool of an Ast.
+// The payload is selected by type (and by kind for IF):
+//   INT        -> value (wrapped to 32 bits like RV32 arithmetic)
+//   IDENTIFIER -> symbol
+//   STRING     -> symbol (the interned string contents, without quotes)
+//   KW_IF      -> else_branch
+// Operators and comparators carry their opcode in kind and have no payload.
+typedef struct
 {
-  char *value;
-  TokenType type;
-  struct Node *child1; // Renamed left -> child1 (e.g., first operand, condition, first statement)
-  struct Node *child2; // Renamed right -> child2 (e.g., second operand, then-block, next statement)
-  struct Node *child3; // For things like IF-ELSE (else-block)
-  struct Node *next;   // For sequences of statements within a block
+  uint8_t type;  // TokenType
+  uint8_t kind;  // TokenKind: keyword/operator/comparator or AST-only kind; KIND_NONE for literals
+  NodeId child1; // First operand, condition, identifier or first statement of a block
+  NodeId child2; // Second operand, value expression, then-branch or loop body
+  NodeId next;   // Next statement in the same block
+  union
+  {
+    int32_t value;
+    SymbolId symbol;
+    NodeId else_branch;
+  } as;
 } Node;
 
+typedef struct
+{
+  Node *nodes;     // nodes[0] is the unused NIL_NODE slot
+  uint32_t count;  // Including the NIL_NODE slot
+  uint32_t capacity;
+  NodeId root;     // The NODE_PROGRAM node
+} Ast;
 
-Node *parser(Token *tokens);
-void print_tree(Node *node, int indent, const char *identifier);
-Node *init_node(Node *node, char *value, TokenType type);
-void print_error(char *error_type);
-void free_tree(Node *node);
+// Returns the node behind id. The pointer is invalidated when the pool grows,
+// i.e. while the parser is still adding nodes.
+static inline Node *ast_node(const Ast *ast, NodeId id)
+{
+  return &ast->nodes[id];
+}
 
+Ast *parser(Lexer *tokens);
+void print_tree(const Ast *ast, NodeId id, int indent, const char *identifier);
+void print_ast_stats(const Ast *ast);
+void free_tree(Ast *ast);
 
-#endif
\ No newline at end of file
+#endif
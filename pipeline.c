@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipeline.h"
+#include "lower.h"
+#include "rv32.h"
+#include "emit.h"
+#include "cfg.h"
+#include "dataflow.h"
+#include "ssa.h"
+#include "evaluate.h"
+#include "sccp.h"
+#include "gvn.h"
+#include "licm.h"
+#include "closedform.h"
+#include "unroll.h"
+#include "regalloc.h"
+
+// --- Pass Table ---
+// To add a pass, write a function with the IrPass signature and list it here.
+static const IrPass passes[] = {
+    { "cleanup", 1, remove_unreachable_blocks },
+    { "evaluate", 2, evaluate_program },
+    { "mem2reg", 1, ssa_construct },
+    { "sccp", 1, sccp_propagate },
+    { "gvn", 1, gvn_eliminate },
+    { "licm", 1, licm_hoist_invariants },
+    { "closed-form", 1, closed_form_eliminate_loops },
+    { "unroll", 2, unroll_loops },
+    { "out-of-ssa", 1, ssa_destruct },
+};
+
+#define PASS_COUNT (sizeof(passes) / sizeof(passes[0]))
+
+// True if stage appears in the --dump list (or the list is "all")
+int should_dump(const CompilerOptions *options, const char *stage) {
+    const char *list = options->dump;
+    if (list == NULL) return 0;
+    size_t length = strlen(stage);
+    while (*list) {
+        const char *end = strchr(list, ',');
+        size_t item = end ? (size_t)(end - list) : strlen(list);
+        if ((item == length && strncmp(list, stage, length) == 0) || (item == 3 && strncmp(list, "all", 3) == 0)) {
+            return 1;
+        }
+        if (end == NULL) break;
+        list = end + 1;
+    }
+    return 0;
+}
+
+// --- Passes ---
+
+// Drops blocks that cannot be reached from the entry (code after exit, empty joins...)
+// and renumbers the rest, keeping their relative order. Predecessor lists lose the dropped
+// blocks and phi arguments follow them, so this also runs on SSA form.
+void remove_unreachable_blocks(IrFunction *fn, const CompilerOptions *options) {
+    (void)options;
+    uint32_t *renumber = arena_alloc(fn->arena, fn->block_count * sizeof(uint32_t));
+    uint32_t *stack = arena_alloc(fn->arena, fn->block_count * sizeof(uint32_t));
+    for (uint32_t b = 0; b < fn->block_count; b++) renumber[b] = NO_BLOCK;
+
+    // Depth-first search from the entry; renumber temporarily marks blocks as seen
+    uint32_t depth = 0;
+    stack[depth++] = 0;
+    renumber[0] = 0;
+    while (depth > 0) {
+        uint32_t b = stack[--depth];
+        uint32_t succs[2];
+        uint32_t count = ir_successors(&fn->blocks[b], succs);
+        for (uint32_t i = 0; i < count; i++) {
+            if (renumber[succs[i]] == NO_BLOCK) {
+                renumber[succs[i]] = 0;
+                stack[depth++] = succs[i];
+            }
+        }
+    }
+
+    uint32_t kept = 0;
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        if (renumber[b] == NO_BLOCK) continue;
+        renumber[b] = kept;
+        fn->blocks[kept++] = fn->blocks[b];
+    }
+    fn->block_count = kept;
+    for (uint32_t b = 0; b < kept; b++) {
+        IrBlock *block = &fn->blocks[b];
+        IrTerm *term = &block->term;
+        for (int i = 0; i < 2; i++) {
+            if (term->target[i] != NO_BLOCK) term->target[i] = renumber[term->target[i]];
+        }
+        uint32_t preds = 0;
+        for (uint32_t k = 0; k < block->pred_count; k++) {
+            uint32_t pred = renumber[block->preds[k]];
+            if (pred == NO_BLOCK) continue;
+            for (uint32_t i = 0; i < block->count && block->insts[i].op == IR_PHI; i++) {
+                block->insts[i].args[preds] = block->insts[i].args[k];
+            }
+            block->preds[preds++] = pred;
+        }
+        block->pred_count = preds;
+        for (uint32_t i = 0; i < block->count && block->insts[i].op == IR_PHI; i++) block->insts[i].arg_count = preds;
+    }
+}
+
+// --- Analyses ---
+
+// --dump=cfg: the control-flow graph, dominator tree, loop nest, liveness and reaching definitions
+static void dump_analyses(const IrFunction *fn, Arena *arena) {
+    Cfg *cfg = cfg_build(fn, arena);
+    cfg_compute_loops(cfg, arena);
+    cfg_dump(cfg, stdout);
+    liveness_dump(liveness_compute(fn, cfg, arena), cfg, stdout);
+    reaching_defs_dump(reaching_defs_compute(fn, cfg, arena), fn, cfg, stdout);
+}
+
+// --- Driver ---
+
+// Lowers the AST to IR, runs the passes enabled at options->opt_level and prints RV32 assembly.
+// IR is allocated from arena.
+int compile_ir(const Ast *ast, const char *filename, Arena *arena, const CompilerOptions *options) {
+    if (!ast || ast->root == NIL_NODE || ast_node(ast, ast->root)->kind != NODE_PROGRAM) {
+        fprintf(stderr, "CodeGen Error: Invalid root node provided to compile_ir.\n");
+        return -1;
+    }
+
+    IrFunction *fn = lower_program(ast, arena);
+    cfg_compute_predecessors(fn);
+    if (should_dump(options, "lower")) ir_dump(fn, stdout, "lower");
+
+    for (size_t i = 0; i < PASS_COUNT; i++) {
+        if (options->opt_level < passes[i].min_level) continue;
+        passes[i].run(fn, options);
+        if (should_dump(options, passes[i].name)) ir_dump(fn, stdout, passes[i].name);
+    }
+    if (should_dump(options, "cfg")) dump_analyses(fn, arena);
+
+    RegAllocKind allocator = options->regalloc;
+    if (allocator == REGALLOC_DEFAULT) allocator = options->opt_level >= 2 ? REGALLOC_IRC : REGALLOC_LINEAR;
+    RegAssignment *registers = allocator == REGALLOC_IRC ? regalloc_irc(fn, arena) : regalloc_linear_scan(fn, arena);
+    if (should_dump(options, "regalloc")) {
+        regalloc_dump(registers, fn, allocator == REGALLOC_IRC ? "iterated coalescing" : "linear scan", stdout);
+    }
+
+    Emitter out;
+    if (emit_open(&out, filename) != 0) {
+        perror("Error opening output file");
+        return -1;
+    }
+    rv32_emit_function(fn, registers, options->target, &out);
+    if (emit_close(&out) != 0) {
+        perror("Error writing output file");
+        return -1;
+    }
+
+    printf("RISC-V 32-bit code generation complete (IR, -O%d): %s\n", options->opt_level, filename);
+    return 0;
+}
@@ -0,0 +1,31 @@
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include "parser.h"
+#include "ir.h"
+#include "arena.h"
+#include "regalloc.h"
+#include "target.h"
+
+// Settings of one compilation, filled in from the command line
+typedef struct {
+    int opt_level;    // 0: direct AST code generation, 1 and up: IR pipeline
+    const char *dump; // Comma-separated pipeline stages to dump ("all" for every stage), or NULL
+    RegAllocKind regalloc;
+    const Target *target;
+    int unroll_factor; // Iterations per trip of an unrolled loop (0: UNROLL_DEFAULT_FACTOR, 1: no unrolling)
+    int fuel;          // IR instructions compile-time evaluation may run (0: EVALUATE_DEFAULT_FUEL)
+} CompilerOptions;
+
+// An IR pass. Passes run in table order when opt_level >= min_level.
+typedef struct {
+    const char *name;
+    int min_level;
+    void (*run)(IrFunction *fn, const CompilerOptions *options);
+} IrPass;
+
+int should_dump(const CompilerOptions *options, const char *stage);
+void remove_unreachable_blocks(IrFunction *fn, const CompilerOptions *options);
+int compile_ir(const Ast *ast, const char *filename, Arena *arena, const CompilerOptions *options);
+
+#endif
@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "regalloc.h"
+#include "dataflow.h"
+
+#define NO_SLOT ((uint32_t)UINT32_MAX)
+#define NO_POSITION ((uint32_t)UINT32_MAX)
+
+// Allocatable registers in order of preference within each class
+static const Reg temp_registers[] = { REG_T3, REG_T4, REG_T5, REG_T6 };
+static const Reg saved_registers[] = { REG_S1, REG_S2, REG_S3, REG_S4, REG_S5, REG_S6,
+                                       REG_S7, REG_S8, REG_S9, REG_S10, REG_S11 };
+
+#define TEMP_COUNT (sizeof(temp_registers) / sizeof(temp_registers[0]))
+#define SAVED_COUNT (sizeof(saved_registers) / sizeof(saved_registers[0]))
+#define REG_BIT(reg) ((uint32_t)1 << (reg))
+
+// --- Live Intervals ---
+
+// One range [start, end] of instruction positions per vreg (no lifetime holes). Instructions
+// are numbered 2, 4, 6... in layout order: a vreg's uses sit at the instruction's position and
+// its definition one past it, so a value whose last use is the instruction defining another
+// can hand its register over.
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+    uint8_t crosses_call; // Live across a WRITE (printf clobbers the caller-saved registers)
+} Interval;
+
+static void extend(Interval *interval, uint32_t position) {
+    if (position < interval->start) interval->start = position;
+    if (position > interval->end) interval->end = position;
+}
+
+static void extend_operand(Interval *intervals, Operand operand, uint32_t position) {
+    if (operand.kind == OPND_REG) extend(&intervals[operand.value], position);
+}
+
+typedef struct {
+    Interval *intervals;
+    const uint32_t *block_start;
+    const uint32_t *block_end;
+} IntervalBuilder;
+
+static void extend_live(void *context, VReg vreg, uint32_t block, int live_out) {
+    IntervalBuilder *builder = context;
+    extend(&builder->intervals[vreg], live_out ? builder->block_end[block] : builder->block_start[block]);
+}
+
+// Builds the interval of every vreg. Returns the number of positions used.
+static uint32_t build_intervals(const IrFunction *fn, Interval *intervals, Arena *arena) {
+    uint32_t n = fn->block_count;
+    uint32_t *block_start = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    uint32_t *block_end = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    for (VReg v = 0; v < fn->vreg_count; v++) {
+        intervals[v].start = NO_POSITION;
+        intervals[v].end = 0;
+        intervals[v].crosses_call = 0;
+    }
+
+    // Positions of the calls, counted as a running total per position
+    uint32_t position = 2;
+    for (uint32_t b = 0; b < n; b++) position += 2 * (fn->blocks[b].count + 1);
+    uint32_t position_count = position;
+    uint32_t *calls_before = arena_calloc(arena, position_count + 1, sizeof(uint32_t));
+
+    position = 2;
+    for (uint32_t b = 0; b < n; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        block_start[b] = position;
+        for (uint32_t i = 0; i < block->count; i++, position += 2) {
+            const IrInst *inst = &block->insts[i];
+            if (inst->op == IR_NOP) continue;
+            extend_operand(intervals, inst->a, position);
+            extend_operand(intervals, inst->b, position);
+            if (inst->dst != NO_VREG) extend(&intervals[inst->dst], position + 1);
+            if (inst->op == IR_WRITE) calls_before[position + 1] = 1;
+        }
+        extend_operand(intervals, block->term.a, position);
+        extend_operand(intervals, block->term.b, position);
+        block_end[b] = position;
+        position += 2;
+    }
+    for (uint32_t p = 1; p <= position_count; p++) calls_before[p] += calls_before[p - 1];
+
+    // Values live across block boundaries cover the whole stretch between them
+    IntervalBuilder builder = { intervals, block_start, block_end };
+    live_explore(fn, arena, extend_live, &builder);
+
+    // A call at c is crossed when start < c < end, i.e. when calls_before[end] > calls_before[start].
+    // (A call is counted one past its WRITE, so a value live into a block that starts with a WRITE
+    // has c == start + 1.)
+    for (VReg v = 1; v < fn->vreg_count; v++) {
+        Interval *interval = &intervals[v];
+        if (interval->start == NO_POSITION || interval->end <= interval->start + 1) continue;
+        interval->crosses_call = calls_before[interval->end] > calls_before[interval->start];
+    }
+    return position_count;
+}
+
+// --- Assignment ---
+
+RegAssignment *regalloc_new_assignment(const IrFunction *fn, Arena *arena) {
+    RegAssignment *assignment = arena_calloc(arena, 1, sizeof(RegAssignment));
+    assignment->reg = arena_calloc(arena, fn->vreg_count, sizeof(uint8_t));
+    assignment->slot = arena_alloc(arena, fn->vreg_count * sizeof(uint32_t));
+    for (VReg v = 0; v < fn->vreg_count; v++) assignment->slot[v] = NO_SLOT;
+    return assignment;
+}
+
+void regalloc_spill(RegAssignment *assignment, VReg vreg) {
+    assignment->reg[vreg] = REG_ZERO;
+    assignment->slot[vreg] = assignment->spill_count++;
+}
+
+// --- Linear Scan ---
+
+// Picks a free register for an interval: a temporary if the value survives no call, otherwise
+// a saved register, preferring one the prologue already has to save. REG_ZERO if none is free.
+static Reg pick_register(uint32_t free_mask, int crosses_call, uint32_t saved_mask) {
+    if (!crosses_call) {
+        for (size_t i = 0; i < TEMP_COUNT; i++) {
+            if (free_mask & REG_BIT(temp_registers[i])) return temp_registers[i];
+        }
+    }
+    for (size_t i = 0; i < SAVED_COUNT; i++) {
+        if ((free_mask & saved_mask & REG_BIT(saved_registers[i]))) return saved_registers[i];
+    }
+    for (size_t i = 0; i < SAVED_COUNT; i++) {
+        if (free_mask & REG_BIT(saved_registers[i])) return saved_registers[i];
+    }
+    return REG_ZERO;
+}
+
+// Poletto and Sarkar's linear scan: intervals are visited by increasing start, the active
+// ones are kept sorted by end, and under pressure the interval ending last is spilled whole
+// (either the new one or an active one holding a register it could use).
+RegAssignment *regalloc_linear_scan(const IrFunction *fn, Arena *arena) {
+    RegAssignment *assignment = regalloc_new_assignment(fn, arena);
+    Interval *intervals = arena_alloc(arena, fn->vreg_count * sizeof(Interval));
+    uint32_t position_count = build_intervals(fn, intervals, arena);
+
+    // Counting sort of the live vregs by start position
+    uint32_t *start_offset = arena_calloc(arena, position_count + 2, sizeof(uint32_t));
+    uint32_t live_count = 0;
+    for (VReg v = 1; v < fn->vreg_count; v++) {
+        if (intervals[v].start == NO_POSITION) continue;
+        start_offset[intervals[v].start + 1]++;
+        live_count++;
+    }
+    for (uint32_t p = 0; p < position_count; p++) start_offset[p + 1] += start_offset[p];
+    VReg *order = arena_alloc(arena, (live_count + 1) * sizeof(VReg));
+    for (VReg v = 1; v < fn->vreg_count; v++) {
+        if (intervals[v].start != NO_POSITION) order[start_offset[intervals[v].start]++] = v;
+    }
+
+    uint32_t free_mask = 0;
+    uint32_t saved_class = 0;
+    for (size_t i = 0; i < TEMP_COUNT; i++) free_mask |= REG_BIT(temp_registers[i]);
+    for (size_t i = 0; i < SAVED_COUNT; i++) saved_class |= REG_BIT(saved_registers[i]);
+    free_mask |= saved_class;
+
+    VReg active[TEMP_COUNT + SAVED_COUNT];
+    uint32_t active_count = 0;
+    for (uint32_t i = 0; i < live_count; i++) {
+        VReg v = order[i];
+        const Interval *current = &intervals[v];
+
+        // Expire the intervals that ended before this one starts
+        uint32_t expired = 0;
+        while (expired < active_count && intervals[active[expired]].end < current->start) {
+            free_mask |= REG_BIT(assignment->reg[active[expired]]);
+            expired++;
+        }
+        memmove(active, active + expired, (active_count - expired) * sizeof(VReg));
+        active_count -= expired;
+
+        Reg reg = pick_register(free_mask, current->crosses_call, assignment->saved_mask);
+        if (reg == REG_ZERO) {
+            uint32_t allowed = current->crosses_call ? saved_class : ~(uint32_t)0;
+            uint32_t victim = active_count;
+            while (victim > 0 && !(allowed & REG_BIT(assignment->reg[active[victim - 1]]))) victim--;
+            if (victim == 0 || intervals[active[victim - 1]].end <= current->end) {
+                regalloc_spill(assignment, v);
+                continue;
+            }
+            victim--;
+            reg = (Reg)assignment->reg[active[victim]];
+            regalloc_spill(assignment, active[victim]);
+            assignment->assigned--;
+            memmove(active + victim, active + victim + 1, (active_count - victim - 1) * sizeof(VReg));
+            active_count--;
+            free_mask |= REG_BIT(reg);
+        }
+
+        assignment->reg[v] = (uint8_t)reg;
+        assignment->assigned++;
+        free_mask &= ~REG_BIT(reg);
+        if (saved_class & REG_BIT(reg)) assignment->saved_mask |= REG_BIT(reg);
+        uint32_t at = active_count;
+        while (at > 0 && intervals[active[at - 1]].end > current->end) {
+            active[at] = active[at - 1];
+            at--;
+        }
+        active[at] = v;
+        active_count++;
+    }
+    return assignment;
+}
+
+// --- Printing ---
+
+void regalloc_dump(const RegAssignment *assignment, const IrFunction *fn, const char *name, FILE *file) {
+    fprintf(file, "=== Register allocation (%s): %u vregs in registers, %u spilled, saves", name,
+            (unsigned)assignment->assigned, (unsigned)assignment->spill_count);
+    for (int reg = 0; reg < REG_COUNT; reg++) {
+        if (assignment->saved_mask & REG_BIT(reg)) fprintf(file, " %s", reg_name((Reg)reg));
+    }
+    fprintf(file, " ===\n");
+    for (VReg v = 1; v < fn->vreg_count; v++) {
+        if (assignment->reg[v] != REG_ZERO) {
+            fprintf(file, "v%u: %s\n", (unsigned)v, reg_name((Reg)assignment->reg[v]));
+        } else if (assignment->slot[v] != NO_SLOT) {
+            fprintf(file, "v%u: spill %u\n", (unsigned)v, (unsigned)assignment->slot[v]);
+        }
+    }
+    fprintf(file, "\n");
+}
@@ -0,0 +1,37 @@
+#ifndef REGALLOC_H_
+#define REGALLOC_H_
+
+#include <stdio.h>
+#include "ir.h"
+#include "emit.h"
+#include "arena.h"
+
+// Where each vreg lives after register allocation. Runs on the IR after out-of-SSA.
+// t0-t2 stay reserved as the printer's scratch registers and a0/a1/a7 for calls, so the
+// allocatable registers are t3-t6 (caller-saved, clobbered by the printf call of WRITE)
+// and s1-s11 (callee-saved, saved in the prologue only when used).
+typedef struct {
+    uint8_t *reg;         // vreg -> Reg, REG_ZERO when the vreg lives in a spill slot
+    uint32_t *slot;       // vreg -> spill slot index, valid when reg is REG_ZERO
+    uint32_t spill_count; // Number of spill slots
+    uint32_t saved_mask;  // Callee-saved registers written by the code (bit per Reg)
+    uint32_t assigned;    // Vregs given a register
+} RegAssignment;
+
+// Allocators. Linear scan is the fast default; iterated register coalescing (irc.c) builds an
+// interference graph and removes most copies, at a higher compile-time cost.
+typedef enum {
+    REGALLOC_DEFAULT, // Linear scan at -O1, graph coloring from -O2
+    REGALLOC_LINEAR,
+    REGALLOC_IRC,
+} RegAllocKind;
+
+RegAssignment *regalloc_linear_scan(const IrFunction *fn, Arena *arena);
+RegAssignment *regalloc_irc(const IrFunction *fn, Arena *arena);
+
+// Shared by the allocators: an assignment with every vreg unallocated, and spilling to a new slot
+RegAssignment *regalloc_new_assignment(const IrFunction *fn, Arena *arena);
+void regalloc_spill(RegAssignment *assignment, VReg vreg);
+void regalloc_dump(const RegAssignment *assignment, const IrFunction *fn, const char *name, FILE *file);
+
+#endif
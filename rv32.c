@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rv32.h"
+
+// RV32 printer for the IR. Vregs live where the register allocator put them: operands in
+// registers are used in place, spilled ones are loaded into scratch registers, and results
+// are computed straight into their register (or a scratch register and stored back).
+
+#define FRAME_POINTER REG_S0
+#define WORD_SIZE 4
+#define SCRATCH_A REG_T0       // First operand and results
+#define SCRATCH_B REG_T1       // Second operand
+#define SCRATCH_ADDRESS REG_T2 // Frame addresses beyond the 12-bit offset range, strength-reduced sequences
+
+// --- Printer State ---
+static const IrFunction *fn = NULL;
+static const RegAssignment *assignment = NULL;
+static const Target *target = NULL;
+static uint32_t saved_count = 0; // Callee-saved registers stored right below the frame pointer
+static uint32_t slot_count = 0;  // Variable slots, only reserved while LOAD/STORE remain
+
+static int fits_imm12(long value) {
+    return value >= -2048 && value <= 2047;
+}
+
+// Frame below the frame pointer: saved registers, then variable slots, then spill slots
+static long saved_offset(uint32_t index) {
+    return -(long)WORD_SIZE * ((long)index + 1);
+}
+
+static long var_offset(uint32_t var) {
+    return -(long)WORD_SIZE * ((long)saved_count + (long)var + 1);
+}
+
+static long spill_offset(VReg vreg) {
+    return -(long)WORD_SIZE * ((long)saved_count + (long)slot_count + (long)assignment->slot[vreg] + 1);
+}
+
+// lw/sw relative to the frame pointer, going through a scratch address for large frames
+static void emit_frame_access(Emitter *out, Mnemonic op, Reg reg, long offset) {
+    if (fits_imm12(offset)) {
+        emit_mem(out, op, reg, offset, FRAME_POINTER);
+        return;
+    }
+    emit_ri(out, MN_LI, SCRATCH_ADDRESS, offset);
+    emit_rrr(out, MN_ADD, SCRATCH_ADDRESS, SCRATCH_ADDRESS, FRAME_POINTER);
+    emit_mem(out, op, reg, 0, SCRATCH_ADDRESS);
+}
+
+// Returns a register holding the operand, materializing it in scratch when needed
+static Reg use_operand(Emitter *out, Operand operand, Reg scratch) {
+    if (operand.kind == OPND_IMM) {
+        if (operand.value == 0) return REG_ZERO;
+        emit_ri(out, MN_LI, scratch, operand.value);
+        return scratch;
+    }
+    Reg reg = (Reg)assignment->reg[operand.value];
+    if (reg != REG_ZERO) return reg;
+    emit_frame_access(out, MN_LW, scratch, spill_offset((VReg)operand.value));
+    return scratch;
+}
+
+// Register a result for dst should be computed into: its own, or scratch if it is spilled
+static Reg result_register(VReg dst, Reg scratch) {
+    Reg reg = (Reg)assignment->reg[dst];
+    return reg != REG_ZERO ? reg : scratch;
+}
+
+// Finishes defining dst from the value computed in reg
+static void define(Emitter *out, VReg dst, Reg reg) {
+    Reg home = (Reg)assignment->reg[dst];
+    if (home == REG_ZERO) {
+        emit_frame_access(out, MN_SW, reg, spill_offset(dst));
+    } else if (home != reg) {
+        emit_rr(out, MN_MV, home, reg);
+    }
+}
+
+// --- Instructions ---
+
+// True if op has an I-type form for the immediate right operand imm on core, or (for
+// MUL/DIV/REM) a shift sequence the core prefers; otherwise imm has to be loaded with li
+int rv32_fits_immediate(IrOp op, int32_t imm, const Target *core) {
+    switch (op) {
+        case IR_MUL: return target_emit_multiply_imm(NULL, core, REG_ZERO, REG_ZERO, imm, REG_ZERO, REG_ZERO);
+        case IR_DIV: return target_emit_divide_imm(NULL, core, REG_ZERO, REG_ZERO, imm, REG_ZERO, REG_ZERO);
+        case IR_REM: return target_emit_remainder_imm(NULL, core, REG_ZERO, REG_ZERO, imm, REG_ZERO, REG_ZERO);
+        case IR_ADD: return fits_imm12(imm);
+        case IR_SUB: return fits_imm12(-(long)imm);
+        case IR_SLT: return fits_imm12(imm);
+        case IR_SLE: return fits_imm12((long)imm + 1);
+        case IR_SGE: return fits_imm12(imm);
+        default: return 0;
+    }
+}
+
+// Emits the I-type form of op with an immediate right operand, or a shift sequence for
+// MUL/DIV/REM. Returns 0 if there is none.
+static int emit_binary_immediate(Emitter *out, IrOp op, Reg rd, Reg ra, long imm) {
+    if (!rv32_fits_immediate(op, (int32_t)imm, target)) return 0;
+    switch (op) {
+        case IR_MUL: return target_emit_multiply_imm(out, target, rd, ra, (int32_t)imm, SCRATCH_B, SCRATCH_ADDRESS);
+        case IR_DIV: return target_emit_divide_imm(out, target, rd, ra, (int32_t)imm, SCRATCH_B, SCRATCH_ADDRESS);
+        case IR_REM: return target_emit_remainder_imm(out, target, rd, ra, (int32_t)imm, SCRATCH_B, SCRATCH_ADDRESS);
+        case IR_ADD:
+            emit_rri(out, MN_ADDI, rd, ra, imm);
+            return 1;
+        case IR_SUB:
+            emit_rri(out, MN_ADDI, rd, ra, -imm);
+            return 1;
+        case IR_SLT:
+            emit_rri(out, MN_SLTI, rd, ra, imm);
+            return 1;
+        case IR_SLE: // a <= imm  <=>  a < imm + 1
+            emit_rri(out, MN_SLTI, rd, ra, imm + 1);
+            return 1;
+        case IR_SGE: // !(a < imm)
+            emit_rri(out, MN_SLTI, rd, ra, imm);
+            emit_rri(out, MN_XORI, rd, rd, 1);
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void emit_binary(Emitter *out, IrOp op, Reg rd, Reg ra, Reg rb) {
+    switch (op) {
+        case IR_ADD: emit_rrr(out, MN_ADD, rd, ra, rb); break;
+        case IR_SUB: emit_rrr(out, MN_SUB, rd, ra, rb); break;
+        case IR_MUL:
+            target_require_mul(target, "Multiplication");
+            emit_rrr(out, MN_MUL, rd, ra, rb);
+            break;
+        case IR_DIV:
+            target_require_mul(target, "Division");
+            emit_rrr(out, MN_DIV, rd, ra, rb);
+            break;
+        case IR_REM:
+            target_require_mul(target, "Remainder");
+            emit_rrr(out, MN_REM, rd, ra, rb);
+            break;
+        case IR_SLT: emit_rrr(out, MN_SLT, rd, ra, rb); break;
+        case IR_SGT: emit_rrr(out, MN_SGT, rd, ra, rb); break;
+        case IR_SEQ:
+            emit_rrr(out, MN_SUB, rd, ra, rb);
+            emit_rr(out, MN_SEQZ, rd, rd);
+            break;
+        case IR_SNE:
+            emit_rrr(out, MN_SUB, rd, ra, rb);
+            emit_rr(out, MN_SNEZ, rd, rd);
+            break;
+        case IR_SLE: // !(a > b)
+            emit_rrr(out, MN_SGT, rd, ra, rb);
+            emit_rri(out, MN_XORI, rd, rd, 1);
+            break;
+        case IR_SGE: // !(a < b)
+            emit_rrr(out, MN_SLT, rd, ra, rb);
+            emit_rri(out, MN_XORI, rd, rd, 1);
+            break;
+        default:
+            fprintf(stderr, "CodeGen Error: Unsupported IR operation '%s'\n", ir_op_name(op));
+            exit(EXIT_FAILURE);
+    }
+}
+
+static void emit_inst(Emitter *out, const IrInst *inst) {
+    IrOp op = (IrOp)inst->op;
+    switch (op) {
+        case IR_NOP:
+            break;
+
+        case IR_COPY: {
+            // Constants and spilled values are loaded straight into the destination register
+            Reg rd = result_register(inst->dst, SCRATCH_A);
+            define(out, inst->dst, use_operand(out, inst->a, rd));
+            break;
+        }
+
+        case IR_LOAD: {
+            Reg rd = result_register(inst->dst, SCRATCH_A);
+            emit_frame_access(out, MN_LW, rd, var_offset(inst->var));
+            define(out, inst->dst, rd);
+            break;
+        }
+
+        case IR_STORE:
+            emit_frame_access(out, MN_SW, use_operand(out, inst->a, SCRATCH_A), var_offset(inst->var));
+            break;
+
+        case IR_WRITE: {
+            emit_comment(out, "WRITE using printf");
+            Reg value = use_operand(out, inst->a, REG_A1);
+            if (value != REG_A1) emit_rr(out, MN_MV, REG_A1, value);
+            emit_la(out, REG_A0, "fmt");
+            emit_symbol(out, MN_CALL, "printf");
+            break;
+        }
+
+        case IR_PHI:
+            fprintf(stderr, "CodeGen Error: phi reached the RV32 printer (missing out-of-SSA pass)\n");
+            exit(EXIT_FAILURE);
+
+        default: {
+            Reg rd = result_register(inst->dst, SCRATCH_A);
+            Reg ra = use_operand(out, inst->a, SCRATCH_A);
+            if (inst->b.kind == OPND_IMM && emit_binary_immediate(out, op, rd, ra, inst->b.value)) {
+                define(out, inst->dst, rd);
+                break;
+            }
+            Reg rb = use_operand(out, inst->b, SCRATCH_B);
+            emit_binary(out, op, rd, ra, rb);
+            define(out, inst->dst, rd);
+            break;
+        }
+    }
+}
+
+// --- Terminators ---
+
+static Mnemonic branch_mnemonic(IrOp cmp) {
+    switch (cmp) {
+        case IR_SEQ: return MN_BEQ;
+        case IR_SNE: return MN_BNE;
+        case IR_SLT: return MN_BLT;
+        case IR_SLE: return MN_BLE;
+        case IR_SGT: return MN_BGT;
+        default: return MN_BGE;
+    }
+}
+
+// Callee-saved registers the allocated code writes, in saved_offset order
+static void save_registers(Emitter *out, Mnemonic op) {
+    uint32_t index = 0;
+    for (int reg = 0; reg < REG_COUNT; reg++) {
+        if (assignment->saved_mask & ((uint32_t)1 << reg)) emit_frame_access(out, op, (Reg)reg, saved_offset(index++));
+    }
+}
+
+static void emit_epilogue(Emitter *out) {
+    emit_comment(out, "Function Epilogue (RV32)");
+    save_registers(out, MN_LW);
+    emit_rr(out, MN_MV, REG_SP, FRAME_POINTER); // Deallocate locals
+    emit_mem(out, MN_LW, FRAME_POINTER, 0, REG_SP);
+    emit_rri(out, MN_ADDI, REG_SP, REG_SP, WORD_SIZE);
+    emit_mem(out, MN_LW, REG_RA, 0, REG_SP);
+    emit_rri(out, MN_ADDI, REG_SP, REG_SP, WORD_SIZE);
+    emit_bare(out, MN_RET);
+}
+
+// next_block is the block laid out right after this one: jumps to it become fallthroughs
+static void emit_term(Emitter *out, const IrTerm *term, uint32_t next_block) {
+    switch (term->kind) {
+        case TERM_JUMP:
+            if (term->target[0] != next_block) emit_jump(out, (int)term->target[0]);
+            break;
+
+        case TERM_BRANCH: {
+            Reg ra = use_operand(out, term->a, SCRATCH_A);
+            Reg rb = use_operand(out, term->b, SCRATCH_B);
+            if (term->target[0] == next_block) {
+                // Branch away on the inverted condition and fall into the true block
+                emit_branch(out, branch_mnemonic(ir_invert_compare((IrOp)term->cmp)), ra, rb, (int)term->target[1]);
+                break;
+            }
+            emit_branch(out, branch_mnemonic((IrOp)term->cmp), ra, rb, (int)term->target[0]);
+            if (term->target[1] != next_block) emit_jump(out, (int)term->target[1]);
+            break;
+        }
+
+        case TERM_EXIT: {
+            Reg code = use_operand(out, term->a, REG_A0);
+            if (code != REG_A0) emit_rr(out, MN_MV, REG_A0, code);
+            emit_ri(out, MN_LI, REG_A7, 93);
+            emit_bare(out, MN_ECALL);
+            break;
+        }
+
+        case TERM_RETURN:
+            emit_epilogue(out);
+            break;
+
+        default:
+            fprintf(stderr, "CodeGen Error: Block without terminator\n");
+            exit(EXIT_FAILURE);
+    }
+}
+
+// --- Entry Point ---
+
+// True if some LOAD/STORE still addresses a variable slot (none do after mem2reg)
+static int uses_variable_slots(void) {
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        for (uint32_t i = 0; i < fn->blocks[b].count; i++) {
+            if (fn->blocks[b].insts[i].op == IR_LOAD || fn->blocks[b].insts[i].op == IR_STORE) return 1;
+        }
+    }
+    return 0;
+}
+
+// Prints the function as a complete RV32 assembly program (main plus the printf format)
+void rv32_emit_function(const IrFunction *ir, const RegAssignment *registers, const Target *core, Emitter *out) {
+    fn = ir;
+    assignment = registers;
+    target = core;
+    saved_count = 0;
+    for (int reg = 0; reg < REG_COUNT; reg++) {
+        if (assignment->saved_mask & ((uint32_t)1 << reg)) saved_count++;
+    }
+    slot_count = uses_variable_slots() ? fn->var_count : 0;
+
+    // Frame: saved registers, variable slots and spill slots, rounded to 16 bytes
+    long frame_size = (long)WORD_SIZE * ((long)saved_count + (long)slot_count + (long)assignment->spill_count);
+    frame_size = (frame_size + 15) & ~15L;
+
+    // --- Data Segment ---
+    emit_cstr(out, ".data\n");
+    emit_cstr(out, "fmt: .asciz \"%d\\n\" # Format string for printing integers\n");
+
+    // --- Text Segment ---
+    emit_cstr(out, "\n.text\n");
+    emit_cstr(out, ".extern printf # Declare printf if used\n");
+    emit_cstr(out, ".globl main\n");
+
+    // --- Main Function Prologue (RV32) ---
+    emit_cstr(out, "\nmain:\n");
+    emit_comment(out, "Function Prologue (RV32)");
+    emit_rri(out, MN_ADDI, REG_SP, REG_SP, -WORD_SIZE);
+    emit_mem(out, MN_SW, REG_RA, 0, REG_SP);
+    emit_rri(out, MN_ADDI, REG_SP, REG_SP, -WORD_SIZE);
+    emit_mem(out, MN_SW, FRAME_POINTER, 0, REG_SP);
+    emit_rr(out, MN_MV, FRAME_POINTER, REG_SP);
+    if (fits_imm12(-frame_size)) {
+        emit_rri(out, MN_ADDI, REG_SP, REG_SP, -frame_size);
+    } else {
+        emit_ri(out, MN_LI, SCRATCH_ADDRESS, frame_size);
+        emit_rrr(out, MN_SUB, REG_SP, REG_SP, SCRATCH_ADDRESS);
+    }
+    save_registers(out, MN_SW);
+
+    // --- Blocks in layout order ---
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        emit_label(out, (int)b);
+        for (uint32_t i = 0; i < block->count; i++) {
+            emit_inst(out, &block->insts[i]);
+        }
+        emit_term(out, &block->term, b + 1 < fn->block_count ? b + 1 : NO_BLOCK);
+    }
+    emit_cstr(out, "\n");
+
+    fn = NULL;
+    assignment = NULL;
+}
@@ -0,0 +1,12 @@
+#ifndef RV32_H_
+#define RV32_H_
+
+#include "ir.h"
+#include "emit.h"
+#include "regalloc.h"
+#include "target.h"
+
+int rv32_fits_immediate(IrOp op, int32_t imm, const Target *core);
+void rv32_emit_function(const IrFunction *fn, const RegAssignment *registers, const Target *target, Emitter *out);
+
+#endif
@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stddef.h>
+
+#include "scan.h"
+
+// Vector kernels are chosen at compile time: AVX2 (32 bytes), SSE2 (16 bytes) or the
+// scalar table walk. Define SCAN_SCALAR to force the scalar path (e.g. for benchmarking).
+#if !defined(SCAN_SCALAR) && defined(__AVX2__)
+#define SCAN_AVX2
+#include <immintrin.h>
+#elif !defined(SCAN_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SCAN_CTZ(x) ((size_t)__builtin_ctz(x))
+#else
+static size_t SCAN_CTZ(unsigned x)
+{
+  size_t n = 0;
+  while (!(x & 1u))
+  {
+    x >>= 1;
+    n++;
+  }
+  return n;
+}
+#endif
+
+// Newline bits are sparse (rarely more than one per block), so clearing the lowest set bit
+// beats a popcount, which is a library call on targets built without POPCNT
+static size_t count_bits(unsigned x)
+{
+  size_t n = 0;
+  for (; x; x &= x - 1)
+  {
+    n++;
+  }
+  return n;
+}
+
+// --- Character Class Table ---
+// Same sets as isspace/isdigit/isalpha in the "C" locale, without the locale lookups.
+
+#define SPACE CHAR_SPACE
+#define NL (CHAR_SPACE | CHAR_NEWLINE)
+#define DIG CHAR_DIGIT
+#define ALP CHAR_ALPHA
+#define PUN CHAR_PUNCT
+
+const unsigned char char_class[256] = {
+    ['\t'] = SPACE, ['\n'] = NL, ['\v'] = SPACE, ['\f'] = SPACE, ['\r'] = SPACE, [' '] = SPACE,
+    ['0'] = DIG, ['1'] = DIG, ['2'] = DIG, ['3'] = DIG, ['4'] = DIG,
+    ['5'] = DIG, ['6'] = DIG, ['7'] = DIG, ['8'] = DIG, ['9'] = DIG,
+    ['a'] = ALP, ['b'] = ALP, ['c'] = ALP, ['d'] = ALP, ['e'] = ALP, ['f'] = ALP, ['g'] = ALP,
+    ['h'] = ALP, ['i'] = ALP, ['j'] = ALP, ['k'] = ALP, ['l'] = ALP, ['m'] = ALP, ['n'] = ALP,
+    ['o'] = ALP, ['p'] = ALP, ['q'] = ALP, ['r'] = ALP, ['s'] = ALP, ['t'] = ALP, ['u'] = ALP,
+    ['v'] = ALP, ['w'] = ALP, ['x'] = ALP, ['y'] = ALP, ['z'] = ALP,
+    ['A'] = ALP, ['B'] = ALP, ['C'] = ALP, ['D'] = ALP, ['E'] = ALP, ['F'] = ALP, ['G'] = ALP,
+    ['H'] = ALP, ['I'] = ALP, ['J'] = ALP, ['K'] = ALP, ['L'] = ALP, ['M'] = ALP, ['N'] = ALP,
+    ['O'] = ALP, ['P'] = ALP, ['Q'] = ALP, ['R'] = ALP, ['S'] = ALP, ['T'] = ALP, ['U'] = ALP,
+    ['V'] = ALP, ['W'] = ALP, ['X'] = ALP, ['Y'] = ALP, ['Z'] = ALP,
+    [';'] = PUN, [','] = PUN, ['('] = PUN, [')'] = PUN, ['{'] = PUN, ['}'] = PUN,
+    ['='] = PUN, ['+'] = PUN, ['-'] = PUN, ['*'] = PUN, ['/'] = PUN, ['%'] = PUN,
+    ['<'] = PUN, ['>'] = PUN, ['!'] = PUN, ['"'] = PUN,
+};
+
+#undef SPACE
+#undef NL
+#undef DIG
+#undef ALP
+#undef PUN
+
+const char *scan_kernel_name(void)
+{
+#if defined(SCAN_AVX2)
+  return "avx2";
+#elif defined(SCAN_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+// --- Vector Masks ---
+// Each helper returns one bit per byte of the block that belongs to the class.
+// Unsigned range checks use the min trick: x <= n  <=>  min(x, n) == x.
+
+#if defined(SCAN_AVX2)
+#define SCAN_WIDTH 32
+typedef __m256i ScanBlock;
+
+static ScanBlock scan_load(const char *p)
+{
+  return _mm256_loadu_si256((const __m256i *)p);
+}
+
+static unsigned scan_in_range(ScanBlock x, char low, unsigned char span)
+{
+  __m256i shifted = _mm256_sub_epi8(x, _mm256_set1_epi8(low));
+  __m256i inside = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8((char)span)), shifted);
+  return (unsigned)_mm256_movemask_epi8(inside);
+}
+
+static unsigned scan_equal(ScanBlock x, char c)
+{
+  return (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(c)));
+}
+
+static ScanBlock scan_lowercase(ScanBlock x)
+{
+  return _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+}
+#elif defined(SCAN_SSE2)
+#define SCAN_WIDTH 16
+typedef __m128i ScanBlock;
+
+static ScanBlock scan_load(const char *p)
+{
+  return _mm_loadu_si128((const __m128i *)p);
+}
+
+static unsigned scan_in_range(ScanBlock x, char low, unsigned char span)
+{
+  __m128i shifted = _mm_sub_epi8(x, _mm_set1_epi8(low));
+  __m128i inside = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8((char)span)), shifted);
+  return (unsigned)_mm_movemask_epi8(inside);
+}
+
+static unsigned scan_equal(ScanBlock x, char c)
+{
+  return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8(c)));
+}
+
+static ScanBlock scan_lowercase(ScanBlock x)
+{
+  return _mm_or_si128(x, _mm_set1_epi8(0x20));
+}
+#endif
+
+#if defined(SCAN_WIDTH)
+#define SCAN_FULL_MASK (SCAN_WIDTH == 32 ? 0xFFFFFFFFu : 0xFFFFu)
+#endif
+
+// --- Scanners ---
+// Each returns the index of the first byte at or after index that is not in the class.
+// Vector blocks are only loaded while a whole block fits before length, so a mapped
+// source is never read past its end.
+
+// Skips a whitespace run, adding the newlines it contains to *newlines
+size_t scan_whitespace(const char *text, size_t index, size_t length, size_t *newlines)
+{
+#if defined(SCAN_WIDTH)
+  while (index + SCAN_WIDTH <= length)
+  {
+    ScanBlock block = scan_load(text + index);
+    unsigned space = scan_equal(block, ' ') | scan_in_range(block, '\t', '\r' - '\t');
+    unsigned lines = scan_equal(block, '\n');
+    unsigned stop = ~space & SCAN_FULL_MASK;
+    if (stop != 0)
+    {
+      size_t run = SCAN_CTZ(stop);
+      *newlines += count_bits(lines & ((1u << run) - 1u));
+      return index + run;
+    }
+    *newlines += count_bits(lines);
+    index += SCAN_WIDTH;
+  }
+#endif
+  while (index < length && (char_class[(unsigned char)text[index]] & CHAR_SPACE))
+  {
+    *newlines += text[index] == '\n';
+    index++;
+  }
+  return index;
+}
+
+size_t scan_alpha(const char *text, size_t index, size_t length)
+{
+#if defined(SCAN_WIDTH)
+  while (index + SCAN_WIDTH <= length)
+  {
+    unsigned stop = ~scan_in_range(scan_lowercase(scan_load(text + index)), 'a', 'z' - 'a') & SCAN_FULL_MASK;
+    if (stop != 0)
+    {
+      return index + SCAN_CTZ(stop);
+    }
+    index += SCAN_WIDTH;
+  }
+#endif
+  while (index < length && (char_class[(unsigned char)text[index]] & CHAR_ALPHA))
+  {
+    index++;
+  }
+  return index;
+}
+
+size_t scan_digits(const char *text, size_t index, size_t length)
+{
+#if defined(SCAN_WIDTH)
+  while (index + SCAN_WIDTH <= length)
+  {
+    unsigned stop = ~scan_in_range(scan_load(text + index), '0', 9) & SCAN_FULL_MASK;
+    if (stop != 0)
+    {
+      return index + SCAN_CTZ(stop);
+    }
+    index += SCAN_WIDTH;
+  }
+#endif
+  while (index < length && (char_class[(unsigned char)text[index]] & CHAR_DIGIT))
+  {
+    index++;
+  }
+  return index;
+}
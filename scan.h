@@ -0,0 +1,20 @@
+#ifndef SCAN_H_
+#define SCAN_H_
+
+#include <stddef.h>
+
+// Character classes (bit flags) for the lexer's dispatch table
+#define CHAR_SPACE 0x01
+#define CHAR_NEWLINE 0x02
+#define CHAR_DIGIT 0x04
+#define CHAR_ALPHA 0x08
+#define CHAR_PUNCT 0x10 // Separators, operators, comparators and quotes
+
+extern const unsigned char char_class[256];
+
+const char *scan_kernel_name(void);
+size_t scan_whitespace(const char *text, size_t index, size_t length, size_t *newlines);
+size_t scan_alpha(const char *text, size_t index, size_t length);
+size_t scan_digits(const char *text, size_t index, size_t length);
+
+#endif
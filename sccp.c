@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sccp.h"
+
+#define TERM_USE ((uint32_t)UINT32_MAX) // Use index of a block's terminator
+
+// --- Lattice ---
+
+// Values only move down: undefined (no definition has executed yet) -> constant -> varying
+typedef enum {
+    VALUE_UNDEFINED,
+    VALUE_CONSTANT,
+    VALUE_VARYING,
+} ValueState;
+
+typedef struct {
+    uint8_t state; // ValueState
+    int32_t constant;
+} LatticeValue;
+
+static LatticeValue undefined_value(void) {
+    LatticeValue value = { VALUE_UNDEFINED, 0 };
+    return value;
+}
+
+static LatticeValue constant_value(int32_t constant) {
+    LatticeValue value = { VALUE_CONSTANT, constant };
+    return value;
+}
+
+static LatticeValue varying_value(void) {
+    LatticeValue value = { VALUE_VARYING, 0 };
+    return value;
+}
+
+static LatticeValue meet(LatticeValue a, LatticeValue b) {
+    if (a.state == VALUE_UNDEFINED) return b;
+    if (b.state == VALUE_UNDEFINED) return a;
+    if (a.state == VALUE_CONSTANT && b.state == VALUE_CONSTANT && a.constant == b.constant) return a;
+    return varying_value();
+}
+
+// --- Solver State ---
+static IrFunction *fn = NULL;
+static LatticeValue *values = NULL;  // vreg -> lattice value
+static uint8_t *executable = NULL;   // block * 2 + successor slot -> edge has executed
+static uint8_t *visited = NULL;      // block -> has executed
+static uint32_t *use_start = NULL;   // Uses of v: use_block/use_index[use_start[v] .. use_start[v + 1])
+static uint32_t *use_block = NULL;
+static uint32_t *use_index = NULL;   // Instruction index, or TERM_USE
+static uint32_t *block_work = NULL;  // Blocks reached for the first time, each queued once
+static uint32_t block_count = 0;
+static VReg *value_work = NULL;      // Vregs whose value moved down, each queued at most twice
+static uint32_t value_count = 0;
+
+static LatticeValue operand_value(Operand operand) {
+    if (operand.kind == OPND_IMM) return constant_value(operand.value);
+    if (operand.kind == OPND_REG) return values[operand.value];
+    return undefined_value();
+}
+
+static void lower_value(VReg dst, LatticeValue value) {
+    if (value.state <= values[dst].state) return;
+    values[dst] = value;
+    value_work[value_count++] = dst;
+}
+
+// True once the edge pred -> b has executed
+static int edge_executable(uint32_t pred, uint32_t b) {
+    const IrTerm *term = &fn->blocks[pred].term;
+    return (executable[pred * 2] && term->target[0] == b) || (executable[pred * 2 + 1] && term->target[1] == b);
+}
+
+// --- Uses ---
+
+#define COUNT_USE(operand)                                                                 \
+    do {                                                                                   \
+        if ((operand).kind == OPND_REG) use_start[(operand).value + 1]++;                  \
+    } while (0)
+
+#define ADD_USE(operand, b, i)                                                             \
+    do {                                                                                   \
+        if ((operand).kind == OPND_REG) {                                                  \
+            uint32_t slot = fill[(operand).value]++;                                       \
+            use_block[slot] = (b);                                                         \
+            use_index[slot] = (i);                                                         \
+        }                                                                                  \
+    } while (0)
+
+// Lists where each vreg is read: instruction operands, phi arguments and terminators
+static void build_uses(Arena *arena) {
+    use_start = arena_calloc(arena, fn->vreg_count + 1, sizeof(uint32_t));
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        for (uint32_t i = 0; i < block->count; i++) {
+            const IrInst *inst = &block->insts[i];
+            if (inst->op == IR_PHI) {
+                for (uint32_t k = 0; k < inst->arg_count; k++) COUNT_USE(inst->args[k]);
+                continue;
+            }
+            COUNT_USE(inst->a);
+            COUNT_USE(inst->b);
+        }
+        COUNT_USE(block->term.a);
+        COUNT_USE(block->term.b);
+    }
+    for (uint32_t v = 0; v < fn->vreg_count; v++) use_start[v + 1] += use_start[v];
+    uint32_t total = use_start[fn->vreg_count];
+    use_block = arena_alloc(arena, (total + 1) * sizeof(uint32_t));
+    use_index = arena_alloc(arena, (total + 1) * sizeof(uint32_t));
+    uint32_t *fill = arena_alloc(arena, (fn->vreg_count + 1) * sizeof(uint32_t));
+    memcpy(fill, use_start, fn->vreg_count * sizeof(uint32_t));
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        for (uint32_t i = 0; i < block->count; i++) {
+            const IrInst *inst = &block->insts[i];
+            if (inst->op == IR_PHI) {
+                for (uint32_t k = 0; k < inst->arg_count; k++) ADD_USE(inst->args[k], b, i);
+                continue;
+            }
+            ADD_USE(inst->a, b, i);
+            ADD_USE(inst->b, b, i);
+        }
+        ADD_USE(block->term.a, b, TERM_USE);
+        ADD_USE(block->term.b, b, TERM_USE);
+    }
+}
+
+#undef COUNT_USE
+#undef ADD_USE
+
+// --- Propagation ---
+
+// A phi meets the arguments of the edges that have executed; the others may never run
+static void visit_phi(uint32_t b, const IrInst *phi) {
+    const IrBlock *block = &fn->blocks[b];
+    LatticeValue value = undefined_value();
+    for (uint32_t k = 0; k < phi->arg_count; k++) {
+        if (edge_executable(block->preds[k], b)) value = meet(value, operand_value(phi->args[k]));
+    }
+    lower_value(phi->dst, value);
+}
+
+static void visit_inst(uint32_t b, uint32_t i) {
+    const IrInst *inst = &fn->blocks[b].insts[i];
+    switch (inst->op) {
+        case IR_PHI:
+            visit_phi(b, inst);
+            break;
+        case IR_COPY:
+            lower_value(inst->dst, operand_value(inst->a));
+            break;
+        case IR_LOAD:
+            lower_value(inst->dst, varying_value());
+            break;
+        default: {
+            if (!ir_is_binary((IrOp)inst->op)) break;
+            LatticeValue a = operand_value(inst->a);
+            LatticeValue b_value = operand_value(inst->b);
+            if (a.state == VALUE_VARYING || b_value.state == VALUE_VARYING) {
+                lower_value(inst->dst, varying_value());
+            } else if (a.state == VALUE_CONSTANT && b_value.state == VALUE_CONSTANT) {
+                lower_value(inst->dst, constant_value(ir_evaluate((IrOp)inst->op, a.constant, b_value.constant)));
+            }
+            break;
+        }
+    }
+}
+
+static void mark_edge(uint32_t b, int slot) {
+    if (executable[b * 2 + slot]) return;
+    executable[b * 2 + slot] = 1;
+    uint32_t succ = fn->blocks[b].term.target[slot];
+    if (!visited[succ]) {
+        visited[succ] = 1;
+        block_work[block_count++] = succ;
+        return;
+    }
+    // Already executed: only its phis see the new edge
+    const IrBlock *block = &fn->blocks[succ];
+    for (uint32_t i = 0; i < block->count && block->insts[i].op == IR_PHI; i++) visit_phi(succ, &block->insts[i]);
+}
+
+// A branch follows the edges its condition allows: one if it is constant, both once it varies
+static void visit_term(uint32_t b) {
+    const IrTerm *term = &fn->blocks[b].term;
+    if (term->kind == TERM_JUMP) {
+        mark_edge(b, 0);
+        return;
+    }
+    if (term->kind != TERM_BRANCH) return;
+    LatticeValue a = operand_value(term->a);
+    LatticeValue b_value = operand_value(term->b);
+    if (a.state == VALUE_CONSTANT && b_value.state == VALUE_CONSTANT) {
+        mark_edge(b, ir_evaluate((IrOp)term->cmp, a.constant, b_value.constant) ? 0 : 1);
+    } else if (a.state == VALUE_VARYING || b_value.state == VALUE_VARYING) {
+        mark_edge(b, 0);
+        mark_edge(b, 1);
+    }
+}
+
+static void propagate(void) {
+    visited[0] = 1;
+    block_work[block_count++] = 0;
+    while (block_count > 0 || value_count > 0) {
+        if (block_count > 0) {
+            uint32_t b = block_work[--block_count];
+            for (uint32_t i = 0; i < fn->blocks[b].count; i++) visit_inst(b, i);
+            visit_term(b);
+            continue;
+        }
+        VReg v = value_work[--value_count];
+        for (uint32_t u = use_start[v]; u < use_start[v + 1]; u++) {
+            uint32_t b = use_block[u];
+            if (!visited[b]) continue;
+            if (use_index[u] == TERM_USE) {
+                visit_term(b);
+            } else {
+                visit_inst(b, use_index[u]);
+            }
+        }
+    }
+}
+
+// --- Rewriting ---
+
+static void substitute(Operand *operand) {
+    if (operand->kind == OPND_REG && values[operand->value].state == VALUE_CONSTANT) {
+        *operand = ir_imm(values[operand->value].constant);
+    }
+}
+
+// Puts an immediate left operand on the right, where the I-type forms can take it
+static void canonicalize(IrInst *inst) {
+    if (inst->a.kind != OPND_IMM || inst->b.kind != OPND_REG) return;
+    IrOp op = (IrOp)inst->op;
+    if (op != IR_ADD && op != IR_MUL && !ir_is_compare(op)) return;
+    Operand left = inst->a;
+    inst->a = inst->b;
+    inst->b = left;
+    inst->op = (uint8_t)ir_swap_compare(op);
+}
+
+// Deletes the definitions of constant vregs, turns their uses into immediates and drops the
+// predecessors and phi arguments of edges that never execute
+static void rewrite_block(uint32_t b) {
+    IrBlock *block = &fn->blocks[b];
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < block->count; i++) {
+        IrInst *inst = &block->insts[i];
+        if (inst->op == IR_NOP) continue;
+        if (inst->dst != NO_VREG && values[inst->dst].state == VALUE_CONSTANT) continue;
+        if (inst->op == IR_PHI) {
+            uint32_t args = 0;
+            for (uint32_t k = 0; k < inst->arg_count; k++) {
+                if (!edge_executable(block->preds[k], b)) continue;
+                inst->args[args] = inst->args[k];
+                substitute(&inst->args[args++]);
+            }
+            inst->arg_count = args;
+        } else {
+            substitute(&inst->a);
+            substitute(&inst->b);
+            canonicalize(inst);
+        }
+        block->insts[kept++] = *inst;
+    }
+    block->count = kept;
+
+    uint32_t preds = 0;
+    for (uint32_t k = 0; k < block->pred_count; k++) {
+        if (edge_executable(block->preds[k], b)) block->preds[preds++] = block->preds[k];
+    }
+    block->pred_count = preds;
+    substitute(&block->term.a);
+    substitute(&block->term.b);
+}
+
+// Turns a branch that only ever went one way into a jump. Runs after every block is rewritten,
+// since rewriting asks which edges executed by successor slot.
+static void fold_branch(uint32_t b) {
+    IrTerm *term = &fn->blocks[b].term;
+    if (term->kind == TERM_BRANCH && executable[b * 2] != executable[b * 2 + 1]) {
+        ir_set_jump(fn, b, term->target[executable[b * 2] ? 0 : 1]);
+    }
+}
+
+// --- Pass ---
+
+// Runs on SSA form, after mem2reg. Blocks that never execute are removed by the cleanup at the
+// end; phis left with a single argument stay until out-of-SSA turns them into copies.
+void sccp_propagate(IrFunction *function, const CompilerOptions *options) {
+    fn = function;
+    Arena *arena = fn->arena;
+    values = arena_calloc(arena, fn->vreg_count, sizeof(LatticeValue));
+    executable = arena_calloc(arena, 2 * fn->block_count, sizeof(uint8_t));
+    visited = arena_calloc(arena, fn->block_count, sizeof(uint8_t));
+    block_work = arena_alloc(arena, fn->block_count * sizeof(uint32_t));
+    block_count = 0;
+    value_work = arena_alloc(arena, 2 * fn->vreg_count * sizeof(VReg));
+    value_count = 0;
+    build_uses(arena);
+
+    propagate();
+
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        if (visited[b]) rewrite_block(b);
+    }
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        if (visited[b]) fold_branch(b);
+    }
+    remove_unreachable_blocks(fn, options);
+
+    fn = NULL;
+    values = NULL;
+    executable = NULL;
+    visited = NULL;
+    use_start = use_block = use_index = NULL;
+    block_work = NULL;
+    value_work = NULL;
+}
@@ -0,0 +1,13 @@
+#ifndef SCCP_H_
+#define SCCP_H_
+
+#include "ir.h"
+#include "pipeline.h"
+
+// Sparse conditional constant propagation (Wegman and Zadeck) over SSA form. Finds the vregs
+// that hold one constant on every path that can execute, replaces their uses by immediates,
+// folds branches whose outcome is known and drops the blocks no executable edge reaches.
+
+void sccp_propagate(IrFunction *fn, const CompilerOptions *options);
+
+#endif
@@ -0,0 +1,362 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scev.h"
+
+// --- Recurrence Arithmetic ---
+
+static Recurrence unknown(void) {
+    Recurrence value;
+    memset(&value, 0, sizeof(value));
+    value.order = SCEV_UNKNOWN;
+    return value;
+}
+
+static Recurrence constant(int32_t start) {
+    Recurrence value;
+    memset(&value, 0, sizeof(value));
+    value.start = start;
+    return value;
+}
+
+// A value that does not change while the loop runs
+static Recurrence symbol(VReg vreg) {
+    Recurrence value = constant(0);
+    value.base = vreg;
+    return value;
+}
+
+static int is_constant(const Recurrence *value) {
+    return value->order == 0 && value->base == NO_VREG;
+}
+
+// Drops trailing zero steps, so that every value has a single representation
+static Recurrence trim(Recurrence value) {
+    while (value.order > 0 && value.order != SCEV_UNKNOWN && value.steps[value.order - 1] == 0) value.order--;
+    return value;
+}
+
+// x + y, or x - y when subtract is set: start and steps add up term by term. At most one base
+// survives (a base minus itself cancels).
+static Recurrence add(Recurrence x, Recurrence y, int subtract) {
+    if (x.order == SCEV_UNKNOWN || y.order == SCEV_UNKNOWN) return unknown();
+    Recurrence sum = x;
+    if (y.base != NO_VREG) {
+        if (subtract ? x.base != y.base : x.base != NO_VREG) return unknown();
+        sum.base = subtract ? NO_VREG : y.base;
+    }
+    uint32_t sign = subtract ? UINT32_MAX : 1;
+    sum.start = (int32_t)((uint32_t)x.start + sign * (uint32_t)y.start);
+    for (; sum.order < y.order; sum.order++) sum.steps[sum.order] = 0;
+    for (uint32_t j = 0; j < y.order; j++) sum.steps[j] = (int32_t)((uint32_t)sum.steps[j] + sign * (uint32_t)y.steps[j]);
+    return trim(sum);
+}
+
+// x * y, when one of them is a constant
+static Recurrence multiply(Recurrence x, Recurrence y) {
+    if (x.order == SCEV_UNKNOWN || y.order == SCEV_UNKNOWN) return unknown();
+    if (!is_constant(&x)) {
+        Recurrence t = x;
+        x = y;
+        y = t;
+    }
+    if (!is_constant(&x)) return unknown();
+    uint32_t factor = (uint32_t)x.start;
+    if (factor == 0) return constant(0);
+    if (y.base != NO_VREG && factor != 1) return unknown();
+    y.start = (int32_t)((uint32_t)y.start * factor);
+    for (uint32_t j = 0; j < y.order; j++) y.steps[j] = (int32_t)((uint32_t)y.steps[j] * factor);
+    return trim(y);
+}
+
+static uint64_t gcd(uint64_t a, uint64_t b) {
+    while (b != 0) {
+        uint64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// C(k, j) mod 2^32 for j <= SCEV_MAX_ORDER. The product of j consecutive integers is divisible
+// by j!, so the divisors cancel against the factors exactly before anything is reduced.
+static uint32_t binomial(uint64_t k, uint32_t j) {
+    if (k < j) return 0;
+    uint64_t factors[SCEV_MAX_ORDER];
+    for (uint32_t i = 0; i < j; i++) factors[i] = k - i;
+    for (uint64_t d = 2; d <= j; d++) {
+        uint64_t rest = d;
+        for (uint32_t i = 0; i < j && rest > 1; i++) {
+            uint64_t g = gcd(factors[i], rest);
+            factors[i] /= g;
+            rest /= g;
+        }
+    }
+    uint32_t result = 1;
+    for (uint32_t i = 0; i < j; i++) result *= (uint32_t)factors[i];
+    return result;
+}
+
+// The value in the given iteration, without the base
+int32_t scev_evaluate(const Recurrence *value, uint64_t iteration) {
+    uint32_t result = (uint32_t)value->start;
+    for (uint32_t j = 1; j <= value->order; j++) result += (uint32_t)value->steps[j - 1] * binomial(iteration, j);
+    return (int32_t)result;
+}
+
+// --- Analysis ---
+static const IrFunction *fn = NULL;
+static const Cfg *cfg = NULL;
+static Scev *scev = NULL;
+
+static Recurrence operand_value(Operand operand) {
+    if (operand.kind == OPND_IMM) return constant(operand.value);
+    if (operand.kind == OPND_REG) return scev->values[operand.value];
+    return unknown();
+}
+
+static Recurrence evaluate_inst(const IrInst *inst) {
+    Recurrence a = operand_value(inst->a);
+    Recurrence b = operand_value(inst->b);
+    switch (inst->op) {
+        case IR_COPY: return a;
+        case IR_ADD: return add(a, b, 0);
+        case IR_SUB: return add(a, b, 1);
+        case IR_MUL: return multiply(a, b);
+        default:
+            if (ir_is_binary((IrOp)inst->op) && is_constant(&a) && is_constant(&b)) {
+                return constant(ir_evaluate((IrOp)inst->op, a.start, b.start));
+            }
+            return unknown();
+    }
+}
+
+// Evaluates the instructions of the loop's own blocks (not those of nested loops, whose
+// values change within one iteration) in reverse postorder, so operands come first. Header
+// phis keep the value they were given; any other phi is unknown.
+static void evaluate_body(void) {
+    const Loop *info = &cfg->loops[scev->loop];
+    for (uint32_t j = 0; j < info->block_count; j++) {
+        uint32_t b = cfg->loop_blocks[info->block_start + j];
+        if (cfg->innermost_loop[b] != scev->loop) continue;
+        const IrBlock *block = &fn->blocks[b];
+        for (uint32_t i = 0; i < block->count; i++) {
+            const IrInst *inst = &block->insts[i];
+            if (inst->op == IR_NOP || inst->dst == NO_VREG) continue;
+            if (inst->op == IR_PHI) {
+                if (b != info->header) scev->values[inst->dst] = unknown();
+                continue;
+            }
+            scev->values[inst->dst] = evaluate_inst(inst);
+        }
+    }
+}
+
+// Header phis become recurrences: a phi whose value coming around the back edge is itself
+// plus D, with D a recurrence, is {initial value, +, D}. D may use other phis, so phis are
+// resolved in rounds. While a phi is unresolved the body is evaluated with the phi standing
+// for itself (a symbol), which is how "itself plus D" shows up.
+static void resolve_phis(uint32_t preheader_index, uint32_t latch_index, Arena *arena) {
+    const IrBlock *header = &fn->blocks[cfg->loops[scev->loop].header];
+    uint32_t phi_count = 0;
+    while (phi_count < header->count && header->insts[phi_count].op == IR_PHI) phi_count++;
+    for (uint32_t i = 0; i < phi_count; i++) scev->values[header->insts[i].dst] = symbol(header->insts[i].dst);
+    if (scev->preheader == NO_BLOCK || scev->latch == NO_BLOCK) phi_count = 0;
+
+    uint8_t *resolved = arena_calloc(arena, phi_count + 1, 1);
+    for (int progress = 1; progress;) {
+        progress = 0;
+        evaluate_body();
+        for (uint32_t i = 0; i < phi_count; i++) {
+            const IrInst *phi = &header->insts[i];
+            if (resolved[i]) continue;
+            Recurrence initial = operand_value(phi->args[preheader_index]);
+            Recurrence step = add(operand_value(phi->args[latch_index]), symbol(phi->dst), 1);
+            if (initial.order != 0 || step.order == SCEV_UNKNOWN || step.base != NO_VREG) continue;
+            if (step.order == SCEV_MAX_ORDER) continue;
+            Recurrence value = initial;
+            value.order = step.order + 1;
+            value.steps[0] = step.start;
+            for (uint32_t j = 0; j < step.order; j++) value.steps[j + 1] = step.steps[j];
+            scev->values[phi->dst] = trim(value);
+            resolved[i] = 1;
+            progress = 1;
+        }
+    }
+    for (uint32_t i = 0; i < header->count && header->insts[i].op == IR_PHI; i++) {
+        if (i >= phi_count || !resolved[i]) scev->values[header->insts[i].dst] = unknown();
+    }
+    evaluate_body();
+}
+
+// Odd x's inverse mod 2^32 (Newton's iteration doubles the correct low bits each step)
+static uint32_t inverse(uint32_t x) {
+    uint32_t result = x;
+    for (int i = 0; i < 5; i++) result *= 2 - x * result;
+    return result;
+}
+
+// First iteration k >= 0 where (start + k * step) cmp bound is false, in wrapping arithmetic.
+// Returns 0 if the comparison never fails, or only fails after the value wraps past the end of
+// the int32 range in its direction (the loop still ends then, but far too late to matter).
+static int exit_iteration(IrOp cmp, int32_t start, int32_t step, int32_t bound, uint64_t *iteration) {
+    if (!ir_evaluate(cmp, start, bound)) {
+        *iteration = 0;
+        return 1;
+    }
+    int64_t distance = (int64_t)bound - start;
+    int64_t k;
+    switch (cmp) {
+        case IR_SEQ:
+            if (step == 0) return 0;
+            *iteration = 1;
+            return 1;
+
+        case IR_SNE: {
+            // Solve start + k * step == bound mod 2^32: step = odd * 2^shift needs the distance
+            // to be a multiple of 2^shift, and then k is unique mod 2^(32 - shift)
+            if (step == 0) return 0;
+            uint32_t gap = (uint32_t)bound - (uint32_t)start;
+            uint32_t shift = 0;
+            while ((((uint32_t)step >> shift) & 1) == 0) shift++;
+            if ((gap & ((1u << shift) - 1)) != 0) return 0;
+            uint64_t solution = (uint64_t)((gap >> shift) * inverse((uint32_t)step >> shift));
+            *iteration = solution & ((UINT64_C(1) << (32 - shift)) - 1);
+            return 1;
+        }
+
+        case IR_SLT: // Counting up to the bound
+        case IR_SLE:
+            if (step <= 0) return 0;
+            k = cmp == IR_SLT ? (distance + step - 1) / step : distance / step + 1;
+            break;
+
+        case IR_SGT: // Counting down to the bound
+        case IR_SGE:
+            if (step >= 0) return 0;
+            k = cmp == IR_SGT ? (-distance - step - 1) / -step : -distance / -step + 1;
+            break;
+
+        default:
+            return 0;
+    }
+    int64_t last = start + k * (int64_t)step;
+    if (last < INT32_MIN || last > INT32_MAX) return 0;
+    *iteration = (uint64_t)k;
+    return 1;
+}
+
+// The loop must leave only from its latch, through a compare of an affine counter with a
+// constant; the latch runs once per header entry, so the trip count is the exit iteration + 1
+static void compute_trip_count(void) {
+    const Loop *info = &cfg->loops[scev->loop];
+    if (scev->latch == NO_BLOCK) return;
+    for (uint32_t j = 0; j < info->block_count; j++) {
+        uint32_t b = cfg->loop_blocks[info->block_start + j];
+        uint32_t succs[2];
+        uint32_t n = ir_successors(&fn->blocks[b], succs);
+        for (uint32_t s = 0; s < n; s++) {
+            if (b != scev->latch && !cfg_in_loop(cfg, scev->loop, succs[s])) return;
+        }
+    }
+    const IrTerm *term = &fn->blocks[scev->latch].term;
+    if (term->kind != TERM_BRANCH || term->target[0] == term->target[1]) return;
+    int stay_slot = cfg_in_loop(cfg, scev->loop, term->target[0]) ? 0 : 1;
+    if (!cfg_in_loop(cfg, scev->loop, term->target[stay_slot])) return;
+    if (cfg_in_loop(cfg, scev->loop, term->target[1 - stay_slot])) return;
+
+    IrOp cmp = stay_slot == 0 ? (IrOp)term->cmp : ir_invert_compare((IrOp)term->cmp);
+    Recurrence a = operand_value(term->a);
+    Recurrence b = operand_value(term->b);
+    if (b.order == 1) {
+        Recurrence t = a;
+        a = b;
+        b = t;
+        cmp = ir_swap_compare(cmp);
+    }
+    if (a.order != 1 || a.base != NO_VREG || !is_constant(&b)) return;
+    uint64_t iteration;
+    if (!exit_iteration(cmp, a.start, a.steps[0], b.start, &iteration)) return;
+    scev->trip_count = iteration + 1;
+    scev->exit_slot = (uint8_t)(1 - stay_slot);
+}
+
+// --- Public API ---
+
+// Analyzes loop of cfg (whose loop nest must be computed)
+Scev *scev_analyze(const IrFunction *function, const Cfg *loops, uint32_t loop, Arena *arena) {
+    fn = function;
+    cfg = loops;
+    scev = arena_calloc(arena, 1, sizeof(Scev));
+    scev->loop = loop;
+    scev->values = arena_alloc(arena, fn->vreg_count * sizeof(Recurrence));
+    for (VReg v = 0; v < fn->vreg_count; v++) scev->values[v] = symbol(v);
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        int inside = cfg_reachable(cfg, b) && cfg_in_loop(cfg, loop, b);
+        for (uint32_t i = 0; i < block->count; i++) {
+            const IrInst *inst = &block->insts[i];
+            if (inst->op == IR_NOP || inst->dst == NO_VREG) continue;
+            if (inside) {
+                scev->values[inst->dst] = unknown();
+            } else if (inst->op == IR_COPY && inst->a.kind == OPND_IMM) {
+                scev->values[inst->dst] = constant(inst->a.value);
+            }
+        }
+    }
+
+    const IrBlock *header = &fn->blocks[cfg->loops[loop].header];
+    uint32_t preheader_index = 0, latch_index = 0;
+    scev->preheader = NO_BLOCK;
+    scev->latch = NO_BLOCK;
+    uint32_t outside = 0, inside = 0;
+    for (uint32_t k = 0; k < header->pred_count; k++) {
+        if (cfg_in_loop(cfg, loop, header->preds[k])) {
+            scev->latch = header->preds[k];
+            latch_index = k;
+            inside++;
+        } else {
+            scev->preheader = header->preds[k];
+            preheader_index = k;
+            outside++;
+        }
+    }
+    if (outside != 1) scev->preheader = NO_BLOCK;
+    if (inside != 1) scev->latch = NO_BLOCK;
+
+    resolve_phis(preheader_index, latch_index, arena);
+    compute_trip_count();
+
+    Scev *result = scev;
+    fn = NULL;
+    cfg = NULL;
+    scev = NULL;
+    return result;
+}
+
+void scev_dump(const Scev *result, const IrFunction *function, const Cfg *loops, FILE *file) {
+    const Loop *info = &loops->loops[result->loop];
+    fprintf(file, "=== Scalar evolution of loop %u (header b%u): ", (unsigned)result->loop, (unsigned)info->header);
+    if (result->trip_count == 0) {
+        fprintf(file, "trip count unknown ===\n");
+    } else {
+        fprintf(file, "trip count %llu ===\n", (unsigned long long)result->trip_count);
+    }
+    for (uint32_t j = 0; j < info->block_count; j++) {
+        uint32_t b = loops->loop_blocks[info->block_start + j];
+        const IrBlock *block = &function->blocks[b];
+        for (uint32_t i = 0; i < block->count; i++) {
+            VReg dst = block->insts[i].dst;
+            if (block->insts[i].op == IR_NOP || dst == NO_VREG) continue;
+            const Recurrence *value = &result->values[dst];
+            if (value->order == SCEV_UNKNOWN) continue;
+            fprintf(file, "v%u = {", (unsigned)dst);
+            if (value->base != NO_VREG) fprintf(file, "v%u + ", (unsigned)value->base);
+            fprintf(file, "%d", (int)value->start);
+            for (uint32_t s = 0; s < value->order; s++) fprintf(file, ", +, %d", (int)value->steps[s]);
+            fprintf(file, "}\n");
+        }
+    }
+    fprintf(file, "\n");
+}
@@ -0,0 +1,37 @@
+#ifndef SCEV_H_
+#define SCEV_H_
+
+#include <stdio.h>
+#include "ir.h"
+#include "cfg.h"
+#include "arena.h"
+
+#define SCEV_MAX_ORDER 3
+#define SCEV_UNKNOWN ((uint32_t)UINT32_MAX)
+
+// A chain of recurrences {start, +, steps[0], +, steps[1], ...} over the iterations of a loop:
+// in iteration k (counting from 0) the value is base + start + sum of steps[j - 1] * C(k, j)
+// for j = 1 .. order. All arithmetic wraps like RV32, which keeps the formula exact.
+typedef struct {
+    uint32_t order; // 0 for a loop-invariant value, SCEV_UNKNOWN if not a recurrence
+    VReg base;      // Loop-invariant vreg added to the start, NO_VREG for none
+    int32_t start;
+    int32_t steps[SCEV_MAX_ORDER];
+} Recurrence;
+
+// Scalar evolution of one loop: what every vreg the loop defines is in terms of the iteration
+// number, and how many iterations the loop runs when that is known at compile time.
+typedef struct {
+    uint32_t loop;
+    uint32_t preheader;   // Only predecessor of the header outside the loop, NO_BLOCK if several
+    uint32_t latch;       // Only predecessor of the header inside the loop, NO_BLOCK if several
+    uint64_t trip_count;  // Times the header runs, 0 if unknown
+    uint8_t exit_slot;    // Latch terminator target leaving the loop (when trip_count is known)
+    Recurrence *values;   // vreg -> recurrence (values defined outside the loop are invariant)
+} Scev;
+
+Scev *scev_analyze(const IrFunction *fn, const Cfg *cfg, uint32_t loop, Arena *arena);
+int32_t scev_evaluate(const Recurrence *value, uint64_t iteration);
+void scev_dump(const Scev *scev, const IrFunction *fn, const Cfg *cfg, FILE *file);
+
+#endif
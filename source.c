@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "source.h"
+
+#define SOURCE_READ_CHUNK 65536
+
+// --- Memory-Mapped Input ---
+
+// Maps a regular file read-only so the lexer can scan it in place.
+// Returns 0 on success, -1 if the file cannot be mapped (pipe, terminal, empty file...).
+static int source_map(Source *source, FILE *file)
+{
+#if defined(_WIN32)
+  HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+  LARGE_INTEGER size;
+  if (handle == INVALID_HANDLE_VALUE || GetFileType(handle) != FILE_TYPE_DISK ||
+      !GetFileSizeEx(handle, &size) || size.QuadPart <= 0)
+  {
+    return -1;
+  }
+
+  HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping == NULL)
+  {
+    return -1;
+  }
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data == NULL)
+  {
+    CloseHandle(mapping);
+    return -1;
+  }
+  source->mapping = mapping;
+  source->data = data;
+  source->length = (size_t)size.QuadPart;
+#else
+  struct stat info;
+  if (fstat(fileno(file), &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0)
+  {
+    return -1;
+  }
+
+  void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+  if (data == MAP_FAILED)
+  {
+    return -1;
+  }
+#if defined(MADV_SEQUENTIAL)
+  madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL); // The lexer makes a single forward pass
+#endif
+  source->data = data;
+  source->length = (size_t)info.st_size;
+#endif
+  source->mapped = 1;
+  return 0;
+}
+
+// --- Streaming Fallback ---
+
+// Reads the whole stream into a heap buffer in fixed-size chunks.
+// Used for pipes and stdin, where neither mapping nor fseek/ftell work.
+static int source_read_stream(Source *source, FILE *file)
+{
+  size_t capacity = SOURCE_READ_CHUNK;
+  size_t length = 0;
+  char *buffer = malloc(capacity);
+  if (buffer == NULL)
+  {
+    return -1;
+  }
+
+  for (;;)
+  {
+    if (capacity - length < SOURCE_READ_CHUNK)
+    {
+      capacity *= 2;
+      char *grown = realloc(buffer, capacity);
+      if (grown == NULL)
+      {
+        free(buffer);
+        return -1;
+      }
+      buffer = grown;
+    }
+    size_t bytes_read = fread(buffer + length, 1, SOURCE_READ_CHUNK, file);
+    length += bytes_read;
+    if (bytes_read < SOURCE_READ_CHUNK)
+    {
+      break;
+    }
+  }
+
+  if (ferror(file))
+  {
+    free(buffer);
+    return -1;
+  }
+
+  source->data = buffer;
+  source->length = length;
+  source->mapped = 0;
+  return 0;
+}
+
+// --- Public API ---
+
+// Opens the source text behind file: mapped when it is a regular file, streamed otherwise.
+// The file may be closed once this returns; the source stays valid until source_close.
+int source_open(Source *source, FILE *file)
+{
+  memset(source, 0, sizeof(*source));
+  if (source_map(source, file) == 0)
+  {
+    return 0;
+  }
+  return source_read_stream(source, file);
+}
+
+void source_close(Source *source)
+{
+  if (source->data == NULL)
+  {
+    return;
+  }
+  if (source->mapped)
+  {
+#if defined(_WIN32)
+    UnmapViewOfFile(source->data);
+    CloseHandle((HANDLE)source->mapping);
+#else
+    munmap((void *)source->data, source->length);
+#endif
+  }
+  else
+  {
+    free((void *)source->data);
+  }
+  source->data = NULL;
+  source->length = 0;
+}
@@ -0,0 +1,20 @@
+#ifndef SOURCE_H_
+#define SOURCE_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+typedef struct
+{
+  const char *data; // Source text; NOT NUL-terminated when mapped, always bound by length
+  size_t length;
+  int mapped;       // 1 if data is a read-only file mapping, 0 if it was read into a heap buffer
+#if defined(_WIN32)
+  void *mapping;    // File mapping handle backing data
+#endif
+} Source;
+
+int source_open(Source *source, FILE *file);
+void source_close(Source *source);
+
+#endif
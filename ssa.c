@@ -0,0 +1,430 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ssa.h"
+#include "cfg.h"
+
+// --- Helpers ---
+
+// Drops the NOPs left behind by a pass, keeping the order of everything else
+static void compact_block(IrBlock *block) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < block->count; i++) {
+        if (block->insts[i].op != IR_NOP) block->insts[kept++] = block->insts[i];
+    }
+    block->count = kept;
+}
+
+// Position of pred in the predecessor list of block, i.e. the phi argument it supplies
+static uint32_t pred_index(const IrBlock *block, uint32_t pred) {
+    for (uint32_t p = 0; p < block->pred_count; p++) {
+        if (block->preds[p] == pred) return p;
+    }
+    return NO_BLOCK;
+}
+
+// --- Phi Placement ---
+
+// Decides where phis go: a variable needs one at every block in the iterated dominance
+// frontier of the blocks that store it. Only variables read in some block before being stored
+// there ("non-local" variables) can need one; the rest are skipped (semi-pruned SSA).
+// Returns the variables needing a phi in block b as vars[phi_start[b] .. phi_start[b + 1]).
+static uint32_t *place_phis(const IrFunction *fn, const Cfg *cfg, Arena *arena, uint32_t **phi_start) {
+    uint32_t n = fn->block_count;
+    uint32_t vars = fn->var_count;
+
+    // Blocks storing each variable, as flat lists, and which variables are non-local
+    uint8_t *non_local = arena_calloc(arena, vars + 1, sizeof(uint8_t));
+    uint32_t *stored_in = arena_calloc(arena, vars + 1, sizeof(uint32_t)); // Block + 1 that last stored the slot
+    uint32_t *def_start = arena_calloc(arena, vars + 2, sizeof(uint32_t));
+    for (uint32_t i = 0; i < cfg->rpo_count; i++) {
+        uint32_t b = cfg->rpo[i];
+        const IrBlock *block = &fn->blocks[b];
+        for (uint32_t j = 0; j < block->count; j++) {
+            const IrInst *inst = &block->insts[j];
+            if (inst->op == IR_LOAD && stored_in[inst->var] != b + 1) non_local[inst->var] = 1;
+            if (inst->op == IR_STORE && stored_in[inst->var] != b + 1) {
+                stored_in[inst->var] = b + 1;
+                def_start[inst->var + 1]++;
+            }
+        }
+    }
+    for (uint32_t v = 0; v < vars; v++) def_start[v + 1] += def_start[v];
+    uint32_t *def_blocks = arena_alloc(arena, (def_start[vars] + 1) * sizeof(uint32_t));
+    uint32_t *fill = arena_alloc(arena, (vars + 1) * sizeof(uint32_t));
+    memcpy(fill, def_start, vars * sizeof(uint32_t));
+    memset(stored_in, 0, (vars + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < cfg->rpo_count; i++) {
+        uint32_t b = cfg->rpo[i];
+        const IrBlock *block = &fn->blocks[b];
+        for (uint32_t j = 0; j < block->count; j++) {
+            const IrInst *inst = &block->insts[j];
+            if (inst->op != IR_STORE || stored_in[inst->var] == b + 1) continue;
+            stored_in[inst->var] = b + 1;
+            def_blocks[fill[inst->var]++] = b;
+        }
+    }
+
+    // Worklist over the iterated frontier; the stamps hold var + 1 so they never need clearing
+    uint32_t *phi_for = arena_calloc(arena, n + 1, sizeof(uint32_t));
+    uint32_t *queued_for = arena_calloc(arena, n + 1, sizeof(uint32_t));
+    uint32_t *work = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    uint32_t *counts = arena_calloc(arena, n + 2, sizeof(uint32_t));
+    uint32_t *pairs = NULL; // (block, var) pairs in variable order
+    uint32_t pair_count = 0, pair_capacity = 0;
+    for (uint32_t v = 0; v < vars; v++) {
+        if (!non_local[v]) continue;
+        uint32_t count = 0;
+        for (uint32_t d = def_start[v]; d < def_start[v + 1]; d++) {
+            work[count++] = def_blocks[d];
+            queued_for[def_blocks[d]] = v + 1;
+        }
+        while (count > 0) {
+            uint32_t b = work[--count];
+            for (uint32_t f = cfg->df_start[b]; f < cfg->df_start[b + 1]; f++) {
+                uint32_t join = cfg->df[f];
+                if (phi_for[join] == v + 1) continue;
+                phi_for[join] = v + 1;
+                if (pair_count == pair_capacity) {
+                    uint32_t capacity = pair_capacity ? pair_capacity * 2 : 64;
+                    pairs = arena_grow(arena, pairs, pair_capacity * 2 * sizeof(uint32_t), capacity * 2 * sizeof(uint32_t));
+                    pair_capacity = capacity;
+                }
+                pairs[2 * pair_count] = join;
+                pairs[2 * pair_count + 1] = v;
+                pair_count++;
+                counts[join + 1]++;
+                if (queued_for[join] != v + 1) {
+                    queued_for[join] = v + 1;
+                    work[count++] = join;
+                }
+            }
+        }
+    }
+
+    // Counting sort by block keeps each block's variables in order
+    for (uint32_t b = 0; b < n; b++) counts[b + 1] += counts[b];
+    uint32_t *phi_vars = arena_alloc(arena, (pair_count + 1) * sizeof(uint32_t));
+    *phi_start = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    memcpy(*phi_start, counts, (n + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < pair_count; i++) phi_vars[counts[pairs[2 * i]]++] = pairs[2 * i + 1];
+    return phi_vars;
+}
+
+// Rebuilds each block's instruction array with empty phis in front
+static void insert_phis(IrFunction *fn, const uint32_t *phi_start, const uint32_t *phi_vars) {
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        uint32_t phis = phi_start[b + 1] - phi_start[b];
+        if (phis == 0) continue;
+        IrBlock *block = &fn->blocks[b];
+        uint32_t capacity = block->count + phis;
+        IrInst *insts = arena_alloc(fn->arena, capacity * sizeof(IrInst));
+        uint32_t count = 0;
+        for (uint32_t p = phi_start[b]; p < phi_start[b + 1]; p++) {
+            uint32_t v = phi_vars[p];
+            IrInst *phi = &insts[count++];
+            memset(phi, 0, sizeof(*phi));
+            phi->op = IR_PHI;
+            phi->dst = ir_new_vreg(fn);
+            phi->var = v;
+            phi->arg_count = block->pred_count;
+            phi->args = arena_calloc(fn->arena, block->pred_count, sizeof(Operand));
+        }
+        if (block->count > 0) memcpy(insts + count, block->insts, block->count * sizeof(IrInst));
+        block->insts = insts;
+        block->count += count;
+        block->capacity = capacity;
+    }
+}
+
+// --- Renaming ---
+
+typedef struct {
+    uint32_t var;
+    Operand previous;
+} RenameUndo;
+
+static Operand *current_value = NULL; // Variable slot -> reaching value
+static Operand *replacement = NULL;   // LOAD result vreg -> the value it reads
+static RenameUndo *undo_log = NULL;
+static uint32_t undo_count = 0;
+
+static void rewrite_operand(Operand *operand) {
+    if (operand->kind == OPND_REG && replacement[operand->value].kind != OPND_NONE) {
+        *operand = replacement[operand->value];
+    }
+}
+
+static void set_current(uint32_t var, Operand value) {
+    undo_log[undo_count].var = var;
+    undo_log[undo_count].previous = current_value[var];
+    undo_count++;
+    current_value[var] = value;
+}
+
+// Replaces the LOADs and STOREs of block b by the reaching values and fills in the phi
+// arguments b passes to its successors
+static void rename_block(IrFunction *fn, uint32_t b) {
+    IrBlock *block = &fn->blocks[b];
+    for (uint32_t i = 0; i < block->count; i++) {
+        IrInst *inst = &block->insts[i];
+        switch (inst->op) {
+            case IR_PHI:
+                set_current(inst->var, ir_reg(inst->dst));
+                break;
+            case IR_LOAD:
+                replacement[inst->dst] = current_value[inst->var];
+                inst->op = IR_NOP;
+                break;
+            case IR_STORE:
+                rewrite_operand(&inst->a);
+                set_current(inst->var, inst->a);
+                inst->op = IR_NOP;
+                break;
+            default:
+                rewrite_operand(&inst->a);
+                rewrite_operand(&inst->b);
+                break;
+        }
+    }
+    rewrite_operand(&block->term.a);
+    rewrite_operand(&block->term.b);
+
+    uint32_t succs[2];
+    uint32_t count = ir_successors(block, succs);
+    for (uint32_t s = 0; s < count; s++) {
+        IrBlock *succ = &fn->blocks[succs[s]];
+        uint32_t k = pred_index(succ, b);
+        for (uint32_t i = 0; i < succ->count && succ->insts[i].op == IR_PHI; i++) {
+            succ->insts[i].args[k] = current_value[succ->insts[i].var];
+        }
+    }
+}
+
+// Walks the dominator tree without recursion. Each stack entry is block * 2 (enter) or
+// block * 2 + 1 (leave, undoing the block's variable updates).
+static void rename_variables(IrFunction *fn, const Cfg *cfg, Arena *arena) {
+    uint32_t n = fn->block_count;
+    uint32_t *stack = arena_alloc(arena, (2 * n + 1) * sizeof(uint32_t));
+    uint32_t *undo_mark = arena_alloc(arena, (n + 1) * sizeof(uint32_t));
+    uint32_t depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0) {
+        uint32_t entry = stack[--depth];
+        uint32_t b = entry >> 1;
+        if (entry & 1) {
+            while (undo_count > undo_mark[b]) {
+                undo_count--;
+                current_value[undo_log[undo_count].var] = undo_log[undo_count].previous;
+            }
+            continue;
+        }
+        undo_mark[b] = undo_count;
+        rename_block(fn, b);
+        stack[depth++] = b * 2 + 1;
+        for (uint32_t c = cfg->dom_child_start[b + 1]; c-- > cfg->dom_child_start[b];) {
+            stack[depth++] = cfg->dom_children[c] * 2;
+        }
+    }
+}
+
+// Deletes phis whose value never reaches a non-phi use (a variable stored in a loop and not
+// read after it, or a chain of such phis)
+static void remove_dead_phis(IrFunction *fn, Arena *arena) {
+    uint8_t *used = arena_calloc(arena, fn->vreg_count, sizeof(uint8_t));
+    IrInst **phi_of = arena_calloc(arena, fn->vreg_count, sizeof(IrInst *));
+    VReg *work = arena_alloc(arena, fn->vreg_count * sizeof(VReg));
+    uint32_t count = 0;
+
+#define MARK_USED(operand)                                                                 \
+    do {                                                                                   \
+        if ((operand).kind == OPND_REG && !used[(operand).value]) {                        \
+            used[(operand).value] = 1;                                                     \
+            work[count++] = (VReg)(operand).value;                                         \
+        }                                                                                  \
+    } while (0)
+
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        IrBlock *block = &fn->blocks[b];
+        for (uint32_t i = 0; i < block->count; i++) {
+            IrInst *inst = &block->insts[i];
+            if (inst->op == IR_PHI) {
+                phi_of[inst->dst] = inst;
+                continue;
+            }
+            MARK_USED(inst->a);
+            MARK_USED(inst->b);
+        }
+        MARK_USED(block->term.a);
+        MARK_USED(block->term.b);
+    }
+    while (count > 0) {
+        IrInst *phi = phi_of[work[--count]];
+        if (phi == NULL) continue;
+        for (uint32_t k = 0; k < phi->arg_count; k++) MARK_USED(phi->args[k]);
+    }
+#undef MARK_USED
+
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        IrBlock *block = &fn->blocks[b];
+        for (uint32_t i = 0; i < block->count && block->insts[i].op == IR_PHI; i++) {
+            if (!used[block->insts[i].dst]) block->insts[i].op = IR_NOP;
+        }
+        compact_block(block);
+    }
+}
+
+// --- mem2reg ---
+
+// Promotes every variable slot to SSA vregs. C0 never takes the address of a variable, so
+// all of them qualify. A read with no store on some path sees 0. Expects no unreachable blocks
+// (cleanup runs first) and up-to-date predecessor lists.
+void ssa_construct(IrFunction *fn, const CompilerOptions *options) {
+    (void)options;
+    if (fn->var_count == 0) return;
+    Arena *arena = fn->arena;
+    Cfg *cfg = cfg_build(fn, arena);
+    cfg_compute_frontiers(cfg, arena);
+
+    uint32_t *phi_start;
+    uint32_t *phi_vars = place_phis(fn, cfg, arena, &phi_start);
+    insert_phis(fn, phi_start, phi_vars);
+
+    uint32_t var_defs = 0;
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        var_defs += fn->blocks[b].count; // Upper bound on phis + STOREs, the entries of the undo log
+    }
+    current_value = arena_alloc(arena, fn->var_count * sizeof(Operand));
+    for (uint32_t v = 0; v < fn->var_count; v++) current_value[v] = ir_imm(0);
+    replacement = arena_calloc(arena, fn->vreg_count, sizeof(Operand));
+    undo_log = arena_alloc(arena, (var_defs + 1) * sizeof(RenameUndo));
+    undo_count = 0;
+    rename_variables(fn, cfg, arena);
+
+    remove_dead_phis(fn, arena);
+    current_value = NULL;
+    replacement = NULL;
+    undo_log = NULL;
+}
+
+// --- Out-of-SSA ---
+
+// Gives the edge pred -> b its own block when pred branches elsewhere too, so copies for b's
+// phis can go on that edge alone. The new block takes pred's place in b's predecessor list.
+static uint32_t split_edge(IrFunction *fn, uint32_t pred, uint32_t b, uint32_t k) {
+    uint32_t middle = ir_new_block(fn);
+    ir_set_jump(fn, middle, b);
+    IrTerm *term = &fn->blocks[pred].term;
+    for (int i = 0; i < 2; i++) {
+        if (term->target[i] == b) term->target[i] = middle;
+    }
+    fn->blocks[b].preds[k] = middle;
+    fn->blocks[middle].preds = arena_alloc(fn->arena, sizeof(uint32_t));
+    fn->blocks[middle].preds[0] = pred;
+    fn->blocks[middle].pred_count = 1;
+    return middle;
+}
+
+typedef struct {
+    VReg dst;
+    Operand src;
+} ParallelCopy;
+
+// Appends copies performing all of copies[] at once. A copy waits until no pending copy still
+// reads its destination; what is left then are pure cycles, each broken with one temporary.
+// readers and writer_of are indexed by vreg and must be zero; they are left zero.
+static void sequentialize_copies(IrFunction *fn, uint32_t block, ParallelCopy *copies, uint32_t count,
+                                 uint32_t *readers, uint32_t *writer_of, uint32_t *ready) {
+    uint32_t pending = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (copies[i].src.kind == OPND_REG && (VReg)copies[i].src.value == copies[i].dst) {
+            copies[i].dst = NO_VREG; // Self-copy
+            continue;
+        }
+        writer_of[copies[i].dst] = i + 1;
+        if (copies[i].src.kind == OPND_REG) readers[copies[i].src.value]++;
+        pending++;
+    }
+    uint32_t ready_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (copies[i].dst != NO_VREG && readers[copies[i].dst] == 0) ready[ready_count++] = i;
+    }
+
+    while (pending > 0) {
+        if (ready_count == 0) {
+            // Only cycles remain: save one destination in a temporary and redirect its reader
+            uint32_t i = 0;
+            while (copies[i].dst == NO_VREG) i++;
+            VReg saved = copies[i].dst;
+            VReg temp = ir_new_vreg(fn);
+            IrInst *copy = ir_append(fn, block, IR_COPY);
+            copy->dst = temp;
+            copy->a = ir_reg(saved);
+            for (uint32_t j = 0; j < count; j++) {
+                if (copies[j].dst != NO_VREG && copies[j].src.kind == OPND_REG && (VReg)copies[j].src.value == saved) {
+                    copies[j].src = ir_reg(temp);
+                }
+            }
+            readers[saved] = 0;
+            ready[ready_count++] = i;
+        }
+        uint32_t i = ready[--ready_count];
+        IrInst *copy = ir_append(fn, block, IR_COPY);
+        copy->dst = copies[i].dst;
+        copy->a = copies[i].src;
+        writer_of[copies[i].dst] = 0;
+        copies[i].dst = NO_VREG;
+        pending--;
+        if (copies[i].src.kind == OPND_REG) {
+            VReg src = (VReg)copies[i].src.value;
+            if (readers[src] > 0 && --readers[src] == 0 && writer_of[src] != 0) ready[ready_count++] = writer_of[src] - 1;
+        }
+    }
+}
+
+// Replaces the phis by copies at the end of each incoming edge, splitting critical edges first
+// so a copy never runs on a path that does not enter the phi's block.
+void ssa_destruct(IrFunction *fn, const CompilerOptions *options) {
+    (void)options;
+    Arena *arena = fn->arena;
+    uint32_t max_phis = 0, copy_count = 0;
+    for (uint32_t b = 0; b < fn->block_count; b++) {
+        uint32_t phis = 0;
+        while (phis < fn->blocks[b].count && fn->blocks[b].insts[phis].op == IR_PHI) phis++;
+        if (phis > max_phis) max_phis = phis;
+        copy_count += phis * fn->blocks[b].pred_count;
+    }
+    if (max_phis == 0) return;
+    // Cycle temporaries are new vregs; there is at most one per copy
+    uint32_t vreg_limit = fn->vreg_count + copy_count;
+    uint32_t *readers = arena_calloc(arena, vreg_limit, sizeof(uint32_t));
+    uint32_t *writer_of = arena_calloc(arena, vreg_limit, sizeof(uint32_t));
+    ParallelCopy *copies = arena_alloc(arena, max_phis * sizeof(ParallelCopy));
+    uint32_t *ready = arena_alloc(arena, max_phis * sizeof(uint32_t));
+
+    uint32_t original_count = fn->block_count;
+    for (uint32_t b = 0; b < original_count; b++) {
+        uint32_t phis = 0;
+        while (phis < fn->blocks[b].count && fn->blocks[b].insts[phis].op == IR_PHI) phis++;
+        if (phis == 0) continue;
+
+        for (uint32_t k = 0; k < fn->blocks[b].pred_count; k++) {
+            uint32_t pred = fn->blocks[b].preds[k];
+            uint32_t succs[2];
+            if (ir_successors(&fn->blocks[pred], succs) > 1) pred = split_edge(fn, pred, b, k);
+
+            const IrBlock *block = &fn->blocks[b]; // Re-read: split_edge may move the blocks
+            for (uint32_t i = 0; i < phis; i++) {
+                copies[i].dst = block->insts[i].dst;
+                copies[i].src = block->insts[i].args[k];
+            }
+            sequentialize_copies(fn, pred, copies, phis, readers, writer_of, ready);
+        }
+
+        IrBlock *block = &fn->blocks[b];
+        for (uint32_t i = 0; i < phis; i++) block->insts[i].op = IR_NOP;
+        compact_block(block);
+    }
+    cfg_compute_predecessors(fn);
+}
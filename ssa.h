@@ -0,0 +1,14 @@
+#ifndef SSA_H_
+#define SSA_H_
+
+#include "ir.h"
+#include "pipeline.h"
+
+// SSA form: every vreg has exactly one definition and values merging at a join are named by
+// PHI instructions at the top of the block. mem2reg promotes the variable slots into SSA
+// vregs; out-of-SSA turns the phis back into copies on the incoming edges.
+
+void ssa_construct(IrFunction *fn, const CompilerOptions *options);
+void ssa_destruct(IrFunction *fn, const CompilerOptions *options);
+
+#endif
@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "target.h"
+
+// --- Targets ---
+
+// rv32im: pipelined multiplier, iterative divider (typical in-order application core)
+// rv32im-slowmul: iterative multiplier too (small microcontroller cores)
+// rv32i: no M extension; multiplies by constants become shifts and adds
+static const Target targets[] = {
+    { "rv32im", 1, 3, 35 },
+    { "rv32im-slowmul", 1, 32, 34 },
+    { "rv32i", 0, 0, 0 },
+};
+
+#define TARGET_COUNT (sizeof(targets) / sizeof(targets[0]))
+
+const Target *target_default(void) {
+    return &targets[0];
+}
+
+const Target *target_lookup(const char *name) {
+    for (size_t i = 0; i < TARGET_COUNT; i++) {
+        if (strcmp(targets[i].name, name) == 0) return &targets[i];
+    }
+    return NULL;
+}
+
+void target_list(FILE *file) {
+    for (size_t i = 0; i < TARGET_COUNT; i++) fprintf(file, "%s%s", i ? ", " : "", targets[i].name);
+    fprintf(file, "\n");
+}
+
+void target_require_mul(const Target *target, const char *what) {
+    if (target->has_mul) return;
+    fprintf(stderr, "CodeGen Error: %s needs the M extension, which target %s does not have\n", what, target->name);
+    exit(EXIT_FAILURE);
+}
+
+// --- Costs ---
+
+static int fits_imm12(long value) {
+    return value >= -2048 && value <= 2047;
+}
+
+// li is one addi for 12-bit values, lui + addi otherwise
+static int load_cost(int32_t value) {
+    return fits_imm12(value) ? 1 : 2;
+}
+
+// Cost of the plain instruction with its constant loaded into a register, or a huge cost if
+// the target does not have it
+static int plain_cost(const Target *target, int32_t constant, int latency) {
+    return target->has_mul ? load_cost(constant) + latency : 1 << 20;
+}
+
+static uint32_t magnitude(int32_t value) {
+    return value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+}
+
+static int is_power_of_two(uint32_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static int log2_exact(uint32_t value) {
+    int k = 0;
+    while ((value >>= 1) != 0) k++;
+    return k;
+}
+
+static int popcount(uint32_t value) {
+    int count = 0;
+    for (; value != 0; value &= value - 1) count++;
+    return count;
+}
+
+// --- Multiplication ---
+
+// x * m as shifts and adds: one slli + add per set bit of m past the lowest, or 2^k +- 1 in
+// two instructions. Returns the instruction count of the cheapest form.
+static int multiply_cost(uint32_t m) {
+    if (m == 0 || is_power_of_two(m)) return 1;
+    if (is_power_of_two(m - 1) || is_power_of_two(m + 1)) return 2;
+    return ((m & 1) ? 0 : 1) + 2 * (popcount(m) - 1);
+}
+
+int target_emit_multiply_imm(Emitter *out, const Target *target, Reg rd, Reg rs, int32_t c, Reg s1, Reg s2) {
+    uint32_t m = magnitude(c);
+    int negate = c < 0;
+    if (multiply_cost(m) + negate > plain_cost(target, c, target->mul_latency)) return 0;
+    if (out == NULL) return 1;
+
+    if (m == 0) {
+        emit_ri(out, MN_LI, rd, 0);
+        return 1;
+    }
+    if (is_power_of_two(m)) {
+        int k = log2_exact(m);
+        if (k == 0) emit_rr(out, MN_MV, rd, rs);
+        else emit_rri(out, MN_SLLI, rd, rs, k);
+    } else if (is_power_of_two(m - 1)) {
+        emit_rri(out, MN_SLLI, s1, rs, log2_exact(m - 1));
+        emit_rrr(out, MN_ADD, rd, s1, rs);
+    } else if (is_power_of_two(m + 1)) {
+        emit_rri(out, MN_SLLI, s1, rs, log2_exact(m + 1));
+        emit_rrr(out, MN_SUB, rd, s1, rs);
+    } else {
+        // Sum of rs << b over the set bits b; rs is read until the last shift
+        Reg sum = rs;
+        int bit = 0;
+        while (!(m & ((uint32_t)1 << bit))) bit++;
+        if (bit > 0) {
+            emit_rri(out, MN_SLLI, s1, rs, bit);
+            sum = s1;
+        }
+        m &= m - 1;
+        while (m != 0) {
+            bit = log2_exact(m & (0u - m));
+            m &= m - 1;
+            emit_rri(out, MN_SLLI, s2, rs, bit);
+            Reg into = m == 0 ? rd : s1;
+            emit_rrr(out, MN_ADD, into, sum, s2);
+            sum = s1;
+        }
+    }
+    if (negate) emit_rr(out, MN_NEG, rd, rd);
+    return 1;
+}
+
+// --- Division ---
+
+// Magic multiplier and shift for signed division by d, |d| >= 2 (Hacker's Delight, 10-1):
+// x / d == (mulh(x, magic) [+ x for d > 0 and magic < 0, - x for d < 0 and magic > 0]) >> shift,
+// plus one when that is negative
+static void division_magic(int32_t d, int32_t *magic, int *shift) {
+    const uint32_t two31 = 0x80000000u;
+    uint32_t ad = magnitude(d);
+    uint32_t t = two31 + ((uint32_t)d >> 31);
+    uint32_t anc = t - 1 - t % ad; // Absolute value of nc
+    int p = 31;
+    uint32_t q1 = two31 / anc, r1 = two31 - q1 * anc;
+    uint32_t q2 = two31 / ad, r2 = two31 - q2 * ad;
+    uint32_t delta;
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) {
+            q1++;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= ad) {
+            q2++;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    uint32_t m = q2 + 1;
+    *magic = (int32_t)(d < 0 ? 0u - m : m);
+    *shift = p - 32;
+}
+
+static int magic_cost(const Target *target, int32_t d) {
+    int32_t magic;
+    int shift;
+    division_magic(d, &magic, &shift);
+    int fix = (d > 0 && magic < 0) || (d < 0 && magic > 0);
+    return load_cost(magic) + target->mul_latency + fix + (shift > 0) + 2;
+}
+
+// Quotient x / d for |d| >= 2 into rd; s1 is clobbered, and so is s2 unless |d| is a power of two
+static void emit_quotient(Emitter *out, Reg rd, Reg rs, int32_t d, Reg s1, Reg s2) {
+    uint32_t ad = magnitude(d);
+    if (is_power_of_two(ad)) {
+        // Round toward zero: add 2^k - 1 to negative dividends before the arithmetic shift
+        int k = log2_exact(ad);
+        if (k == 1) {
+            emit_rri(out, MN_SRLI, s1, rs, 31);
+        } else {
+            emit_rri(out, MN_SRAI, s1, rs, 31);
+            emit_rri(out, MN_SRLI, s1, s1, 32 - k);
+        }
+        emit_rrr(out, MN_ADD, s1, rs, s1);
+        emit_rri(out, MN_SRAI, rd, s1, k);
+        if (d < 0) emit_rr(out, MN_NEG, rd, rd);
+        return;
+    }
+    int32_t magic;
+    int shift;
+    division_magic(d, &magic, &shift);
+    emit_ri(out, MN_LI, s1, magic);
+    emit_rrr(out, MN_MULH, s1, rs, s1);
+    if (d > 0 && magic < 0) emit_rrr(out, MN_ADD, s1, s1, rs);
+    if (d < 0 && magic > 0) emit_rrr(out, MN_SUB, s1, s1, rs);
+    if (shift > 0) emit_rri(out, MN_SRAI, s1, s1, shift);
+    emit_rri(out, MN_SRLI, s2, s1, 31);
+    emit_rrr(out, MN_ADD, rd, s1, s2);
+}
+
+static int quotient_cost(const Target *target, int32_t d) {
+    uint32_t ad = magnitude(d);
+    if (is_power_of_two(ad)) return (ad == 2 ? 3 : 4) + (d < 0);
+    return magic_cost(target, d);
+}
+
+int target_emit_divide_imm(Emitter *out, const Target *target, Reg rd, Reg rs, int32_t d, Reg s1, Reg s2) {
+    if (d == 0) return 0; // Left to div, which defines the result (-1)
+    if (d == 1 || d == -1) {
+        if (out != NULL) emit_rr(out, d == 1 ? MN_MV : MN_NEG, rd, rs);
+        return 1;
+    }
+    if (!target->has_mul && !is_power_of_two(magnitude(d))) return 0; // The magic number needs mulh
+    if (quotient_cost(target, d) > plain_cost(target, d, target->div_latency)) return 0;
+    if (out == NULL) return 1;
+    emit_quotient(out, rd, rs, d, s1, s2);
+    return 1;
+}
+
+// x % d == x - (x / d) * d; for |d| == 2^k the product is the quotient shifted back
+int target_emit_remainder_imm(Emitter *out, const Target *target, Reg rd, Reg rs, int32_t d, Reg s1, Reg s2) {
+    if (d == 0) return 0; // Left to rem, which defines the result (the dividend)
+    if (d == 1 || d == -1) {
+        if (out != NULL) emit_ri(out, MN_LI, rd, 0);
+        return 1;
+    }
+    uint32_t ad = magnitude(d);
+    if (is_power_of_two(ad)) {
+        if (quotient_cost(target, (int32_t)ad) + 2 > plain_cost(target, d, target->div_latency)) return 0;
+        if (out == NULL) return 1;
+        // The sign of d does not matter; for INT_MIN, (int32_t)ad is d itself and the
+        // quotient (0 or 1) shifted by 31 is still the product
+        emit_quotient(out, s1, rs, (int32_t)ad, s1, s2);
+        emit_rri(out, MN_SLLI, s1, s1, log2_exact(ad));
+        emit_rrr(out, MN_SUB, rd, rs, s1);
+        return 1;
+    }
+    if (!target->has_mul ||
+        quotient_cost(target, d) + load_cost(d) + target->mul_latency + 1 > plain_cost(target, d, target->div_latency)) {
+        return 0;
+    }
+    if (out == NULL) return 1;
+    emit_quotient(out, s1, rs, d, s1, s2);
+    emit_ri(out, MN_LI, s2, d);
+    emit_rrr(out, MN_MUL, s1, s1, s2);
+    emit_rrr(out, MN_SUB, rd, rs, s1);
+    return 1;
+}
@@ -0,0 +1,33 @@
+#ifndef TARGET_H_
+#define TARGET_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "emit.h"
+
+// The RV32 core code is generated for. Costs are in cycles, with every other instruction
+// counted as one; they decide when a shift sequence beats mul/div.
+typedef struct {
+    const char *name;
+    int has_mul;     // M extension: mul, mulh, div and rem exist
+    int mul_latency; // mul and mulh
+    int div_latency; // div and rem
+} Target;
+
+const Target *target_default(void); // rv32im
+
+const Target *target_lookup(const char *name); // NULL if unknown
+void target_list(FILE *file);
+
+// Fails the compilation with a message if the target has no M extension
+void target_require_mul(const Target *target, const char *what);
+
+// Strength reduction of rd = rs op constant. Each emits a sequence using the scratch
+// registers s1 and s2 (which must differ from rd and rs; rd may equal rs) and returns 1,
+// or returns 0 when the plain mul/div/rem instruction is the better choice on the target.
+// With out NULL they only report the choice.
+int target_emit_multiply_imm(Emitter *out, const Target *target, Reg rd, Reg rs, int32_t c, Reg s1, Reg s2);
+int target_emit_divide_imm(Emitter *out, const Target *target, Reg rd, Reg rs, int32_t d, Reg s1, Reg s2);
+int target_emit_remainder_imm(Emitter *out, const Target *target, Reg rd, Reg rs, int32_t d, Reg s1, Reg s2);
+
+#endif
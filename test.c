@@ -1,64 +1,166 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "lexer.h"
 #include "parser.h"
 #include "codegen.h"
+#include "pipeline.h"
+#include "fold.h"
+#include "scan.h"
+
+#define BENCH_TOTAL_BYTES (256u * 1024 * 1024) // Lex at least this much when benchmarking
+
+// Lexes the whole source repeatedly through the pull lexer and reports throughput in MB/s
+static void benchmark_lexer(const Source *source) {
+    size_t runs = source->length ? BENCH_TOTAL_BYTES / source->length : 1;
+    if (runs < 5) runs = 5;
+    if (runs > 100000) runs = 100000;
+
+    size_t tokens_lexed = 0;
+    clock_t start = clock();
+    for (size_t run = 0; run < runs; run++) {
+        Lexer tokens;
+        lexer_init(&tokens, source);
+        while (next_token(&tokens).type != END_OF_TOKENS) {
+            tokens_lexed++;
+        }
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    double megabytes = (double)source->length * (double)runs / (1024.0 * 1024.0);
+
+    printf("Lexer benchmark (%s scan): %lu runs over %lu bytes, %lu tokens per run\n", scan_kernel_name(),
+           (unsigned long)runs, (unsigned long)source->length, (unsigned long)(tokens_lexed / runs));
+    printf("  %.3f s, %.1f MB/s\n", seconds, seconds > 0 ? megabytes / seconds : 0.0);
+}
+
+// Usage: compiler [-O0|-O1|-O2] [--dump=stage,...] [--regalloc=linear|irc] [--target=core] [--unroll=n]
+//                 [--fuel=n] [--bench-lex] [--tokens] [input]
+//   input defaults to test.txt, "-" reads from stdin
+//   -O0         generates code straight from the AST (default)
+//   -O1, -O2    go through the IR and run the passes enabled at that level
+//   --dump=...  prints the IR after the listed stages ("lower", a pass name, "cfg" for the
+//               control-flow analyses, "scev" for the loops' scalar evolution, or "all")
+//   --regalloc  register allocator for the IR path: linear scan (default at -O1) or iterated
+//               register coalescing (default from -O2, slower to compile, fewer copies)
+//   --target    core to generate code for: rv32im (default), rv32im-slowmul or rv32i; decides
+//               when * / % by constants become shift sequences
+//   --unroll    iterations per trip when -O2 unrolls a counted loop (default 4, 1 disables)
+//   --fuel      IR instructions -O2 may run at compile time to precompute the program's output
+//               (default 1000000); the part it does not reach is compiled normally
+//   --bench-lex only measures lexing throughput on the input
+//   --tokens    dumps every token before compiling (lexes the source an extra time)
+int main(int argc, char **argv) {
+    const char *input_file = "test.txt";
+    int bench_lex = 0;
+    int dump_tokens = 0;
+    CompilerOptions options = { 0, NULL, REGALLOC_DEFAULT, target_default(), 0, 0 };
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench-lex") == 0) bench_lex = 1;
+        else if (strcmp(argv[i], "--tokens") == 0) dump_tokens = 1;
+        else if (strncmp(argv[i], "-O", 2) == 0 && argv[i][2] >= '0' && argv[i][2] <= '9') options.opt_level = atoi(argv[i] + 2);
+        else if (strncmp(argv[i], "--dump=", 7) == 0) options.dump = argv[i] + 7;
+        else if (strcmp(argv[i], "--regalloc=linear") == 0) options.regalloc = REGALLOC_LINEAR;
+        else if (strcmp(argv[i], "--regalloc=irc") == 0) options.regalloc = REGALLOC_IRC;
+        else if (strncmp(argv[i], "--unroll=", 9) == 0) options.unroll_factor = atoi(argv[i] + 9);
+        else if (strncmp(argv[i], "--fuel=", 7) == 0) options.fuel = atoi(argv[i] + 7);
+        else if (strncmp(argv[i], "--target=", 9) == 0) {
+            options.target = target_lookup(argv[i] + 9);
+            if (options.target == NULL) {
+                fprintf(stderr, "Error: Unknown target '%s'; known targets: ", argv[i] + 9);
+                target_list(stderr);
+                return EXIT_FAILURE;
+            }
+        }
+        else input_file = argv[i];
+    }
 
-int main() {
     // Open file for reading
-    FILE *file = fopen("test.txt", "rb");
+    FILE *file = strcmp(input_file, "-") == 0 ? stdin : fopen(input_file, "rb");
     if (file == NULL) {
         fprintf(stderr, "Error: Could not open file\n");
         return EXIT_FAILURE;
     }
 
-    // Perform lexical analysis
-    Token *tokens = lexer(file);
-    fclose(file);  // Close the file immediately after tokenization
-    if (tokens == NULL) {
-        fprintf(stderr, "Error: Could not generate tokens\n");
+    // Map the source (or stream it in for pipes/stdin)
+    Source source;
+    int opened = source_open(&source, file);
+    if (file != stdin) {
+        fclose(file);  // The mapping stays valid after the file is closed
+    }
+    if (opened != 0) {
+        fprintf(stderr, "Error: Could not read source\n");
         return EXIT_FAILURE;
     }
+    printf("Source size: %lu bytes (%s)\n", (unsigned long)source.length, source.mapped ? "mapped" : "buffered");
+
+    if (bench_lex) {
+        benchmark_lexer(&source);
+        source_close(&source);
+        intern_reset();
+        return EXIT_SUCCESS;
+    }
+
+    // One arena owns the token dump and codegen metadata of this compilation
+    Arena arena;
+    arena_init(&arena, ARENA_DEFAULT_CHUNK_SIZE);
 
-    printf("Tokens:\n");
-    
-    for (int i = 0;; i++)
-    {
-        print_token(tokens[i]);
-        if (tokens[i].type == END_OF_TOKENS)
+    if (dump_tokens) {
+        // The full token array is only built for the dump; the parser streams its own tokens
+        TokenStream *tokens = lexer(&source, &arena);
+        printf("Tokens:\n");
+        for (size_t i = 0; i < tokens->count; i++)
         {
-            break; // Exit after printing the END_OF_TOKENS marker
+            Token token = token_at(tokens, i);
+            print_token(token);
+            if (token.type == END_OF_TOKENS)
+            {
+                printf("END_OF_TOKENS at index %lu, line number: %lu\n", (unsigned long)i, (unsigned long)token.line_num);
+            }
         }
     }
 
-    // Parse the tokens into an AST
-    Node *ast = parser(tokens);
+    // Lex and parse in a single pass: the parser pulls tokens on demand
+    Lexer tokens;
+    lexer_init(&tokens, &source);
+    Ast *ast = parser(&tokens);
     if (ast == NULL) {
-        free(tokens);
+        arena_destroy(&arena);
+        source_close(&source);
         fprintf(stderr, "Error: Could not generate AST\n");
         return EXIT_FAILURE;
     }
 
+    // Fold constants before either code generator sees the tree
+    fold_constants(ast);
+
     printf("\nAST:\n");
-    print_tree(ast, 0, "root");
+    print_tree(ast, ast->root, 0, "root");
 
     // Generate code from the AST
     char *output_file = "output.asm";
-    int generated_code = generate_code(ast, output_file);
+    int generated_code = options.opt_level > 0 ? compile_ir(ast, output_file, &arena, &options)
+                                               : generate_code(ast, output_file, &arena, options.target);
     if (generated_code != 0) {
         fprintf(stderr, "Error: Code generation failed\n");
         free_tree(ast);
-        free(tokens);
+        arena_destroy(&arena);
+        source_close(&source);
         return EXIT_FAILURE;
     }
 
     printf("\nGenerated Code:\n");
     printf("Code successfully generated: %s\n", output_file);
 
+    print_ast_stats(ast);
+    arena_print_stats(&arena, "Compilation");
+
     // Clean up resources
     free_tree(ast);
-    free(tokens);
+    arena_destroy(&arena);
+    source_close(&source);
+    intern_reset();
 
     return EXIT_SUCCESS;
 }
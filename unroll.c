@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unroll.h"
+#include "cfg.h"
+#include "scev.h"
+
+#define UNROLL_BUDGET 128 // Instructions unrolling may add to one function
+
+static IrFunction *fn = NULL;
+static Operand *renamed = NULL; // Original vreg -> its value in the copy being built, OPND_NONE if unchanged
+
+static Operand rename_operand(Operand operand) {
+    if (operand.kind == OPND_REG && renamed[operand.value].kind != OPND_NONE) return renamed[operand.value];
+    return operand;
+}
+
+// Instructions one more iteration adds: the body and its branch
+static uint32_t iteration_size(uint32_t header) {
+    const IrBlock *block = &fn->blocks[header];
+    uint32_t size = 1;
+    for (uint32_t i = 0; i < block->count; i++) size += block->insts[i].op != IR_PHI;
+    return size;
+}
+
+// Puts a copy of the loop doing `factor` iterations per trip between the preheader and the
+// header. It runs (trip count - 1) / factor trips and then falls into the original loop, which
+// is entered with the copy's values and runs the remaining 1 .. factor iterations; so every
+// value the loop leaves with is still defined in the header. Returns 0 if the loop is too short.
+static int unroll_loop(const Cfg *cfg, const Scev *scev, uint32_t factor) {
+    uint32_t header = cfg->loops[scev->loop].header;
+    uint64_t trips = (scev->trip_count - 1) / factor;
+    if (trips == 0) return 0;
+
+    // The copy leaves when the counter the exit test uses reaches its value in the last
+    // iteration of its last trip. A counter never repeats a value before the loop ends, so
+    // this needs no knowledge of the original comparison.
+    const IrTerm *term = &fn->blocks[header].term;
+    Operand counter = term->a.kind == OPND_REG && scev->values[term->a.value].order == 1 ? term->a : term->b;
+    int32_t last = scev_evaluate(&scev->values[counter.value], trips * factor - 1);
+    Operand bound = ir_imm(last);
+    if (last != 0) {
+        IrInst *copy = ir_append(fn, scev->preheader, IR_COPY);
+        copy->dst = ir_new_vreg(fn);
+        copy->a = bound;
+        bound = ir_reg(copy->dst);
+    }
+
+    uint32_t preheader_index = 0, latch_index = 0;
+    for (uint32_t k = 0; k < fn->blocks[header].pred_count; k++) {
+        if (fn->blocks[header].preds[k] == header) latch_index = k;
+        else preheader_index = k;
+    }
+
+    uint32_t unrolled = ir_new_block(fn);
+    IrBlock *original = &fn->blocks[header];
+    uint32_t phi_count = 0;
+    while (phi_count < original->count && original->insts[phi_count].op == IR_PHI) phi_count++;
+    renamed = arena_calloc(fn->arena, fn->vreg_count, sizeof(Operand));
+    Operand *next = arena_alloc(fn->arena, (phi_count + 1) * sizeof(Operand));
+    for (uint32_t i = 0; i < phi_count; i++) {
+        IrInst *phi = ir_append(fn, unrolled, IR_PHI);
+        phi->dst = ir_new_vreg(fn);
+        phi->arg_count = 2;
+        phi->args = arena_alloc(fn->arena, 2 * sizeof(Operand));
+        phi->args[0] = original->insts[i].args[preheader_index];
+        renamed[original->insts[i].dst] = ir_reg(phi->dst);
+    }
+
+    Operand test = counter;
+    for (uint32_t c = 0; c < factor; c++) {
+        for (uint32_t i = phi_count; i < original->count; i++) {
+            IrInst inst = original->insts[i];
+            VReg dst = inst.dst;
+            inst.a = rename_operand(inst.a);
+            inst.b = rename_operand(inst.b);
+            if (dst != NO_VREG) inst.dst = ir_new_vreg(fn);
+            *ir_append(fn, unrolled, (IrOp)inst.op) = inst;
+            if (dst != NO_VREG) renamed[dst] = ir_reg(inst.dst);
+        }
+        test = rename_operand(counter);
+        // Phis take their values all at once
+        for (uint32_t i = 0; i < phi_count; i++) next[i] = rename_operand(original->insts[i].args[latch_index]);
+        for (uint32_t i = 0; i < phi_count; i++) renamed[original->insts[i].dst] = next[i];
+    }
+
+    IrBlock *block = &fn->blocks[unrolled];
+    for (uint32_t i = 0; i < phi_count; i++) {
+        block->insts[i].args[1] = next[i];
+        original->insts[i].args[preheader_index] = next[i];
+    }
+    ir_set_branch(fn, unrolled, IR_SNE, test, bound, unrolled, header);
+    block->preds = arena_alloc(fn->arena, 2 * sizeof(uint32_t));
+    block->preds[0] = scev->preheader;
+    block->preds[1] = unrolled;
+    block->pred_count = 2;
+    original->preds[preheader_index] = unrolled;
+    IrTerm *entry = &fn->blocks[scev->preheader].term;
+    for (int i = 0; i < 2; i++) {
+        if (entry->target[i] == header) entry->target[i] = unrolled;
+    }
+    renamed = NULL;
+    return 1;
+}
+
+// A loop worth unrolling: innermost, one block, entered from a preheader that only leads to it,
+// and with a known trip count
+static int is_counted(const Cfg *cfg, const Scev *scev) {
+    const Loop *info = &cfg->loops[scev->loop];
+    uint32_t succs[2];
+    if (info->block_count != 1 || scev->trip_count == 0 || scev->preheader == NO_BLOCK) return 0;
+    return ir_successors(&fn->blocks[scev->preheader], succs) == 1;
+}
+
+// --- Pass ---
+
+// Runs on SSA form after licm, so loop-invariant code and constants are already out of the
+// body and are not copied. Loops are unrolled while the instructions added stay within
+// UNROLL_BUDGET; the factor is lowered for a loop that does not fit at the full factor.
+void unroll_loops(IrFunction *function, const CompilerOptions *options) {
+    fn = function;
+    Arena *arena = fn->arena;
+    uint32_t factor = options->unroll_factor > 0 ? (uint32_t)options->unroll_factor : UNROLL_DEFAULT_FACTOR;
+    Cfg *cfg = cfg_build(fn, arena);
+    cfg_compute_loops(cfg, arena);
+
+    // Headers of the loops to unroll. Unrolling only adds a block in front of a header, so the
+    // other loops keep their headers, but the Cfg is rebuilt before each one.
+    uint32_t *headers = arena_alloc(arena, (cfg->loop_count + 1) * sizeof(uint32_t));
+    uint32_t header_count = 0;
+    for (uint32_t l = 0; l < cfg->loop_count; l++) {
+        Scev *scev = scev_analyze(fn, cfg, l, arena);
+        if (should_dump(options, "scev")) scev_dump(scev, fn, cfg, stdout);
+        if (factor > 1 && is_counted(cfg, scev)) headers[header_count++] = cfg->loops[l].header;
+    }
+
+    uint32_t budget = UNROLL_BUDGET;
+    int changed = 0;
+    for (uint32_t h = 0; h < header_count; h++) {
+        uint32_t size = iteration_size(headers[h]);
+        uint32_t loop_factor = factor;
+        while (loop_factor > 1 && loop_factor * size > budget) loop_factor--;
+        if (loop_factor < 2) continue;
+        if (changed) {
+            cfg = cfg_build(fn, arena);
+            cfg_compute_loops(cfg, arena);
+        }
+        Scev *scev = scev_analyze(fn, cfg, cfg->innermost_loop[headers[h]], arena);
+        if (!unroll_loop(cfg, scev, loop_factor)) continue;
+        budget -= loop_factor * size;
+        changed = 1;
+    }
+    fn = NULL;
+}
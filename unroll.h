@@ -0,0 +1,15 @@
+#ifndef UNROLL_H_
+#define UNROLL_H_
+
+#include "ir.h"
+#include "pipeline.h"
+
+#define UNROLL_DEFAULT_FACTOR 4
+
+// Unrolling of counted loops over SSA form. A single-block loop whose trip count scalar
+// evolution finds runs as an unrolled copy doing `factor` iterations per trip, followed by the
+// original loop as the remainder loop for the last 1 .. factor iterations.
+
+void unroll_loops(IrFunction *fn, const CompilerOptions *options);
+
+#endif